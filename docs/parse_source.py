@@ -23,6 +23,8 @@ header_files = [
     "../src/game_api/entity_structs.hpp",
     "../src/game_api/movable.hpp",
     "../src/game_api/movable_behavior.hpp",
+    "../src/game_api/entity_snapshot.hpp",
+    "../src/game_api/entity_change_feed.hpp",
     "../src/game_api/game_manager.hpp",
     "../src/game_api/state.hpp",
     "../src/game_api/state_structs.hpp",
@@ -75,6 +77,8 @@ api_files = [
     "../src/game_api/script/usertypes/game_manager_lua.cpp",
     "../src/game_api/script/usertypes/prng_lua.cpp",
     "../src/game_api/script/usertypes/entity_lua.cpp",
+    "../src/game_api/script/usertypes/entity_snapshot_lua.cpp",
+    "../src/game_api/script/usertypes/entity_change_feed_lua.cpp",
     "../src/game_api/script/usertypes/entities_chars_lua.cpp",
     "../src/game_api/script/usertypes/entities_floors_lua.cpp",
     "../src/game_api/script/usertypes/entities_activefloors_lua.cpp",
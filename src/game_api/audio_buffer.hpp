@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 
@@ -14,6 +15,26 @@ enum class SoundFormat
     PCM_DOUBLE
 };
 
+inline std::size_t bytes_per_sample(SoundFormat format)
+{
+    switch (format)
+    {
+    case SoundFormat::PCM_8:
+        return 1;
+    case SoundFormat::PCM_16:
+        return 2;
+    case SoundFormat::PCM_24:
+        return 3;
+    case SoundFormat::PCM_32:
+    case SoundFormat::PCM_FLOAT:
+        return 4;
+    case SoundFormat::PCM_64:
+    case SoundFormat::PCM_DOUBLE:
+        return 8;
+    }
+    return 0;
+}
+
 struct DecodedAudioBuffer
 {
     std::int32_t num_channels;
@@ -24,3 +45,28 @@ struct DecodedAudioBuffer
 };
 
 using DecodeAudioFile = DecodedAudioBuffer(const char* file_path);
+
+class AudioStream
+{
+  public:
+    virtual ~AudioStream() = default;
+
+    virtual std::int32_t num_channels() const = 0;
+    virtual std::int32_t frequency() const = 0;
+    virtual SoundFormat format() const = 0;
+    /// Total size of the decoded PCM data in bytes
+    virtual std::size_t data_size() const = 0;
+
+    /// Size of one sample for every channel in bytes
+    std::size_t frame_size() const
+    {
+        return bytes_per_sample(format()) * static_cast<std::size_t>(num_channels());
+    }
+
+    /// Decodes up to `size` bytes of PCM data into `out`, returns the number of bytes written, which is only less than `size` at the end of the stream
+    virtual std::size_t read(std::byte* out, std::size_t size) = 0;
+    /// Continues decoding at sample frame `frame`, fails if that is past the end of the stream
+    virtual bool seek(std::size_t frame) = 0;
+};
+
+using OpenAudioStream = std::unique_ptr<AudioStream>(const char* file_path);
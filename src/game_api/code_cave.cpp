@@ -0,0 +1,363 @@
+#include "code_cave.hpp"
+
+#include <Windows.h> // for VirtualAlloc, VirtualFree, VirtualProtect, ...
+#include <cstdint>   // for INT32_MIN, INT32_MAX
+#include <cstring>   // for memcpy
+#include <iterator>  // for prev
+#include <map>       // for map
+#include <mutex>     // for mutex, lock_guard
+#include <set>       // for set
+
+#include "logger.h"   // for DEBUG
+#include "memory.hpp" // for Memory
+
+namespace
+{
+constexpr size_t g_page_size{0x1000};
+constexpr size_t g_alignment{0x10};
+constexpr size_t g_cave_size{0x1000000};
+// Keep the cave within 1 GiB below the exe, so any address in the exe stays well within rel32 range
+constexpr size_t g_max_cave_distance{0x40000000};
+
+struct CodeCaveAllocation
+{
+    size_t size;
+    CodeCaveKind kind;
+    bool fallback;
+    // Set once a batch that wrote this code ended, from then on it may be running
+    bool published{false};
+};
+
+struct CodeCave
+{
+    std::mutex lock;
+    bool initialized{false};
+    size_t base{0};
+    // Uncommitted parts of the reserved region, address -> size
+    std::map<size_t, size_t> free_pages;
+    // Free parts of committed pages, indexed by CodeCaveKind, address -> size
+    std::map<size_t, size_t> free_chunks[2];
+    // Ordered, so the allocations on a page can be found when deciding if it has to stay executable
+    std::map<size_t, CodeCaveAllocation> allocations;
+    CodeCaveStats stats;
+};
+CodeCave g_code_cave;
+
+struct CodeCaveWriteBatchState
+{
+    uint32_t depth{0};
+    std::set<size_t> pages;
+    // Allocations written to during the batch, published when it ends
+    std::set<size_t> allocations;
+};
+thread_local CodeCaveWriteBatchState g_write_batch;
+
+size_t round_up(size_t i, size_t div)
+{
+    return ((i + div - 1) / div) * div;
+}
+
+// Inserts a free range, merging it with adjacent ranges, and returns the merged range
+std::map<size_t, size_t>::iterator insert_free_range(std::map<size_t, size_t>& ranges, size_t address, size_t size)
+{
+    auto next = ranges.lower_bound(address);
+    if (next != ranges.end() && address + size == next->first)
+    {
+        size += next->second;
+        next = ranges.erase(next);
+    }
+    if (next != ranges.begin())
+    {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second == address)
+        {
+            prev->second += size;
+            return prev;
+        }
+    }
+    return ranges.emplace_hint(next, address, size);
+}
+// First fit, returns 0 if no range is big enough
+size_t take_free_range(std::map<size_t, size_t>& ranges, size_t size)
+{
+    for (auto it = ranges.begin(); it != ranges.end(); ++it)
+    {
+        if (it->second >= size)
+        {
+            const size_t address = it->first;
+            const size_t remaining = it->second - size;
+            it = ranges.erase(it);
+            if (remaining != 0)
+            {
+                ranges.emplace_hint(it, address + size, remaining);
+            }
+            return address;
+        }
+    }
+    return 0;
+}
+
+DWORD get_page_protection(CodeCaveKind kind)
+{
+    return kind == CodeCaveKind::Code ? PAGE_EXECUTE_READ : PAGE_READWRITE;
+}
+
+void reserve_cave(CodeCave& cave)
+{
+    const size_t exe = Memory::get().exe_ptr;
+    for (size_t distance = g_cave_size; distance <= g_max_cave_distance && distance <= exe; distance += 0x100000)
+    {
+        if (LPVOID memory = VirtualAlloc((LPVOID)(exe - distance), g_cave_size, MEM_RESERVE, PAGE_NOACCESS))
+        {
+            cave.base = (size_t)memory;
+            cave.free_pages.emplace(cave.base, g_cave_size);
+            cave.stats.reserved_size = g_cave_size;
+            return;
+        }
+    }
+    DEBUG("Could not reserve code cave, falling back to single allocations");
+}
+
+bool is_rel32_reachable(size_t from, size_t to)
+{
+    const auto distance = static_cast<int64_t>(to - from);
+    return distance >= INT32_MIN && distance <= INT32_MAX;
+}
+
+// Returns the allocation containing `address`, or `end()`
+std::map<size_t, CodeCaveAllocation>::iterator find_allocation(CodeCave& cave, size_t address)
+{
+    auto it = cave.allocations.upper_bound(address);
+    if (it == cave.allocations.begin())
+    {
+        return cave.allocations.end();
+    }
+    --it;
+    return address < it->first + it->second.size ? it : cave.allocations.end();
+}
+// True if the page holds code that may be running, the caller must hold the lock
+bool page_has_published_code(CodeCave& cave, size_t page)
+{
+    auto it = cave.allocations.upper_bound(page);
+    if (it != cave.allocations.begin())
+    {
+        --it;
+    }
+    for (; it != cave.allocations.end() && it->first < page + g_page_size; ++it)
+    {
+        const auto& [address, allocation] = *it;
+        if (address + allocation.size > page && allocation.kind == CodeCaveKind::Code && allocation.published)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Probes for free pages within rel32 range of `near_addr`, below the exe
+LPVOID alloc_rel32_pages(size_t near_addr, size_t size, DWORD protect)
+{
+    const size_t limit_addr = Memory::get().exe_ptr;
+    size_t test_addr = near_addr + 0x10000; // dunno why
+    if (test_addr <= INT32_MAX)
+        test_addr = 8;
+    else
+        test_addr -= INT32_MAX;
+
+    for (; test_addr < limit_addr; test_addr += 0x100000)
+    {
+        if (LPVOID memory = VirtualAlloc((LPVOID)test_addr, size, MEM_COMMIT | MEM_RESERVE, protect))
+            return memory;
+    }
+    return nullptr;
+}
+} // namespace
+
+void* code_cave_alloc(CodeCaveKind kind, size_t size, size_t near_addr)
+{
+    size = round_up(size == 0 ? 1 : size, g_alignment);
+
+    std::lock_guard lock{g_code_cave.lock};
+    if (!g_code_cave.initialized)
+    {
+        g_code_cave.initialized = true;
+        reserve_cave(g_code_cave);
+    }
+
+    const bool cave_reachable = g_code_cave.base != 0 &&
+                                (near_addr == 0 || (is_rel32_reachable(near_addr, g_code_cave.base) && is_rel32_reachable(near_addr, g_code_cave.base + g_cave_size)));
+    size_t address = 0;
+    if (cave_reachable)
+    {
+        auto& chunks = g_code_cave.free_chunks[static_cast<size_t>(kind)];
+        address = take_free_range(chunks, size);
+        if (address == 0)
+        {
+            const size_t pages_size = round_up(size, g_page_size);
+            if (const size_t pages = take_free_range(g_code_cave.free_pages, pages_size))
+            {
+                if (VirtualAlloc((LPVOID)pages, pages_size, MEM_COMMIT, get_page_protection(kind)))
+                {
+                    g_code_cave.stats.committed_size += pages_size;
+                    insert_free_range(chunks, pages, pages_size);
+                    address = take_free_range(chunks, size);
+                }
+                else
+                {
+                    insert_free_range(g_code_cave.free_pages, pages, pages_size);
+                }
+            }
+        }
+    }
+
+    bool fallback = false;
+    if (address == 0)
+    {
+        LPVOID memory = near_addr != 0
+                            ? alloc_rel32_pages(near_addr, size, get_page_protection(kind))
+                            : VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, get_page_protection(kind));
+        if (memory == nullptr)
+        {
+            return nullptr;
+        }
+        address = (size_t)memory;
+        fallback = true;
+        g_code_cave.stats.fallback_allocations++;
+    }
+
+    g_code_cave.allocations[address] = CodeCaveAllocation{size, kind, fallback, false};
+    g_code_cave.stats.allocations++;
+    g_code_cave.stats.live_allocations++;
+    (kind == CodeCaveKind::Code ? g_code_cave.stats.used_code_size : g_code_cave.stats.used_data_size) += size;
+    return (void*)address;
+}
+
+void code_cave_free(void* memory)
+{
+    if (memory == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard lock{g_code_cave.lock};
+    auto it = g_code_cave.allocations.find((size_t)memory);
+    if (it == g_code_cave.allocations.end())
+    {
+        DEBUG("Freeing memory that was not allocated from the code cave: {}", memory);
+        return;
+    }
+
+    const size_t size = it->second.size;
+    const CodeCaveKind kind = it->second.kind;
+    const bool fallback = it->second.fallback;
+    g_code_cave.allocations.erase(it);
+    g_code_cave.stats.frees++;
+    g_code_cave.stats.live_allocations--;
+    (kind == CodeCaveKind::Code ? g_code_cave.stats.used_code_size : g_code_cave.stats.used_data_size) -= size;
+
+    if (fallback)
+    {
+        VirtualFree(memory, 0, MEM_RELEASE);
+        return;
+    }
+
+    auto& chunks = g_code_cave.free_chunks[static_cast<size_t>(kind)];
+    const auto merged = insert_free_range(chunks, (size_t)memory, size);
+
+    // Decommit pages that are now completely unused, so they can be handed out for either kind again
+    const size_t range_begin = merged->first;
+    const size_t range_end = merged->first + merged->second;
+    const size_t pages_begin = round_up(range_begin, g_page_size);
+    const size_t pages_end = range_end & ~(g_page_size - 1);
+    if (pages_begin < pages_end)
+    {
+        chunks.erase(merged);
+        if (range_begin < pages_begin)
+            chunks.emplace(range_begin, pages_begin - range_begin);
+        if (pages_end < range_end)
+            chunks.emplace(pages_end, range_end - pages_end);
+
+        VirtualFree((LPVOID)pages_begin, pages_end - pages_begin, MEM_DECOMMIT);
+        g_code_cave.stats.committed_size -= pages_end - pages_begin;
+        insert_free_range(g_code_cave.free_pages, pages_begin, pages_end - pages_begin);
+    }
+}
+
+void code_cave_write(void* destination, std::string_view code)
+{
+    CodeCaveWriteBatch batch;
+
+    std::lock_guard lock{g_code_cave.lock};
+    const auto allocation = find_allocation(g_code_cave, (size_t)destination);
+    const size_t allocation_address = allocation != g_code_cave.allocations.end() ? allocation->first : 0;
+    if (allocation_address != 0)
+    {
+        g_write_batch.allocations.insert(allocation_address);
+    }
+
+    const size_t pages_begin = (size_t)destination & ~(g_page_size - 1);
+    const size_t pages_end = round_up((size_t)destination + code.size(), g_page_size);
+    for (size_t page = pages_begin; page < pages_end; page += g_page_size)
+    {
+        if (g_write_batch.pages.insert(page).second)
+        {
+            // Code from an earlier batch on the same page may be running right now, only then does the page have to stay executable while we write
+            const bool keep_executable = allocation_address == 0 || page_has_published_code(g_code_cave, page);
+            DWORD old_protect;
+            VirtualProtect((LPVOID)page, g_page_size, keep_executable ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE, &old_protect);
+            g_code_cave.stats.protection_changes++;
+            if (keep_executable)
+            {
+                g_code_cave.stats.writable_executable_pages++;
+            }
+        }
+    }
+    memcpy(destination, code.data(), code.size());
+}
+
+CodeCaveWriteBatch::CodeCaveWriteBatch()
+{
+    g_write_batch.depth++;
+}
+CodeCaveWriteBatch::~CodeCaveWriteBatch()
+{
+    if (--g_write_batch.depth != 0)
+    {
+        return;
+    }
+
+    uint64_t protection_changes = 0;
+    auto it = g_write_batch.pages.begin();
+    while (it != g_write_batch.pages.end())
+    {
+        const size_t first_page = *it;
+        size_t end_page = first_page + g_page_size;
+        for (++it; it != g_write_batch.pages.end() && *it == end_page; ++it)
+        {
+            end_page += g_page_size;
+        }
+
+        DWORD old_protect;
+        VirtualProtect((LPVOID)first_page, end_page - first_page, PAGE_EXECUTE_READ, &old_protect);
+        FlushInstructionCache(GetCurrentProcess(), (LPCVOID)first_page, end_page - first_page);
+        protection_changes++;
+    }
+    g_write_batch.pages.clear();
+
+    std::lock_guard lock{g_code_cave.lock};
+    g_code_cave.stats.protection_changes += protection_changes;
+    for (size_t address : g_write_batch.allocations)
+    {
+        if (auto allocation = g_code_cave.allocations.find(address); allocation != g_code_cave.allocations.end())
+        {
+            allocation->second.published = true;
+        }
+    }
+    g_write_batch.allocations.clear();
+}
+
+CodeCaveStats get_code_cave_stats()
+{
+    std::lock_guard lock{g_code_cave.lock};
+    return g_code_cave.stats;
+}
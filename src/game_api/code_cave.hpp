@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>     // for size_t
+#include <cstdint>     // for uint64_t
+#include <string_view> // for string_view
+
+enum class CodeCaveKind
+{
+    /// Read-write pages, for data the game addresses through rel32 operands
+    Data,
+    /// Executable pages, new code is written while its pages are not executable unless other code on them is already in use
+    Code,
+};
+
+struct CodeCaveStats
+{
+    size_t reserved_size{0};
+    size_t committed_size{0};
+    size_t used_data_size{0};
+    size_t used_code_size{0};
+    size_t live_allocations{0};
+    uint64_t allocations{0};
+    uint64_t frees{0};
+    /// Allocations that did not fit into the cave or were out of rel32 range and got their own pages
+    uint64_t fallback_allocations{0};
+    uint64_t protection_changes{0};
+    /// Pages that had to be writable and executable at once, because they already held code that may be running
+    uint64_t writable_executable_pages{0};
+};
+
+/// Allocates `size` bytes from the cave reserved next to the exe, aligned to 16 bytes.
+/// If `near_addr` is not 0 the result is guaranteed to be reachable with a rel32 operand at `near_addr`.
+/// Returns `nullptr` if that is not possible.
+void* code_cave_alloc(CodeCaveKind kind, size_t size, size_t near_addr = 0);
+/// Releases memory returned by `code_cave_alloc`, `nullptr` is ignored
+void code_cave_free(void* memory);
+
+/// Copies `code` into memory from a `CodeCaveKind::Code` allocation, switching its pages to writable for the duration of the current `CodeCaveWriteBatch`.
+/// Pages only stay executable while writing if they hold code from an earlier batch, which may be running on another thread.
+void code_cave_write(void* destination, std::string_view code);
+
+/// Groups writes to code pages, so each page is made writable once and turned executable again when the outermost batch ends.
+/// Code written during a batch must not run before the batch ends.
+class CodeCaveWriteBatch
+{
+  public:
+    CodeCaveWriteBatch();
+    ~CodeCaveWriteBatch();
+
+    CodeCaveWriteBatch(const CodeCaveWriteBatch&) = delete;
+    CodeCaveWriteBatch& operator=(const CodeCaveWriteBatch&) = delete;
+};
+
+CodeCaveStats get_code_cave_stats();
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <algorithm> // for max
+#include <bit>       // for bit_ceil
+#include <cstddef>   // for size_t
+#include <cstdint>   // for uintptr_t, uint64_t
+#include <utility>   // for exchange, move
+#include <vector>    // for vector
+
+// Open addressing hash map keyed by pointers, meant for lookups on hot paths that mostly miss.
+// A miss usually ends on the first probe, unlike std::unordered_map it never chases a node pointer.
+// Inserting may move values, so references into the map are only valid until the next insertion.
+template <class KeyT, class ValueT>
+class FlatPointerMap
+{
+  public:
+    bool empty() const
+    {
+        return m_Size == 0;
+    }
+    size_t size() const
+    {
+        return m_Size;
+    }
+
+    ValueT* find(const KeyT* key)
+    {
+        const size_t index = find_index(key);
+        return index != c_NoIndex ? &m_Slots[index].value : nullptr;
+    }
+    const ValueT* find(const KeyT* key) const
+    {
+        const size_t index = find_index(key);
+        return index != c_NoIndex ? &m_Slots[index].value : nullptr;
+    }
+    bool contains(const KeyT* key) const
+    {
+        return find_index(key) != c_NoIndex;
+    }
+
+    ValueT& operator[](KeyT* key)
+    {
+        if (const size_t index = find_index(key); index != c_NoIndex)
+        {
+            return m_Slots[index].value;
+        }
+
+        // Stay below 3/4 load, counting tombstones, so every probe sequence reaches an empty slot
+        if ((m_Size + m_Tombstones + 1) * 4 > m_Slots.size() * 3)
+        {
+            rehash(std::max<size_t>(16, std::bit_ceil((m_Size + 1) * 2)));
+        }
+
+        const size_t mask = m_Slots.size() - 1;
+        size_t index = hash(key) & mask;
+        while (m_Slots[index].key != nullptr && m_Slots[index].key != tombstone())
+        {
+            index = (index + 1) & mask;
+        }
+        if (m_Slots[index].key == tombstone())
+        {
+            m_Tombstones--;
+        }
+        m_Slots[index].key = key;
+        m_Size++;
+        return m_Slots[index].value;
+    }
+
+    bool erase(const KeyT* key)
+    {
+        const size_t index = find_index(key);
+        if (index == c_NoIndex)
+        {
+            return false;
+        }
+        m_Slots[index].key = tombstone();
+        m_Slots[index].value = ValueT{};
+        m_Size--;
+        m_Tombstones++;
+        return true;
+    }
+
+    template <class FunT>
+    void for_each(FunT&& fun)
+    {
+        for (Slot& slot : m_Slots)
+        {
+            if (slot.key != nullptr && slot.key != tombstone())
+            {
+                fun(slot.key, slot.value);
+            }
+        }
+    }
+
+  private:
+    struct Slot
+    {
+        KeyT* key{nullptr};
+        ValueT value{};
+    };
+
+    static constexpr size_t c_NoIndex{~size_t{0}};
+
+    static KeyT* tombstone()
+    {
+        return reinterpret_cast<KeyT*>(uintptr_t{1});
+    }
+    static size_t hash(const KeyT* key)
+    {
+        // Objects are at least 16 byte aligned, mix the remaining bits so neighbouring objects spread out
+        uint64_t bits = reinterpret_cast<uintptr_t>(key) >> 4;
+        bits *= 0x9e3779b97f4a7c15ull;
+        return static_cast<size_t>(bits ^ (bits >> 32));
+    }
+
+    size_t find_index(const KeyT* key) const
+    {
+        if (m_Size == 0)
+        {
+            return c_NoIndex;
+        }
+
+        const size_t mask = m_Slots.size() - 1;
+        for (size_t index = hash(key) & mask;; index = (index + 1) & mask)
+        {
+            const KeyT* slot_key = m_Slots[index].key;
+            if (slot_key == key)
+            {
+                return index;
+            }
+            if (slot_key == nullptr)
+            {
+                return c_NoIndex;
+            }
+        }
+    }
+
+    void rehash(size_t capacity)
+    {
+        std::vector<Slot> old_slots = std::exchange(m_Slots, std::vector<Slot>(capacity));
+        m_Size = 0;
+        m_Tombstones = 0;
+        for (Slot& slot : old_slots)
+        {
+            if (slot.key != nullptr && slot.key != tombstone())
+            {
+                (*this)[slot.key] = std::move(slot.value);
+            }
+        }
+    }
+
+    std::vector<Slot> m_Slots;
+    size_t m_Size{0};
+    size_t m_Tombstones{0};
+};
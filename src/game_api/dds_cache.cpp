@@ -0,0 +1,303 @@
+#include "dds_cache.hpp"
+
+#include <Windows.h>     // for CreateFileW, CreateFileMappingW, MapViewOfFile, ...
+#include <algorithm>     // for min_element
+#include <chrono>        // for file_clock
+#include <cstring>       // for memcpy
+#include <filesystem>    // for path, directory_iterator, last_write_time, ...
+#include <fmt/format.h>  // for format
+#include <fstream>       // for ofstream
+#include <mutex>         // for mutex, lock_guard
+#include <new>           // for operator new
+#include <system_error>  // for error_code
+#include <unordered_map> // for unordered_map
+#include <utility>       // for move
+
+#include "logger.h" // for DEBUG
+#include "util.hpp" // for OnScopeExit
+
+namespace
+{
+constexpr char g_cache_magic[4]{'O', 'L', 'D', 'C'};
+constexpr uint32_t g_cache_version{1};
+constexpr std::string_view g_cache_extension{".oldds"};
+
+struct DdsCacheFileHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint64_t content_hash;
+    uint64_t data_size;
+};
+
+struct DdsCacheEntry
+{
+    size_t size;
+    std::filesystem::file_time_type last_use;
+};
+
+struct DdsCache
+{
+    std::mutex lock;
+    std::filesystem::path directory;
+    size_t max_size{0};
+    size_t total_size{0};
+    std::unordered_map<std::string, DdsCacheEntry> entries;
+    DdsCacheStats stats;
+};
+DdsCache g_dds_cache;
+
+std::string cache_file_name(const DdsCacheKey& key)
+{
+    uint64_t name_hash = hash_bytes(key.source_path.data(), key.source_path.size());
+    name_hash = hash_bytes(&key.source_size, sizeof(key.source_size), name_hash);
+    name_hash = hash_bytes(&key.source_mtime, sizeof(key.source_mtime), name_hash);
+    name_hash = hash_bytes(&key.variant, sizeof(key.variant), name_hash);
+    return fmt::format("{:016x}{}", name_hash, g_cache_extension);
+}
+
+void evict_to_fit(DdsCache& cache, size_t incoming_size)
+{
+    while (!cache.entries.empty() && cache.total_size + incoming_size > cache.max_size)
+    {
+        auto oldest = std::min_element(cache.entries.begin(), cache.entries.end(), [](const auto& lhs, const auto& rhs)
+                                       { return lhs.second.last_use < rhs.second.last_use; });
+
+        std::error_code ec;
+        std::filesystem::remove(cache.directory / oldest->first, ec);
+        cache.total_size -= oldest->second.size;
+        cache.entries.erase(oldest);
+        cache.stats.evictions++;
+    }
+}
+} // namespace
+
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed)
+{
+    // FNV-1a, processing eight bytes per round for the bulk of the data
+    constexpr uint64_t prime = 0x100000001b3ull;
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, bytes + i, sizeof(word));
+        hash = (hash ^ word) * prime;
+    }
+    for (; i < size; ++i)
+    {
+        hash = (hash ^ bytes[i]) * prime;
+    }
+    return hash;
+}
+
+void set_dds_cache_directory(std::string directory, size_t max_size)
+{
+    std::lock_guard lock{g_dds_cache.lock};
+
+    g_dds_cache.entries.clear();
+    g_dds_cache.total_size = 0;
+    g_dds_cache.max_size = max_size;
+    g_dds_cache.directory = std::move(directory);
+    if (g_dds_cache.directory.empty())
+    {
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(g_dds_cache.directory, ec);
+    if (ec)
+    {
+        DEBUG("Could not create texture cache directory {}: {}", g_dds_cache.directory.string(), ec.message());
+        g_dds_cache.directory.clear();
+        return;
+    }
+
+    for (const auto& file : std::filesystem::directory_iterator{g_dds_cache.directory, ec})
+    {
+        if (file.is_regular_file() && file.path().extension() == g_cache_extension)
+        {
+            const size_t size = static_cast<size_t>(file.file_size());
+            g_dds_cache.entries[file.path().filename().string()] = DdsCacheEntry{size, file.last_write_time()};
+            g_dds_cache.total_size += size;
+        }
+    }
+    evict_to_fit(g_dds_cache, 0);
+}
+bool is_dds_cache_enabled()
+{
+    std::lock_guard lock{g_dds_cache.lock};
+    return !g_dds_cache.directory.empty();
+}
+
+std::optional<DdsCacheKey> make_dds_cache_key(std::string_view source_path, const std::vector<char>& source_data, uint32_t variant)
+{
+    std::error_code ec;
+    const auto mtime = std::filesystem::last_write_time(source_path, ec);
+    if (ec)
+    {
+        return std::nullopt;
+    }
+
+    return DdsCacheKey{
+        .source_path = std::string{source_path},
+        .source_size = source_data.size(),
+        .source_mtime = static_cast<int64_t>(mtime.time_since_epoch().count()),
+        .content_hash = hash_bytes(source_data.data(), source_data.size()),
+        .variant = variant,
+    };
+}
+
+FileInfo* dds_cache_load(const DdsCacheKey& key, AllocFun alloc_fun)
+{
+    std::lock_guard lock{g_dds_cache.lock};
+    if (g_dds_cache.directory.empty())
+    {
+        return nullptr;
+    }
+
+    const std::string file_name = cache_file_name(key);
+    auto it = g_dds_cache.entries.find(file_name);
+    if (it == g_dds_cache.entries.end())
+    {
+        g_dds_cache.stats.misses++;
+        return nullptr;
+    }
+
+    const std::filesystem::path file_path = g_dds_cache.directory / file_name;
+    HANDLE file = CreateFileW(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        g_dds_cache.total_size -= it->second.size;
+        g_dds_cache.entries.erase(it);
+        g_dds_cache.stats.misses++;
+        return nullptr;
+    }
+    auto close_file = OnScopeExit{[file]()
+                                  { CloseHandle(file); }};
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping == nullptr)
+    {
+        g_dds_cache.stats.misses++;
+        return nullptr;
+    }
+    auto close_mapping = OnScopeExit{[mapping]()
+                                     { CloseHandle(mapping); }};
+
+    const void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr)
+    {
+        g_dds_cache.stats.misses++;
+        return nullptr;
+    }
+    auto unmap_view = OnScopeExit{[view]()
+                                  { UnmapViewOfFile(view); }};
+
+    const auto* header = static_cast<const DdsCacheFileHeader*>(view);
+    const bool valid = it->second.size >= sizeof(DdsCacheFileHeader) &&
+                       memcmp(header->magic, g_cache_magic, sizeof(g_cache_magic)) == 0 &&
+                       header->version == g_cache_version &&
+                       header->source_size == key.source_size &&
+                       header->source_mtime == key.source_mtime &&
+                       header->content_hash == key.content_hash &&
+                       header->data_size == it->second.size - sizeof(DdsCacheFileHeader);
+    if (!valid)
+    {
+        g_dds_cache.stats.misses++;
+        return nullptr;
+    }
+
+    const size_t data_size = static_cast<size_t>(header->data_size);
+    const size_t allocation_size = sizeof(FileInfo) + data_size;
+    auto file_buffer = static_cast<char*>(alloc_fun(allocation_size));
+    if (file_buffer == nullptr)
+    {
+        return nullptr;
+    }
+
+    FileInfo* file_info = new (file_buffer) FileInfo{};
+    file_info->Data = file_buffer + sizeof(FileInfo);
+    file_info->DataSize = static_cast<int>(data_size);
+    file_info->AllocationSize = static_cast<int>(allocation_size);
+    memcpy(file_info->Data, header + 1, data_size);
+
+    // Bump the write time so the LRU order survives restarts
+    std::error_code ec;
+    it->second.last_use = std::filesystem::file_time_type::clock::now();
+    std::filesystem::last_write_time(file_path, it->second.last_use, ec);
+    g_dds_cache.stats.hits++;
+
+    return file_info;
+}
+
+void dds_cache_store(const DdsCacheKey& key, const void* dds_data, size_t dds_size)
+{
+    std::lock_guard lock{g_dds_cache.lock};
+    if (g_dds_cache.directory.empty())
+    {
+        return;
+    }
+
+    const size_t file_size = sizeof(DdsCacheFileHeader) + dds_size;
+    if (file_size > g_dds_cache.max_size)
+    {
+        return;
+    }
+
+    const std::string file_name = cache_file_name(key);
+    if (auto it = g_dds_cache.entries.find(file_name); it != g_dds_cache.entries.end())
+    {
+        g_dds_cache.total_size -= it->second.size;
+        g_dds_cache.entries.erase(it);
+    }
+    evict_to_fit(g_dds_cache, file_size);
+
+    const DdsCacheFileHeader header{
+        .magic = {g_cache_magic[0], g_cache_magic[1], g_cache_magic[2], g_cache_magic[3]},
+        .version = g_cache_version,
+        .source_size = key.source_size,
+        .source_mtime = key.source_mtime,
+        .content_hash = key.content_hash,
+        .data_size = dds_size,
+    };
+
+    // Write to a temporary file first so a crash never leaves a truncated blob behind
+    const std::filesystem::path file_path = g_dds_cache.directory / file_name;
+    std::filesystem::path temp_path = file_path;
+    temp_path += ".tmp";
+    {
+        std::ofstream out(temp_path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(static_cast<const char*>(dds_data), static_cast<std::streamsize>(dds_size));
+        if (!out)
+        {
+            DEBUG("Could not write texture cache file {}", temp_path.string());
+            return;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temp_path, file_path, ec);
+    if (ec)
+    {
+        std::filesystem::remove(temp_path, ec);
+        return;
+    }
+
+    g_dds_cache.entries[file_name] = DdsCacheEntry{file_size, std::filesystem::file_time_type::clock::now()};
+    g_dds_cache.total_size += file_size;
+    g_dds_cache.stats.stores++;
+}
+
+DdsCacheStats get_dds_cache_stats()
+{
+    std::lock_guard lock{g_dds_cache.lock};
+    DdsCacheStats stats = g_dds_cache.stats;
+    stats.total_size = g_dds_cache.total_size;
+    stats.max_size = g_dds_cache.max_size;
+    return stats;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>     // for size_t
+#include <cstdint>     // for uint64_t, int64_t
+#include <optional>    // for optional
+#include <string>      // for string
+#include <string_view> // for string_view
+#include <vector>      // for vector
+
+#include "file_api.hpp" // for AllocFun, FileInfo
+
+struct DdsCacheStats
+{
+    uint64_t hits{0};
+    uint64_t misses{0};
+    uint64_t stores{0};
+    uint64_t evictions{0};
+    size_t total_size{0};
+    size_t max_size{0};
+};
+
+struct DdsCacheKey
+{
+    std::string source_path;
+    uint64_t source_size;
+    int64_t source_mtime;
+    uint64_t content_hash;
+    /// Selects between different outputs produced from the same source, e.g. different pixel formats
+    uint32_t variant{0};
+};
+
+/// Enables the decoded-image cache, storing DDS blobs in `directory` and evicting least recently used blobs once `max_size` bytes are exceeded.
+/// Passing an empty directory disables the cache.
+void set_dds_cache_directory(std::string directory, size_t max_size);
+bool is_dds_cache_enabled();
+
+/// Hashes `source_data`, which must be the full contents of the file at `source_path`, and stats the file for its size and modification time
+std::optional<DdsCacheKey> make_dds_cache_key(std::string_view source_path, const std::vector<char>& source_data, uint32_t variant);
+
+/// Maps the cached DDS blob for `key` and copies it into a `FileInfo` allocated with `alloc_fun`, returns `nullptr` on a miss
+FileInfo* dds_cache_load(const DdsCacheKey& key, AllocFun alloc_fun);
+void dds_cache_store(const DdsCacheKey& key, const void* dds_data, size_t dds_size);
+
+DdsCacheStats get_dds_cache_stats();
+
+uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0xcbf29ce484222325ull);
@@ -5,7 +5,7 @@
 #include <utility>  // for min, max
 
 #include "entity.hpp" // for to_id
-#include "memory.hpp" // for Memory, recover_mem, write_mem_recoverable
+#include "memory.hpp" // for Memory, recover_mem, write_mem_recoverable, MemoryPatchBatch
 #include "search.hpp" // for find_inst
 
 using namespace std::string_literals;
@@ -374,6 +374,7 @@ void replace_drop(int32_t drop_id, ENT_TYPE new_drop_entity_type)
         auto& entry = drop_entries.at(drop_id);
         if (new_drop_entity_type == 0)
         {
+            MemoryPatchBatch batch;
             for (int x = 0; x < 3; ++x)
                 if (entry.offsets[x])
                     recover_mem("replace_drop", entry.offsets[x]);
@@ -413,6 +414,7 @@ void replace_drop(int32_t drop_id, ENT_TYPE new_drop_entity_type)
 
         if (entry.offsets[0] != 0)
         {
+            MemoryPatchBatch batch;
             for (auto x = 0; x < entry.vtable_occurrence; ++x)
             {
                 write_mem_recoverable("replace_drop", entry.offsets[x], new_drop_entity_type, true);
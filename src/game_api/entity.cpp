@@ -384,6 +384,17 @@ Entity* get_entity_ptr_local(uint32_t uid)
     return p;
 }
 
+void get_entity_ptrs(std::span<const uint32_t> uids, std::span<Entity*> entities)
+{
+    auto state = State::get();
+    state.find_many(uids, entities);
+    for (Entity*& entity : entities.first(uids.size()))
+    {
+        if (IsBadWritePtr(entity, 0x178))
+            entity = nullptr;
+    }
+}
+
 std::vector<uint32_t> Movable::get_all_behaviors()
 {
     std::vector<uint32_t> anims;
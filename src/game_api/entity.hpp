@@ -287,3 +287,5 @@ AABB get_hitbox(uint32_t uid, bool use_render_pos);
 struct EntityFactory* entity_factory();
 Entity* get_entity_ptr(uint32_t uid);
 Entity* get_entity_ptr_local(uint32_t uid);
+/// Looks up all `uids` in one batch, `entities` must be at least as large and gets `nullptr` for uids that don't exist
+void get_entity_ptrs(std::span<const uint32_t> uids, std::span<Entity*> entities);
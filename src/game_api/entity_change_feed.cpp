@@ -0,0 +1,299 @@
+#include "entity_change_feed.hpp"
+
+#include <algorithm>     // for min, max
+#include <atomic>        // for atomic_bool
+#include <mutex>         // for mutex, lock_guard
+#include <span>          // for span
+#include <unordered_map> // for unordered_map
+#include <utility>       // for pair
+
+#include "containers/flat_pointer_map.hpp" // for FlatPointerMap
+#include "entity.hpp"                      // for Entity, get_entity_ptrs
+#include "layer.hpp"                       // for EntityList, Layer
+#include "state.hpp"                       // for State
+#include "vtable_hook.hpp"                 // for observe_dtor, VDestructorDetour, VTableHookBatch
+
+namespace
+{
+// Enough for a few frames of level generation, subscribers that fall further behind are told to rescan
+constexpr size_t g_change_buffer_size{0x4000};
+
+enum class EntityChangeKind : uint8_t
+{
+    Spawned,
+    Destroyed,
+};
+struct EntityChange
+{
+    uint32_t uid;
+    EntityChangeKind kind;
+};
+
+struct EntityChangeSubscription
+{
+    // Sequence number of the first change this subscription has not pulled yet
+    uint64_t cursor;
+    float move_epsilon;
+    // If set every live entity is watched for moves, and spawned entities are added to positions as they come in
+    bool watch_all_moves;
+    // Last reported position of every watched entity, only filled if move_epsilon is bigger than 0
+    std::unordered_map<uint32_t, std::pair<float, float>> positions;
+};
+
+struct EntityChangeFeed
+{
+    std::mutex lock;
+    // Ring buffer shared by all subscriptions, the change with sequence number `i` is at `i % g_change_buffer_size`
+    std::vector<EntityChange> changes;
+    uint64_t head{0};
+    uint64_t overflows{0};
+    EntityChangeFeedId next_id{0};
+    std::unordered_map<EntityChangeFeedId, EntityChangeSubscription> subscriptions;
+    // Vtables of entities whose destructor is observed, anything else that reaches the observer is not an entity
+    FlatPointerMap<void*, bool> entity_vtables;
+};
+EntityChangeFeed g_change_feed;
+// Checked without taking the lock, so spawns and destructions cost nothing while nobody is subscribed
+std::atomic_bool g_change_feed_active{false};
+
+void push_change(uint32_t uid, EntityChangeKind kind)
+{
+    g_change_feed.changes[g_change_feed.head % g_change_buffer_size] = EntityChange{uid, kind};
+    g_change_feed.head++;
+}
+
+void observe_entity(Entity* entity)
+{
+    void** vtable = *(void***)entity;
+    if (!g_change_feed.entity_vtables.contains(vtable))
+    {
+        g_change_feed.entity_vtables[vtable] = true;
+        observe_dtor(entity);
+    }
+}
+
+void on_destroy(void* self)
+{
+    if (!g_change_feed_active)
+    {
+        return;
+    }
+
+    std::lock_guard lock{g_change_feed.lock};
+    if (g_change_feed.entity_vtables.contains(*(void***)self))
+    {
+        push_change(static_cast<Entity*>(self)->uid, EntityChangeKind::Destroyed);
+    }
+}
+
+template <class FunT>
+void foreach_entity(FunT&& fun)
+{
+    auto state = State::get();
+    for (uint8_t layer = 0; layer < 2; ++layer)
+    {
+        for (Entity* entity : state.layer(layer)->all_entities.entities())
+        {
+            fun(entity);
+        }
+    }
+}
+
+void seed_positions(EntityChangeSubscription& subscription)
+{
+    subscription.positions.clear();
+    foreach_entity([&](Entity* entity)
+                   { subscription.positions.emplace(entity->uid, entity->position()); });
+}
+
+void watch_positions(EntityChangeSubscription& subscription, std::span<const uint32_t> uids)
+{
+    std::vector<Entity*> entities(uids.size());
+    get_entity_ptrs(uids, entities);
+    for (size_t i = 0; i < uids.size(); ++i)
+    {
+        if (entities[i] != nullptr)
+        {
+            subscription.positions.emplace(uids[i], entities[i]->position());
+        }
+    }
+}
+
+// Reads the position of every watched entity, so this is only as cheap as the watched set is small
+void collect_moved(EntityChangeSubscription& subscription, std::vector<uint32_t>& moved)
+{
+    std::vector<uint32_t> uids;
+    uids.reserve(subscription.positions.size());
+    for (const auto& [uid, position] : subscription.positions)
+    {
+        uids.push_back(uid);
+    }
+    std::vector<Entity*> entities(uids.size());
+    get_entity_ptrs(uids, entities);
+
+    const float epsilon_squared = subscription.move_epsilon * subscription.move_epsilon;
+    for (size_t i = 0; i < uids.size(); ++i)
+    {
+        if (entities[i] == nullptr)
+        {
+            // Gone without going through a destructor, e.g. the whole level was unloaded
+            subscription.positions.erase(uids[i]);
+            continue;
+        }
+
+        auto& last_position = subscription.positions[uids[i]];
+        const auto position = entities[i]->position();
+        const float dx = position.first - last_position.first;
+        const float dy = position.second - last_position.second;
+        if (dx * dx + dy * dy > epsilon_squared)
+        {
+            last_position = position;
+            moved.push_back(uids[i]);
+        }
+    }
+}
+} // namespace
+
+EntityChangeFeedId subscribe_entity_changes(float move_epsilon, std::optional<std::span<const uint32_t>> move_uids)
+{
+    std::lock_guard lock{g_change_feed.lock};
+    if (g_change_feed.changes.empty())
+    {
+        g_change_feed.changes.resize(g_change_buffer_size);
+        VDestructorDetour::s_Observer = &on_destroy;
+    }
+
+    // Entities spawned before anyone subscribed did not go through the spawn hook, so their destructors may not be observed yet
+    {
+        VTableHookBatch batch;
+        foreach_entity(&observe_entity);
+    }
+
+    const EntityChangeFeedId id = g_change_feed.next_id++;
+    EntityChangeSubscription& subscription = g_change_feed.subscriptions[id];
+    subscription.cursor = g_change_feed.head;
+    subscription.move_epsilon = move_epsilon;
+    subscription.watch_all_moves = !move_uids.has_value();
+    if (move_epsilon > 0.0f)
+    {
+        if (move_uids)
+        {
+            watch_positions(subscription, *move_uids);
+        }
+        else
+        {
+            seed_positions(subscription);
+        }
+    }
+
+    g_change_feed_active = true;
+    return id;
+}
+void unsubscribe_entity_changes(EntityChangeFeedId id)
+{
+    std::lock_guard lock{g_change_feed.lock};
+    g_change_feed.subscriptions.erase(id);
+    if (g_change_feed.subscriptions.empty())
+    {
+        // Destructors stay hooked, the observer just returns right away from now on
+        g_change_feed_active = false;
+    }
+}
+
+void watch_entity_moves(EntityChangeFeedId id, std::span<const uint32_t> uids)
+{
+    std::lock_guard lock{g_change_feed.lock};
+    auto it = g_change_feed.subscriptions.find(id);
+    if (it != g_change_feed.subscriptions.end() && it->second.move_epsilon > 0.0f && !it->second.watch_all_moves)
+    {
+        watch_positions(it->second, uids);
+    }
+}
+
+std::optional<EntityChangeDelta> pull_entity_changes(EntityChangeFeedId id)
+{
+    std::lock_guard lock{g_change_feed.lock};
+    auto it = g_change_feed.subscriptions.find(id);
+    if (it == g_change_feed.subscriptions.end())
+    {
+        return std::nullopt;
+    }
+    EntityChangeSubscription& subscription = it->second;
+    const bool track_moves = subscription.move_epsilon > 0.0f;
+
+    EntityChangeDelta delta;
+    delta.frame = State::get().get_frame_count();
+
+    uint64_t first = subscription.cursor;
+    if (g_change_feed.head - first > g_change_buffer_size)
+    {
+        first = g_change_feed.head - g_change_buffer_size;
+        delta.overflowed = true;
+        g_change_feed.overflows++;
+    }
+
+    for (uint64_t sequence = first; sequence < g_change_feed.head; ++sequence)
+    {
+        const EntityChange& change = g_change_feed.changes[sequence % g_change_buffer_size];
+        if (change.kind == EntityChangeKind::Spawned)
+        {
+            delta.spawned.push_back(change.uid);
+        }
+        else
+        {
+            delta.destroyed.push_back(change.uid);
+            if (track_moves)
+            {
+                subscription.positions.erase(change.uid);
+            }
+        }
+    }
+    subscription.cursor = g_change_feed.head;
+
+    if (track_moves)
+    {
+        if (delta.overflowed && subscription.watch_all_moves)
+        {
+            // Spawns were lost, so the tracked set can't be patched up anymore
+            seed_positions(subscription);
+        }
+        else
+        {
+            // Watched entities whose destruction was lost are dropped here as well, since they can't be found anymore
+            collect_moved(subscription, delta.moved);
+            if (subscription.watch_all_moves)
+            {
+                // New entities are compared against the position they have now starting with the next pull
+                watch_positions(subscription, delta.spawned);
+            }
+        }
+    }
+    return delta;
+}
+
+void record_entity_spawn(Entity* entity)
+{
+    if (!g_change_feed_active || entity == nullptr)
+    {
+        return;
+    }
+
+    std::lock_guard lock{g_change_feed.lock};
+    observe_entity(entity);
+    push_change(entity->uid, EntityChangeKind::Spawned);
+}
+
+EntityChangeFeedStats get_entity_change_feed_stats()
+{
+    std::lock_guard lock{g_change_feed.lock};
+    EntityChangeFeedStats stats;
+    stats.subscriptions = g_change_feed.subscriptions.size();
+    stats.capacity = g_change_feed.changes.size();
+    stats.total_changes = g_change_feed.head;
+    stats.overflows = g_change_feed.overflows;
+    for (const auto& [id, subscription] : g_change_feed.subscriptions)
+    {
+        stats.buffered_changes = std::max<size_t>(stats.buffered_changes, std::min<uint64_t>(g_change_feed.head - subscription.cursor, g_change_buffer_size));
+    }
+    return stats;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>  // for size_t
+#include <cstdint>  // for uint32_t, uint64_t
+#include <optional> // for optional, nullopt
+#include <span>     // for span
+#include <vector>   // for vector
+
+class Entity;
+
+/// Everything that changed since the previous pull of a subscription, every list is in the order the changes happened
+struct EntityChangeDelta
+{
+    /// Frame count at the time of the pull, see `get_frame`
+    uint32_t frame{0};
+    std::vector<uint32_t> spawned;
+    std::vector<uint32_t> destroyed;
+    /// Watched entities that moved more than the epsilon of the subscription, always empty if the epsilon is 0
+    std::vector<uint32_t> moved;
+    /// True if the subscription fell behind by more than the buffer holds, changes in between are lost and a full rescan is needed
+    bool overflowed{false};
+};
+
+struct EntityChangeFeedStats
+{
+    size_t subscriptions{0};
+    size_t buffered_changes{0};
+    size_t capacity{0};
+    uint64_t total_changes{0};
+    uint64_t overflows{0};
+};
+
+using EntityChangeFeedId = uint32_t;
+
+/// Starts recording spawned and destroyed entities for the returned subscription.
+/// If `move_epsilon` is bigger than 0 the subscription also reports entities that moved further than that, out of `move_uids` and anything later added with `watch_entity_moves`.
+/// Without `move_uids` every live entity is watched, which means every pull reads the position of every entity in the level.
+EntityChangeFeedId subscribe_entity_changes(float move_epsilon, std::optional<std::span<const uint32_t>> move_uids = std::nullopt);
+void unsubscribe_entity_changes(EntityChangeFeedId id);
+/// Adds entities to the ones a subscription watches for moves, does nothing for subscriptions that already watch every entity or don't track moves at all
+void watch_entity_moves(EntityChangeFeedId id, std::span<const uint32_t> uids);
+/// Returns all changes since the last pull, or since subscribing, `nullopt` for unknown ids
+std::optional<EntityChangeDelta> pull_entity_changes(EntityChangeFeedId id);
+
+/// Called from the spawn hook for every spawned entity
+void record_entity_spawn(Entity* entity);
+
+EntityChangeFeedStats get_entity_change_feed_stats();
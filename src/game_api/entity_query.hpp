@@ -0,0 +1,356 @@
+#pragma once
+
+#include <algorithm> // for min, max
+#include <atomic>    // for atomic_bool
+#include <bit>       // for countr_zero
+#include <cmath>     // for pow, sqrt
+#include <cstddef>   // for ptrdiff_t, size_t
+#include <cstdint>   // for uint32_t, uint64_t
+#include <iterator>  // for default_sentinel_t, forward_iterator_tag
+#include <ranges>    // for view_interface, views::filter
+#include <span>      // for span
+#include <vector>    // for vector
+
+#include "aliases.hpp"     // for ENT_TYPE
+#include "entity.hpp"      // for Entity
+#include "entity_db.hpp"   // for EntityDB
+#include "layer.hpp"       // for Layer, EntityList, MaskEntityLists
+#include "math.hpp"        // for AABB
+#include "worker_pool.hpp" // for WorkerPool
+
+// Lazy queries over the entities of a layer, meant to be composed instead of building a vector per filter, e.g.
+//     for (Entity* entity : entities_by_mask(layer, mask) | filter_types(types) | filter_overlapping(hitbox))
+
+class MaskedEntityView;
+
+// Part of one of the lists a MaskedEntityView walks, so a query can be split across threads
+struct MaskedEntityChunk
+{
+    const MaskedEntityView* view;
+    const EntityList* list;
+    uint32_t bit;
+    uint32_t begin;
+    uint32_t end;
+
+    template <class FunT>
+    void for_each(FunT&& fun) const;
+};
+
+// Walks the lists of every bit in `mask`, or all_entities if `mask` is 0, entities that are in more than one of those lists are only visited once
+class MaskedEntityView : public std::ranges::view_interface<MaskedEntityView>
+{
+  public:
+    class iterator
+    {
+      public:
+        using iterator_concept = std::forward_iterator_tag;
+        using value_type = Entity*;
+        using difference_type = std::ptrdiff_t;
+
+        iterator() = default;
+        iterator(const MaskedEntityView* view, uint32_t remaining_bits)
+            : m_View{view}, m_RemainingBits{remaining_bits}
+        {
+            next_list();
+            skip_visited();
+        }
+
+        Entity* operator*() const
+        {
+            return m_List->ent_list[m_Index];
+        }
+        iterator& operator++()
+        {
+            ++m_Index;
+            skip_visited();
+            return *this;
+        }
+        iterator operator++(int)
+        {
+            iterator copy = *this;
+            ++*this;
+            return copy;
+        }
+
+        bool operator==(const iterator& other) const
+        {
+            return m_List == other.m_List && m_Index == other.m_Index;
+        }
+        bool operator==(std::default_sentinel_t) const
+        {
+            return m_List == nullptr;
+        }
+
+      private:
+        void next_list()
+        {
+            m_List = nullptr;
+            m_Index = 0;
+            while (m_RemainingBits != 0)
+            {
+                m_Bit = static_cast<uint32_t>(std::countr_zero(m_RemainingBits));
+                m_RemainingBits &= m_RemainingBits - 1;
+                if (const EntityList* list = m_View->list_for_bit(m_Bit); list != nullptr && list->size != 0)
+                {
+                    m_List = list;
+                    return;
+                }
+            }
+        }
+        void skip_visited()
+        {
+            while (m_List != nullptr)
+            {
+                if (m_Index >= m_List->size)
+                {
+                    next_list();
+                    continue;
+                }
+                if (!m_View->was_visited(m_List->ent_list[m_Index], m_Bit))
+                {
+                    return;
+                }
+                ++m_Index;
+            }
+        }
+
+        const MaskedEntityView* m_View{nullptr};
+        const EntityList* m_List{nullptr};
+        uint32_t m_Index{0};
+        uint32_t m_Bit{0};
+        uint32_t m_RemainingBits{0};
+    };
+
+    MaskedEntityView() = default;
+    MaskedEntityView(const Layer* layer, uint32_t mask)
+        : m_AllEntities{&layer->all_entities}, m_Mask{mask & 0x7fff}
+    {
+        if (mask != 0)
+        {
+            m_Lists = &layer->get_mask_lists();
+        }
+    }
+
+    iterator begin() const
+    {
+        // Bit 15 stands in for all_entities, it is never set in a real mask
+        return iterator{this, m_Lists == nullptr ? 1u << 15 : m_Mask};
+    }
+    std::default_sentinel_t end() const
+    {
+        return {};
+    }
+
+    // Total size of the lists, entities in more than one list are counted for each of them
+    size_t size_upper_bound() const
+    {
+        size_t size = 0;
+        for_each_list([&size](const EntityList* list, uint32_t)
+                      { size += list->size; });
+        return size;
+    }
+    // Splits the lists into chunks of at most `chunk_size` entities, walking all chunks in order visits the same entities as iterating the view
+    void append_chunks(std::vector<MaskedEntityChunk>& chunks, uint32_t chunk_size) const
+    {
+        for_each_list([&](const EntityList* list, uint32_t bit)
+                      {
+                          for (uint32_t begin = 0; begin < list->size; begin += chunk_size)
+                          {
+                              chunks.push_back({this, list, bit, begin, std::min(begin + chunk_size, list->size)});
+                          } });
+    }
+
+  private:
+    friend class iterator;
+    friend struct MaskedEntityChunk;
+
+    template <class FunT>
+    void for_each_list(FunT&& fun) const
+    {
+        for (uint32_t bits = m_Lists == nullptr ? 1u << 15 : m_Mask; bits != 0; bits &= bits - 1)
+        {
+            const uint32_t bit = static_cast<uint32_t>(std::countr_zero(bits));
+            if (const EntityList* list = list_for_bit(bit); list != nullptr && list->size != 0)
+            {
+                fun(list, bit);
+            }
+        }
+    }
+
+    const EntityList* list_for_bit(uint32_t bit) const
+    {
+        return bit == 15 ? m_AllEntities : (*m_Lists)[bit];
+    }
+    // An entity with more than one of the mask bits set is in each of those lists, keep it only in the first one that exists
+    bool was_visited(const Entity* entity, uint32_t bit) const
+    {
+        if (bit == 15)
+        {
+            return false;
+        }
+        uint32_t earlier_bits = entity->type->search_flags & m_Mask & ((1u << bit) - 1);
+        while (earlier_bits != 0)
+        {
+            if ((*m_Lists)[std::countr_zero(earlier_bits)] != nullptr)
+            {
+                return true;
+            }
+            earlier_bits &= earlier_bits - 1;
+        }
+        return false;
+    }
+
+    const EntityList* m_AllEntities{nullptr};
+    const MaskEntityLists* m_Lists{nullptr};
+    uint32_t m_Mask{0};
+};
+
+template <class FunT>
+void MaskedEntityChunk::for_each(FunT&& fun) const
+{
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        Entity* entity = list->ent_list[i];
+        if (!view->was_visited(entity, bit))
+        {
+            fun(entity);
+        }
+    }
+}
+
+inline MaskedEntityView entities_by_mask(const Layer* layer, uint32_t mask)
+{
+    return MaskedEntityView{layer, mask};
+}
+
+// Below this many entities per chunk handing the work to other threads costs more than it saves
+inline constexpr uint32_t g_min_entities_per_query_chunk{4096};
+// Queries are only split across threads when this is set, it stays off until tests/entity_query_bench shows a gain on multi-core machines
+inline std::atomic_bool g_parallel_entity_queries{false};
+
+// Builds a list of uids from the entities in `views`, `collect(walk, found)` is called for every part of the query and `walk(fun)` calls `fun` for the entities of that part.
+// Putting the parts back together gives the same order as iterating the views one after another.
+// Queries over big levels are split across `pool` if `g_parallel_entity_queries` is set, so `collect` must only read from the entities.
+template <class CollectT>
+std::vector<uint32_t> collect_entity_uids_by(std::span<const MaskedEntityView> views, CollectT&& collect, WorkerPool& pool = WorkerPool::get())
+{
+    std::vector<uint32_t> found;
+    size_t size = 0;
+    for (const MaskedEntityView& view : views)
+    {
+        size += view.size_upper_bound();
+    }
+
+    if (!g_parallel_entity_queries || pool.thread_count() == 1 || size < 2 * g_min_entities_per_query_chunk)
+    {
+        collect([views](auto&& fun)
+                {
+                    for (const MaskedEntityView& view : views)
+                    {
+                        for (Entity* entity : view)
+                        {
+                            fun(entity);
+                        }
+                    } },
+                found);
+        return found;
+    }
+
+    // A few chunks per thread so one slow chunk doesn't leave the others waiting
+    const size_t chunk_size = std::max<size_t>(g_min_entities_per_query_chunk, size / (pool.thread_count() * 4) + 1);
+    std::vector<MaskedEntityChunk> chunks;
+    for (const MaskedEntityView& view : views)
+    {
+        view.append_chunks(chunks, static_cast<uint32_t>(chunk_size));
+    }
+
+    std::vector<std::vector<uint32_t>> chunk_found(chunks.size());
+    pool.run(chunks.size(), [&](size_t i)
+             { collect([&chunk = chunks[i]](auto&& fun)
+                       { chunk.for_each(fun); },
+                       chunk_found[i]); });
+
+    size_t found_size = 0;
+    for (const std::vector<uint32_t>& uids : chunk_found)
+    {
+        found_size += uids.size();
+    }
+    found.reserve(found_size);
+    for (const std::vector<uint32_t>& uids : chunk_found)
+    {
+        found.insert(found.end(), uids.begin(), uids.end());
+    }
+    return found;
+}
+
+// Uids of the entities in `views` that `matches` accepts, see collect_entity_uids_by
+template <class PredT>
+std::vector<uint32_t> collect_entity_uids(std::span<const MaskedEntityView> views, PredT&& matches, WorkerPool& pool = WorkerPool::get())
+{
+    return collect_entity_uids_by(
+        views,
+        [&matches](auto&& walk, std::vector<uint32_t>& found)
+        {
+            walk([&](Entity* entity)
+                 {
+                     if (matches(entity))
+                     {
+                         found.push_back(entity->uid);
+                     } });
+        },
+        pool);
+}
+
+// Constant time membership test for a list of entity types, a list that is empty or starts with 0 matches every type, same as entity_type_check
+class EntityTypeSet
+{
+  public:
+    explicit EntityTypeSet(const std::vector<ENT_TYPE>& types)
+    {
+        if (types.empty() || types[0] == 0)
+        {
+            m_MatchesAll = true;
+            return;
+        }
+        for (ENT_TYPE type : types)
+        {
+            if (type / 64 >= m_Bits.size())
+            {
+                m_Bits.resize(type / 64 + 1);
+            }
+            m_Bits[type / 64] |= uint64_t{1} << (type % 64);
+        }
+    }
+
+    bool matches_all() const
+    {
+        return m_MatchesAll;
+    }
+    bool contains(ENT_TYPE type) const
+    {
+        return m_MatchesAll || (type / 64 < m_Bits.size() && (m_Bits[type / 64] >> (type % 64)) & 1);
+    }
+
+  private:
+    bool m_MatchesAll{false};
+    std::vector<uint64_t> m_Bits;
+};
+
+// The set has to outlive the query
+inline auto filter_types(const EntityTypeSet& types)
+{
+    return std::views::filter([&types](Entity* entity)
+                              { return types.contains(entity->type->id); });
+}
+inline auto filter_overlapping(AABB hitbox)
+{
+    return std::views::filter([hitbox](Entity* entity)
+                              { return entity->overlaps_with(hitbox); });
+}
+inline auto filter_near(float x, float y, float radius)
+{
+    return std::views::filter([x, y, radius](Entity* entity)
+                              {
+                                  const auto [ix, iy] = entity->position();
+                                  return std::sqrt(std::pow(x - ix, 2.0f) + std::pow(y - iy, 2.0f)) < radius; });
+}
@@ -0,0 +1,117 @@
+#include "entity_snapshot.hpp"
+
+#include "entity.hpp"    // for Entity
+#include "entity_db.hpp" // for EntityDB
+#include "layer.hpp"     // for EntityList, Layer
+#include "movable.hpp"   // for Movable
+#include "state.hpp"     // for State, enum_to_layer
+
+namespace
+{
+bool has_column(uint32_t columns, SNAPSHOT_COLUMN column)
+{
+    return (columns & static_cast<uint32_t>(column)) != 0;
+}
+
+template <class T>
+void reserve_column(uint32_t columns, SNAPSHOT_COLUMN column, std::vector<T>& values, size_t size)
+{
+    if (has_column(columns, column))
+    {
+        values.reserve(size);
+    }
+}
+
+void append_entities(EntitySnapshot& snapshot, const EntityList& entities)
+{
+    // Test the columns once per list instead of once per entity and column
+    const uint32_t columns = snapshot.columns;
+    const bool want_uid = has_column(columns, SNAPSHOT_COLUMN::UID);
+    const bool want_type = has_column(columns, SNAPSHOT_COLUMN::TYPE);
+    const bool want_position = has_column(columns, SNAPSHOT_COLUMN::X) || has_column(columns, SNAPSHOT_COLUMN::Y);
+    const bool want_x = has_column(columns, SNAPSHOT_COLUMN::X);
+    const bool want_y = has_column(columns, SNAPSHOT_COLUMN::Y);
+    const bool want_layer = has_column(columns, SNAPSHOT_COLUMN::LAYER);
+    const bool want_flags = has_column(columns, SNAPSHOT_COLUMN::FLAGS);
+    const bool want_more_flags = has_column(columns, SNAPSHOT_COLUMN::MORE_FLAGS);
+    const bool want_mask = has_column(columns, SNAPSHOT_COLUMN::MASK);
+    const bool want_overlay = has_column(columns, SNAPSHOT_COLUMN::OVERLAY);
+    const bool want_health = has_column(columns, SNAPSHOT_COLUMN::HEALTH);
+
+    if (want_uid)
+    {
+        const auto uids = entities.uids();
+        snapshot.uid.insert(snapshot.uid.end(), uids.begin(), uids.end());
+    }
+
+    for (Entity* entity : entities.entities())
+    {
+        if (want_type)
+            snapshot.type.push_back(entity->type->id);
+        if (want_position)
+        {
+            const auto [x, y] = entity->position();
+            if (want_x)
+                snapshot.x.push_back(x);
+            if (want_y)
+                snapshot.y.push_back(y);
+        }
+        if (want_layer)
+            snapshot.layer.push_back(entity->layer);
+        if (want_flags)
+            snapshot.flags.push_back(entity->flags);
+        if (want_more_flags)
+            snapshot.more_flags.push_back(entity->more_flags);
+        if (want_mask)
+            snapshot.mask.push_back(entity->type->search_flags);
+        if (want_overlay)
+            snapshot.overlay.push_back(entity->overlay != nullptr ? entity->overlay->uid : -1);
+        if (want_health)
+            snapshot.health.push_back(entity->is_movable() ? entity->as<Movable>()->health : 0);
+    }
+    snapshot.size += entities.size;
+}
+} // namespace
+
+EntitySnapshot take_entity_snapshot(uint32_t columns, LAYER layer)
+{
+    auto state = State::get();
+
+    EntitySnapshot snapshot;
+    snapshot.columns = columns & static_cast<uint32_t>(SNAPSHOT_COLUMN::ALL);
+
+    Layer* layers[2]{};
+    if (layer == LAYER::BOTH)
+    {
+        layers[0] = state.layer(0);
+        layers[1] = state.layer(1);
+    }
+    else
+    {
+        layers[0] = state.layer(enum_to_layer(layer));
+    }
+
+    size_t size = 0;
+    for (Layer* l : layers)
+    {
+        if (l != nullptr)
+            size += l->all_entities.size;
+    }
+    reserve_column(snapshot.columns, SNAPSHOT_COLUMN::UID, snapshot.uid, size);
+    reserve_column(snapshot.columns, SNAPSHOT_COLUMN::TYPE, snapshot.type, size);
+    reserve_column(snapshot.columns, SNAPSHOT_COLUMN::X, snapshot.x, size);
+    reserve_column(snapshot.columns, SNAPSHOT_COLUMN::Y, snapshot.y, size);
+    reserve_column(snapshot.columns, SNAPSHOT_COLUMN::LAYER, snapshot.layer, size);
+    reserve_column(snapshot.columns, SNAPSHOT_COLUMN::FLAGS, snapshot.flags, size);
+    reserve_column(snapshot.columns, SNAPSHOT_COLUMN::MORE_FLAGS, snapshot.more_flags, size);
+    reserve_column(snapshot.columns, SNAPSHOT_COLUMN::MASK, snapshot.mask, size);
+    reserve_column(snapshot.columns, SNAPSHOT_COLUMN::OVERLAY, snapshot.overlay, size);
+    reserve_column(snapshot.columns, SNAPSHOT_COLUMN::HEALTH, snapshot.health, size);
+
+    for (Layer* l : layers)
+    {
+        if (l != nullptr)
+            append_entities(snapshot, l->all_entities);
+    }
+    return snapshot;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint> // for uint32_t, int32_t, uint8_t
+#include <vector>  // for vector
+
+#include "aliases.hpp" // for ENT_TYPE, LAYER
+
+enum class SNAPSHOT_COLUMN : uint32_t
+{
+    UID = 0x1,
+    TYPE = 0x2,
+    X = 0x4,
+    Y = 0x8,
+    LAYER = 0x10,
+    FLAGS = 0x20,
+    MORE_FLAGS = 0x40,
+    MASK = 0x80,
+    OVERLAY = 0x100,
+    HEALTH = 0x200,
+    ALL = 0x3FF,
+};
+
+/// Columns of every entity in a layer at the time the snapshot was taken, only the columns that were requested are filled, the rest stay empty.
+/// Index `i` of every filled column describes the same entity.
+struct EntitySnapshot
+{
+    /// Combination of `SNAPSHOT_COLUMN` that were filled
+    uint32_t columns{0};
+    /// Number of entities in the snapshot
+    uint32_t size{0};
+
+    std::vector<uint32_t> uid;
+    std::vector<ENT_TYPE> type;
+    /// Absolute position, same as `get_position`
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<uint8_t> layer;
+    std::vector<uint32_t> flags;
+    std::vector<uint32_t> more_flags;
+    /// Search flags of the entity type, see `MASK`
+    std::vector<uint32_t> mask;
+    /// Uid of the overlay, -1 if there is none
+    std::vector<int32_t> overlay;
+    /// Health of movable entities, 0 for everything else
+    std::vector<uint8_t> health;
+};
+
+/// Walks all entities of `layer` once (both layers for `LAYER::BOTH`) and copies the requested `columns` into contiguous arrays
+EntitySnapshot take_entity_snapshot(uint32_t columns, LAYER layer);
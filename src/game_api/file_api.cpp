@@ -2,13 +2,18 @@
 
 #include <atomic>
 #include <chrono>
+#include <fstream>
+#include <optional>
+#include <vector>
 
 #include <d3d11.h>
-#include <detours.h>
 
 #include "containers/game_allocator.hpp"
 
+#include "dds_cache.hpp"
+#include "hook_registry.hpp"
 #include "memory.hpp"
+#include "texture_compression.hpp"
 #include "util.hpp"
 #include "window_api.hpp"
 
@@ -33,9 +38,34 @@ FileInfo* load_file_as_dds_if_image(const char* file_path, AllocFun alloc_fun)
     auto ext = path.substr(path.find_last_of('.'));
     if (ext == ".png"sv || ext == ".jpeg"sv || ext == ".bmp"sv || ext == ".tga"sv)
     {
+        const std::string source_path{path};
+        const TEXTURE_COMPRESSION compression = get_texture_compression(source_path);
+        std::optional<DdsCacheKey> cache_key;
+        std::vector<char> source_data;
+        if (is_dds_cache_enabled())
+        {
+            std::ifstream source_file(source_path, std::ios::binary | std::ios::ate);
+            if (source_file)
+            {
+                source_data.resize(static_cast<size_t>(source_file.tellg()));
+                source_file.seekg(0);
+                source_file.read(source_data.data(), source_data.size());
+                cache_key = make_dds_cache_key(source_path, source_data, static_cast<uint32_t>(compression));
+            }
+            if (cache_key)
+            {
+                if (FileInfo* cached_file = dds_cache_load(cache_key.value(), alloc_fun))
+                {
+                    return cached_file;
+                }
+            }
+        }
+
         int image_width = 0;
         int image_height = 0;
-        unsigned char* image_data = stbi_load(path.data(), &image_width, &image_height, NULL, 4);
+        unsigned char* image_data = source_data.empty()
+                                        ? stbi_load(source_path.c_str(), &image_width, &image_height, NULL, 4)
+                                        : stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(source_data.data()), static_cast<int>(source_data.size()), &image_width, &image_height, NULL, 4);
         if (image_data != nullptr)
         {
             // https://docs.microsoft.com/en-us/windows/win32/direct3ddds/dds-header
@@ -67,6 +97,15 @@ FileInfo* load_file_as_dds_if_image(const char* file_path, AllocFun alloc_fun)
                 DWORD dwCaps4;
                 DWORD dwReserved2;
             } DDS_HEADER;
+            // https://docs.microsoft.com/en-us/windows/win32/direct3ddds/dds-header-dxt10
+            typedef struct
+            {
+                DWORD dxgiFormat;
+                DWORD resourceDimension;
+                DWORD miscFlag;
+                DWORD arraySize;
+                DWORD miscFlags2;
+            } DDS_HEADER_DXT10;
 
             DDS_HEADER header{
                 124,        // hardcoded
@@ -95,9 +134,38 @@ FileInfo* load_file_as_dds_if_image(const char* file_path, AllocFun alloc_fun)
                 0,      // unused
                 0,
             };
+            DDS_HEADER_DXT10 header_dxt10{
+                98, // DXGI_FORMAT_BC7_UNORM
+                3,  // D3D10_RESOURCE_DIMENSION_TEXTURE2D
+                0,
+                1,
+                0,
+            };
+
+            const bool compressed = compression != TEXTURE_COMPRESSION::NONE && can_compress_texture(image_width, image_height);
+            const bool extended_header = compressed && compression == TEXTURE_COMPRESSION::BC7;
+            if (compressed)
+            {
+                header.dwFlags = 0x00081007; // required flags + linear size
+                header.dwPitchOrLinearSize = static_cast<DWORD>(compressed_texture_size(compression, image_width, image_height));
+                header.dwMipMapCount = 0;
+                header.ddspf = DDS_PIXELFORMAT{
+                    32,  // size of pixel format structure, constant
+                    0x4, // compressed, format given in dwFourCC
+                    compression == TEXTURE_COMPRESSION::BC1   ? MAKEFOURCC('D', 'X', 'T', '1')
+                    : compression == TEXTURE_COMPRESSION::BC3 ? MAKEFOURCC('D', 'X', 'T', '5')
+                                                              : MAKEFOURCC('D', 'X', '1', '0'),
+                    0,
+                    0,
+                    0,
+                    0,
+                    0,
+                };
+            }
 
-            auto image_data_size = image_width * image_height * 4;
-            int data_size = 4 + sizeof(DDS_HEADER) + image_data_size;
+            auto image_data_size = compressed ? compressed_texture_size(compression, image_width, image_height) : static_cast<size_t>(image_width * image_height * 4);
+            auto header_size = 4 + sizeof(DDS_HEADER) + (extended_header ? sizeof(DDS_HEADER_DXT10) : 0);
+            int data_size = static_cast<int>(header_size + image_data_size);
             auto allocation_size = sizeof(FileInfo) + data_size;
             auto file_buffer = (char*)alloc_fun(allocation_size);
 
@@ -109,10 +177,26 @@ FileInfo* load_file_as_dds_if_image(const char* file_path, AllocFun alloc_fun)
             auto dds_image_data = file_buffer + sizeof(FileInfo);
             memcpy(dds_image_data, "DDS ", 4);
             memcpy(dds_image_data + 4, &header, sizeof(DDS_HEADER));
-            memcpy(dds_image_data + 4 + sizeof(DDS_HEADER), image_data, image_data_size);
+            if (extended_header)
+            {
+                memcpy(dds_image_data + 4 + sizeof(DDS_HEADER), &header_dxt10, sizeof(DDS_HEADER_DXT10));
+            }
+            if (compressed)
+            {
+                compress_texture(compression, image_data, image_width, image_height, reinterpret_cast<uint8_t*>(dds_image_data + header_size));
+            }
+            else
+            {
+                memcpy(dds_image_data + header_size, image_data, image_data_size);
+            }
 
             stbi_image_free(image_data);
 
+            if (cache_key)
+            {
+                dds_cache_store(cache_key.value(), file_info->Data, data_size);
+            }
+
             return file_info;
         }
     }
@@ -191,17 +275,7 @@ void register_on_load_file(LoadFileCallback on_load_file)
     if (g_read_encrypted_file_trampoline == nullptr && on_load_file != nullptr)
     {
         g_read_encrypted_file_trampoline = (ReadEncryptedFileFun*)get_address("read_encrypted_file"sv);
-
-        DetourTransactionBegin();
-        DetourUpdateThread(GetCurrentThread());
-
-        DetourAttach((void**)&g_read_encrypted_file_trampoline, read_encrypted_file);
-
-        const LONG error = DetourTransactionCommit();
-        if (error != NO_ERROR)
-        {
-            DEBUG("Failed hooking ReadEncryptedFile: {}\n", error);
-        }
+        attach_hook("read_encrypted_file", (void**)&g_read_encrypted_file_trampoline, read_encrypted_file);
     }
     g_OnLoadFile = on_load_file;
 }
@@ -210,17 +284,7 @@ void register_on_read_from_file(ReadFromFileCallback on_read_from_file)
     if (g_read_from_file_trampoline == nullptr && on_read_from_file != nullptr)
     {
         g_read_from_file_trampoline = (ReadFromFileOrig*)get_address("read_from_file"sv);
-
-        DetourTransactionBegin();
-        DetourUpdateThread(GetCurrentThread());
-
-        DetourAttach((void**)&g_read_from_file_trampoline, read_from_file);
-
-        const LONG error = DetourTransactionCommit();
-        if (error != NO_ERROR)
-        {
-            DEBUG("Failed hooking ReadFromFile: {}\n", error);
-        }
+        attach_hook("read_from_file", (void**)&g_read_from_file_trampoline, read_from_file);
     }
     g_ReadFromFile = on_read_from_file;
 }
@@ -229,17 +293,7 @@ void register_on_write_to_file(WriteToFileCallback on_write_to_file)
     if (g_write_to_file_trampoline == nullptr && on_write_to_file != nullptr)
     {
         g_write_to_file_trampoline = (WriteToFileOrig*)get_address("write_to_file"sv);
-
-        DetourTransactionBegin();
-        DetourUpdateThread(GetCurrentThread());
-
-        DetourAttach((void**)&g_write_to_file_trampoline, write_to_file);
-
-        const LONG error = DetourTransactionCommit();
-        if (error != NO_ERROR)
-        {
-            DEBUG("Failed hooking WriteToFile: {}\n", error);
-        }
+        attach_hook("write_to_file", (void**)&g_write_to_file_trampoline, write_to_file);
     }
     g_WriteToFile = on_write_to_file;
 }
@@ -357,6 +357,10 @@ using ChannelControl = tagged_void<struct channel_control_tag>; // Either a Chan
 using CreateSound = FMOD_RESULT(System*, const char*, FMOD_MODE, CREATESOUNDEXINFO*, Sound**);
 using ReleaseSound = FMOD_RESULT(Sound*);
 using PlaySound = FMOD_RESULT(System*, Sound*, ChannelGroup*, bool, Channel**);
+using SoundGetUserData = FMOD_RESULT(Sound*, void**);
+
+using SoundPcmReadCallback = FMOD_RESULT(Sound*, void*, std::uint32_t);
+using SoundPcmSetPosCallback = FMOD_RESULT(Sound*, int, std::uint32_t, TIMEUNIT);
 
 using ChannelControlCallback = FMOD_RESULT(ChannelControl*, ChannelControlType, ChannelControlCallbackType, void*, void*);
 
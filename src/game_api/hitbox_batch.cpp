@@ -0,0 +1,32 @@
+#include "hitbox_batch.hpp"
+
+#include <bit>         // for countr_zero
+#include <xmmintrin.h> // for _mm_load_ps, _mm_cmplt_ps, _mm_and_ps, _mm_movemask_ps, ...
+
+void append_overlapping(const AABB& box, const HitboxBatch& batch, std::vector<uint32_t>& found)
+{
+    // Only SSE, which every x64 cpu has, there is no runtime cpu dispatch to fall back from AVX on machines without it
+    const __m128 box_left = _mm_set1_ps(box.left);
+    const __m128 box_bottom = _mm_set1_ps(box.bottom);
+    const __m128 box_right = _mm_set1_ps(box.right);
+    const __m128 box_top = _mm_set1_ps(box.top);
+
+    size_t i = 0;
+    for (; i + 4 <= batch.size; i += 4)
+    {
+        // Same comparisons as AABB::overlaps_with with the batch hitbox on the left, ordered compares are false for NaN just like `<`
+        const __m128 x_overlap = _mm_and_ps(_mm_cmplt_ps(_mm_load_ps(batch.left + i), box_right), _mm_cmplt_ps(box_left, _mm_load_ps(batch.right + i)));
+        const __m128 y_overlap = _mm_and_ps(_mm_cmplt_ps(_mm_load_ps(batch.bottom + i), box_top), _mm_cmplt_ps(box_bottom, _mm_load_ps(batch.top + i)));
+        for (uint32_t hits = static_cast<uint32_t>(_mm_movemask_ps(_mm_and_ps(x_overlap, y_overlap))); hits != 0; hits &= hits - 1)
+        {
+            found.push_back(batch.uid[i + std::countr_zero(hits)]);
+        }
+    }
+    for (; i < batch.size; ++i)
+    {
+        if (AABB{batch.left[i], batch.top[i], batch.right[i], batch.bottom[i]}.overlaps_with(box))
+        {
+            found.push_back(batch.uid[i]);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef> // for size_t
+#include <cstdint> // for uint32_t
+#include <vector>  // for vector
+
+#include "entity.hpp" // for Entity
+#include "math.hpp"   // for AABB
+
+// Hitboxes of up to `c_Capacity` entities stored column by column, so a query box can be tested against 4 of them per instruction
+struct HitboxBatch
+{
+    static constexpr size_t c_Capacity{256};
+
+    alignas(16) float left[c_Capacity];
+    alignas(16) float bottom[c_Capacity];
+    alignas(16) float right[c_Capacity];
+    alignas(16) float top[c_Capacity];
+    uint32_t uid[c_Capacity];
+    size_t size{0};
+
+    bool full() const
+    {
+        return size == c_Capacity;
+    }
+    void clear()
+    {
+        size = 0;
+    }
+
+    // Same box Entity::overlaps_with tests against
+    void push_back(Entity* entity)
+    {
+        const auto [x, y] = entity->position();
+        left[size] = x - entity->hitboxx + entity->offsetx;
+        right[size] = x + entity->hitboxx + entity->offsetx;
+        bottom[size] = y - entity->hitboxy + entity->offsety;
+        top[size] = y + entity->hitboxy + entity->offsety;
+        uid[size] = entity->uid;
+        size++;
+    }
+};
+
+// Appends the uid of every hitbox in `batch` that overlaps `box` to `found`, in batch order.
+// Gives the same answer as AABB::overlaps_with for every hitbox, touching edges don't overlap and NaN never does.
+void append_overlapping(const AABB& box, const HitboxBatch& batch, std::vector<uint32_t>& found);
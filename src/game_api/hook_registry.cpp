@@ -0,0 +1,149 @@
+#include "hook_registry.hpp"
+
+#include <Windows.h> // for GetCurrentThread, LONG, NO_ERROR
+#include <algorithm> // for find
+#include <cstdint>   // for uint32_t
+#include <detours.h> // for DetourAttach, DetourTransactionAbort, DetourTransactionBegin, ...
+#include <mutex>     // for recursive_mutex, lock_guard
+
+#include "logger.h" // for DEBUG
+
+namespace
+{
+struct HookEntry
+{
+    HookInstallStats stats;
+    void** trampoline;
+    void* detour;
+};
+
+struct HookRegistry
+{
+    // Held for the whole lifetime of the outermost transaction, Detours only supports one pending transaction at a time
+    std::recursive_mutex lock;
+    uint32_t depth{0};
+    std::chrono::steady_clock::time_point transaction_start;
+    std::vector<HookEntry> hooks;
+    // Indices into hooks that were attached in the pending transaction
+    std::vector<size_t> pending;
+};
+HookRegistry g_hook_registry;
+
+void attach_entry(size_t index)
+{
+    HookTransaction transaction;
+
+    HookEntry& entry = g_hook_registry.hooks[index];
+    const auto attach_start = std::chrono::steady_clock::now();
+    entry.stats.error = DetourAttach(entry.trampoline, entry.detour);
+    entry.stats.attach_time = std::chrono::steady_clock::now() - attach_start;
+    if (entry.stats.error != NO_ERROR)
+    {
+        DEBUG("Failed attaching hook {}: {}", entry.stats.name, entry.stats.error);
+
+        // Detours remembers the first error of a transaction and fails the commit with it, which would drop every other pending hook too,
+        // so start over without the failing hook and queue the others again
+        DetourTransactionAbort();
+        DetourTransactionBegin();
+        DetourUpdateThread(GetCurrentThread());
+        const std::vector<size_t> requeue = std::move(g_hook_registry.pending);
+        g_hook_registry.pending.clear();
+        for (size_t requeue_index : requeue)
+        {
+            attach_entry(requeue_index);
+        }
+        return;
+    }
+    g_hook_registry.pending.push_back(index);
+}
+} // namespace
+
+HookTransaction::HookTransaction()
+{
+    g_hook_registry.lock.lock();
+    if (g_hook_registry.depth++ == 0)
+    {
+        g_hook_registry.transaction_start = std::chrono::steady_clock::now();
+        DetourTransactionBegin();
+        DetourUpdateThread(GetCurrentThread());
+    }
+}
+HookTransaction::~HookTransaction()
+{
+    if (--g_hook_registry.depth == 0)
+    {
+        const auto commit_start = std::chrono::steady_clock::now();
+        const LONG error = DetourTransactionCommit();
+        const auto commit_time = std::chrono::steady_clock::now() - commit_start;
+        if (error != NO_ERROR)
+        {
+            DEBUG("Failed committing {} hooks: {}", g_hook_registry.pending.size(), error);
+        }
+
+        for (size_t index : g_hook_registry.pending)
+        {
+            HookInstallStats& stats = g_hook_registry.hooks[index].stats;
+            stats.error = error;
+            stats.installed = error == NO_ERROR;
+            stats.commit_time = commit_time;
+        }
+        if (!g_hook_registry.pending.empty())
+        {
+            DEBUG("Installed {} hooks in {:.3f} ms", g_hook_registry.pending.size(), std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - g_hook_registry.transaction_start).count());
+        }
+        g_hook_registry.pending.clear();
+    }
+    g_hook_registry.lock.unlock();
+}
+
+void attach_hook(std::string_view name, void** trampoline, void* detour)
+{
+    std::lock_guard lock{g_hook_registry.lock};
+    g_hook_registry.hooks.push_back(HookEntry{HookInstallStats{.name = std::string{name}}, trampoline, detour});
+    attach_entry(g_hook_registry.hooks.size() - 1);
+}
+
+void register_lazy_hook(std::string_view group, std::string_view name, void** trampoline, void* detour)
+{
+    std::lock_guard lock{g_hook_registry.lock};
+    g_hook_registry.hooks.push_back(HookEntry{HookInstallStats{.name = std::string{name}, .lazy_group = std::string{group}}, trampoline, detour});
+}
+
+void install_lazy_hooks(std::string_view group)
+{
+    std::lock_guard lock{g_hook_registry.lock};
+
+    std::vector<size_t> to_attach;
+    for (size_t i = 0; i < g_hook_registry.hooks.size(); ++i)
+    {
+        // Hooks that failed before are not retried, and neither are hooks already waiting in an outer transaction
+        const HookInstallStats& stats = g_hook_registry.hooks[i].stats;
+        if (!stats.installed && stats.error == NO_ERROR && stats.lazy_group == group &&
+            std::find(g_hook_registry.pending.begin(), g_hook_registry.pending.end(), i) == g_hook_registry.pending.end())
+        {
+            to_attach.push_back(i);
+        }
+    }
+    if (to_attach.empty())
+    {
+        return;
+    }
+
+    HookTransaction transaction;
+    for (size_t index : to_attach)
+    {
+        attach_entry(index);
+    }
+}
+
+std::vector<HookInstallStats> get_hook_install_stats()
+{
+    std::lock_guard lock{g_hook_registry.lock};
+    std::vector<HookInstallStats> stats;
+    stats.reserve(g_hook_registry.hooks.size());
+    for (const HookEntry& entry : g_hook_registry.hooks)
+    {
+        stats.push_back(entry.stats);
+    }
+    return stats;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>      // for nanoseconds
+#include <string>      // for string
+#include <string_view> // for string_view
+#include <vector>      // for vector
+
+struct HookInstallStats
+{
+    std::string name;
+    /// Lazy hooks are only attached once their group is requested with `install_lazy_hooks`
+    std::string lazy_group;
+    bool installed{false};
+    long error{0};
+    std::chrono::nanoseconds attach_time{0};
+    /// Time of the commit the hook went through, which is shared with every other hook in that transaction
+    std::chrono::nanoseconds commit_time{0};
+};
+
+/// Groups all hooks attached while it is alive into a single Detours transaction, which is committed when the outermost transaction ends.
+/// Every commit suspends threads and flushes the instruction cache, so startup code should attach everything inside one of these.
+/// A hook that fails to attach is left out of the transaction, the remaining hooks are still committed.
+class HookTransaction
+{
+  public:
+    HookTransaction();
+    ~HookTransaction();
+
+    HookTransaction(const HookTransaction&) = delete;
+    HookTransaction& operator=(const HookTransaction&) = delete;
+};
+
+/// Detours the function `*trampoline` points to with `detour`, as part of the current `HookTransaction` or on its own if there is none
+void attach_hook(std::string_view name, void** trampoline, void* detour);
+/// Remembers a hook without attaching it, it is attached together with the rest of `group` by the first call to `install_lazy_hooks(group)`
+void register_lazy_hook(std::string_view group, std::string_view name, void** trampoline, void* detour);
+/// Attaches all lazy hooks registered for `group` that are not attached yet
+void install_lazy_hooks(std::string_view group);
+
+std::vector<HookInstallStats> get_hook_install_stats();
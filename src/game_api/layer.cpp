@@ -1,9 +1,11 @@
 #include "layer.hpp"
 
-#include <cmath>   // for round, roundf
-#include <cstdint> // for uint32_t, uint8_t
-#include <cstdlib> // for abs
-#include <tuple>   // for tie, tuple
+#include <algorithm> // for find_if
+#include <bit>       // for countr_zero, has_single_bit
+#include <cmath>     // for round, roundf
+#include <cstdint>   // for uint32_t, uint8_t
+#include <cstdlib>   // for abs
+#include <tuple>     // for tie, tuple
 
 #include "entities_floors.hpp" // for ExitDoor
 #include "entity.hpp"          // for Entity, to_id, EntityDB, entity_factory
@@ -217,3 +219,65 @@ void Layer::move_grid_entity(Entity* ent, uint32_t x, uint32_t y, Layer* dest_la
         }
     }
 }
+
+struct MaskListsCacheEntry
+{
+    const Layer* layer{nullptr};
+    // The map only gets new nodes when it changes, so its first node and size tell whether the cached pointers are still good
+    const void* first_node{nullptr};
+    size_t map_size{0};
+    MaskEntityLists lists{};
+
+    bool is_valid_for(const Layer* other, const void* other_first_node) const
+    {
+        if (layer != other || first_node != other_first_node || map_size != other->entities_by_mask.size())
+        {
+            return false;
+        }
+        // The map may have been rebuilt into the same memory, so look every cached list up again, the old nodes may already be freed
+        for (size_t i = 0; i < lists.size(); ++i)
+        {
+            if (lists[i] != nullptr)
+            {
+                auto it = other->entities_by_mask.find(1u << i);
+                if (it == other->entities_by_mask.end() || &it->second != lists[i])
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+};
+// Front and back layer of the main and the local state
+thread_local std::array<MaskListsCacheEntry, 4> g_mask_lists_cache;
+thread_local size_t g_mask_lists_cache_next{0};
+
+const MaskEntityLists& Layer::get_mask_lists() const
+{
+    const void* first_node = entities_by_mask.empty() ? nullptr : &*entities_by_mask.begin();
+    for (const MaskListsCacheEntry& entry : g_mask_lists_cache)
+    {
+        if (entry.is_valid_for(this, first_node))
+        {
+            return entry.lists;
+        }
+    }
+
+    // Reuse the slot of this layer if it has one, otherwise evict round robin
+    auto it = std::find_if(g_mask_lists_cache.begin(), g_mask_lists_cache.end(), [this](const MaskListsCacheEntry& entry)
+                           { return entry.layer == this; });
+    MaskListsCacheEntry& entry = it != g_mask_lists_cache.end() ? *it : g_mask_lists_cache[g_mask_lists_cache_next++ % g_mask_lists_cache.size()];
+    entry.layer = this;
+    entry.first_node = first_node;
+    entry.map_size = entities_by_mask.size();
+    entry.lists.fill(nullptr);
+    for (const auto& [mask, entities] : entities_by_mask)
+    {
+        if (std::has_single_bit(mask) && mask < 0x8000)
+        {
+            entry.lists[std::countr_zero(mask)] = &entities;
+        }
+    }
+    return entry.lists;
+}
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>      // for array
 #include <cstddef>    // for size_t
 #include <cstdint>    // for uint32_t, int32_t, uint64_t, uint8_t
 #include <functional> // for less
@@ -117,6 +118,9 @@ struct EntityList
     }
 };
 
+// Lists of Layer::entities_by_mask indexed by the position of the mask bit, only masks with a single bit set are in there
+using MaskEntityLists = std::array<const EntityList*, 15>;
+
 struct Layer
 {
     bool is_back_layer;
@@ -197,4 +201,7 @@ struct Layer
 
     void move_grid_entity(Entity* ent, float x, float y, Layer* dest_layer);
     void move_grid_entity(Entity* ent, uint32_t x, uint32_t y, Layer* dest_layer);
+
+    // Cached lookup into entities_by_mask, rebuilt whenever the map changes, nullptr for masks the layer has no list for
+    const MaskEntityLists& get_mask_lists() const;
 };
@@ -3,11 +3,11 @@
 #include <Windows.h>     // for memchr, GetCurrentThread, LONG, NO_...
 #include <array>         // for array, _Array_iterator, _Array_cons...
 #include <assert.h>      // for assert
+#include <chrono>        // for steady_clock
 #include <cmath>         // for ceil, abs
 #include <cstddef>       // for byte
 #include <cstdlib>       // for size_t, abs
 #include <cstring>       // for memcpy, memchr
-#include <detours.h>     // for DetourAttach, DetourTransactionBegin
 #include <fmt/format.h>  // for check_format_string, format, vformat
 #include <iterator>      // for back_insert_iterator, back_inserter
 #include <list>          // for _List_iterator, _List_const_iterator
@@ -18,20 +18,25 @@
 #include <tuple>         // for tie, tuple
 #include <unordered_map> // for unordered_map, _Umap_traits<>::allo...
 
-#include "entities_monsters.hpp" // for GHOST_BEHAVIOR, GHOST_BEHAVIOR::MED...
-#include "entity.hpp"            // for to_id, Entity, get_entity_ptr, Enti...
-#include "layer.hpp"             // for Layer, g_level_max_y, g_level_max_x
-#include "logger.h"              // for DEBUG
-#include "memory.hpp"            // for to_le_bytes, write_mem_prot, Execut...
-#include "movable.hpp"           // for Movable
-#include "prng.hpp"              // for PRNG, PRNG::EXTRA_SPAWNS
-#include "rpc.hpp"               // for attach_entity, get_entities_overlap...
-#include "script/events.hpp"     // for post_load_screen, pre_load_screen
-#include "search.hpp"            // for get_address
-#include "spawn_api.hpp"         // for pop_spawn_type_flags, push_spawn_ty...
-#include "state.hpp"             // for StateMemory, State, enum_to_layer
-#include "util.hpp"              // for OnScopeExit, trim
-#include "vtable_hook.hpp"       // for hook_vtable
+#include "entities_monsters.hpp"    // for GHOST_BEHAVIOR, GHOST_BEHAVIOR::MED...
+#include "entity.hpp"               // for to_id, Entity, get_entity_ptr, Enti...
+#include "hook_registry.hpp"        // for attach_hook, HookTransaction
+#include "layer.hpp"                // for Layer, g_level_max_y, g_level_max_x
+#include "level_file_stats.hpp"     // for record_level_file_load
+#include "level_gen_replay.hpp"     // for LevelGenReplayRules
+#include "level_gen_trace.hpp"      // for trace_tile_code, trace_chance, LevelGenTrace
+#include "logger.h"                 // for DEBUG
+#include "memory.hpp"               // for to_le_bytes, write_mem_prot, Execut...
+#include "movable.hpp"              // for Movable
+#include "pending_tile_entries.hpp" // for PendingTileEntries
+#include "prng.hpp"                 // for PRNG, PRNG::EXTRA_SPAWNS
+#include "rpc.hpp"                  // for attach_entity, get_entities_overlap...
+#include "script/events.hpp"        // for post_load_screen, pre_load_screen
+#include "search.hpp"               // for get_address
+#include "spawn_api.hpp"            // for pop_spawn_type_flags, push_spawn_ty...
+#include "state.hpp"                // for StateMemory, State, enum_to_layer
+#include "util.hpp"                 // for OnScopeExit, trim
+#include "vtable_hook.hpp"          // for hook_vtable
 
 std::uint32_t g_last_tile_code_id;
 std::uint32_t g_last_community_tile_code_id;
@@ -41,10 +46,69 @@ std::uint32_t g_last_chance_id;
 std::uint32_t g_last_community_chance_id;
 std::uint32_t g_current_chance_id;
 
-std::unordered_map<std::uint32_t, std::string_view> g_tile_code_id_to_name;
-std::unordered_map<std::string_view, std::uint32_t> g_name_to_tile_code_id;
-std::unordered_map<std::uint32_t, std::string_view> g_monster_chance_id_to_name;
-std::unordered_map<std::uint32_t, std::string_view> g_trap_chance_id_to_name;
+// Names of things defined in LevelGenData, stored densely by id with a lookup by name
+// The views point at the keys of the game's own maps, whose nodes never move
+class LevelGenNameRegistry
+{
+  public:
+    void add(std::uint32_t id, std::string_view name)
+    {
+        if (id >= m_Names.size())
+        {
+            m_Names.resize(id + 1);
+        }
+        m_Names[id] = name;
+        m_Ids.insert_or_assign(name, id);
+    }
+
+    bool contains(std::uint32_t id) const
+    {
+        return id < m_Names.size() && !m_Names[id].empty();
+    }
+    std::string_view get_name(std::uint32_t id) const
+    {
+        return id < m_Names.size() ? m_Names[id] : std::string_view{};
+    }
+    std::optional<std::uint32_t> get_id(std::string_view name) const
+    {
+        if (auto it = m_Ids.find(name); it != m_Ids.end())
+        {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    template <class FunT>
+    void for_each_name(FunT&& fun) const
+    {
+        for (std::string_view name : m_Names)
+        {
+            if (!name.empty())
+            {
+                fun(name);
+            }
+        }
+    }
+
+  private:
+    std::vector<std::string_view> m_Names;
+    std::unordered_map<std::string_view, std::uint32_t> m_Ids;
+};
+LevelGenNameRegistry g_tile_codes;
+LevelGenNameRegistry g_room_templates;
+LevelGenNameRegistry g_monster_chances;
+LevelGenNameRegistry g_trap_chances;
+
+struct ShortTileCodeDefHash
+{
+    size_t operator()(const ShortTileCodeDef& def) const
+    {
+        return std::hash<std::uint64_t>{}((static_cast<std::uint64_t>(def.tile_code) << 32) ^ (static_cast<std::uint64_t>(def.alt_tile_code) << 8) ^ def.chance);
+    }
+};
+// Reverse index of LevelGenData::short_tile_codes, the game rewrites those whenever it loads level files so this is rebuilt lazily
+std::unordered_map<ShortTileCodeDef, std::uint8_t, ShortTileCodeDefHash> g_short_tile_code_index;
+bool g_short_tile_code_index_dirty{true};
 
 struct FloorRequiringEntity
 {
@@ -56,9 +120,8 @@ struct FloorRequiringEntity
     };
     std::vector<Position> pos;
     std::int32_t uid;
-    bool handled;
 };
-std::vector<FloorRequiringEntity> g_floor_requiring_entities;
+PendingTileEntries<FloorRequiringEntity> g_floor_requiring_entities;
 struct PendingEntitySpawn
 {
     struct Position
@@ -69,9 +132,8 @@ struct PendingEntitySpawn
     };
     std::vector<Position> pos;
     std::function<void()> try_spawn;
-    bool handled;
 };
-std::vector<PendingEntitySpawn> g_attachee_requiring_entities;
+PendingTileEntries<PendingEntitySpawn> g_attachee_requiring_entities;
 
 struct CommunityTileCode;
 
@@ -737,8 +799,21 @@ std::mutex g_extra_spawn_logic_providers_lock;
 std::uint32_t g_current_extra_spawn_id{0};
 std::vector<ExtraSpawnLogicProviderImpl> g_extra_spawn_logic_providers;
 
-std::vector<std::pair<uint16_t, RoomTemplateType>> g_room_template_types;
-std::vector<std::pair<uint16_t, std::pair<uint32_t, uint32_t>>> g_room_template_sizes;
+struct RoomTemplateInfo
+{
+    RoomTemplateType type{RoomTemplateType::None};
+    std::optional<std::pair<uint32_t, uint32_t>> size;
+};
+// Indexed by room template id
+std::vector<RoomTemplateInfo> g_room_template_infos;
+RoomTemplateInfo& get_room_template_info(uint16_t room_template)
+{
+    if (room_template >= g_room_template_infos.size())
+    {
+        g_room_template_infos.resize(room_template + 1);
+    }
+    return g_room_template_infos[room_template];
+}
 
 // Used for making custom machine rooms work
 std::optional<uint16_t> g_overridden_room_templates[2];
@@ -792,6 +867,8 @@ void level_gen(LevelGenSystem* level_gen_sys, float param_2, size_t param_3)
                     { pop_spawn_type_flags(SPAWN_TYPE_LEVEL_GEN_GENERAL); }};
 
     g_manual_room_datas.clear();
+    g_floor_requiring_entities.clear();
+    g_attachee_requiring_entities.clear();
 
     g_CustomRoomShims[0] = {};
     g_CustomRoomShims[1] = {};
@@ -799,6 +876,7 @@ void level_gen(LevelGenSystem* level_gen_sys, float param_2, size_t param_3)
     g_CustomShopTypes[0] = {};
     g_CustomShopTypes[1] = {};
 
+    trace_level_begin();
     pre_level_generation();
     g_level_gen_trampoline(level_gen_sys, param_2, param_3);
     post_level_generation();
@@ -829,6 +907,39 @@ void load_screen(StateMemory* state, size_t param_2, size_t param_3)
     post_load_screen();
 }
 
+std::uint32_t resolve_tile_code_alias(std::uint32_t tile_code, std::string_view tile_code_name)
+{
+    if (auto it = g_community_tile_code_aliases.find(tile_code_name); it != g_community_tile_code_aliases.end())
+    {
+        return g_tile_codes.get_id(it->second).value_or(0);
+    }
+    return tile_code;
+}
+const CommunityTileCode* get_community_tile_code(std::uint32_t tile_code)
+{
+    if (tile_code > g_last_tile_code_id && tile_code < g_last_community_tile_code_id)
+    {
+        return &g_community_tile_codes[tile_code - g_last_tile_code_id - 1];
+    }
+    return nullptr;
+}
+
+LevelGenReplayRules get_level_gen_replay_rules()
+{
+    LevelGenReplayRules rules;
+    g_tile_codes.for_each_name([&](std::string_view name)
+                               { rules.tile_codes.emplace(name); });
+    for (const auto& [alias, tile_code] : g_community_tile_code_aliases)
+    {
+        rules.aliases.emplace(alias, tile_code);
+    }
+    for (const CommunityTileCode& community_tile_code : g_community_tile_codes)
+    {
+        rules.community_tile_codes.emplace(community_tile_code.tile_code, community_tile_code.entity_type);
+    }
+    return rules;
+}
+
 using HandleTileCodeFun = void(LevelGenSystem*, std::uint32_t, std::uint64_t, float, float, std::uint8_t);
 HandleTileCodeFun* g_handle_tile_code_trampoline{nullptr};
 void handle_tile_code(LevelGenSystem* self, std::uint32_t tile_code, std::uint16_t room_template, float x, float y, std::uint8_t layer)
@@ -837,7 +948,11 @@ void handle_tile_code(LevelGenSystem* self, std::uint32_t tile_code, std::uint16
     OnScopeExit pop{[]
                     { pop_spawn_type_flags(SPAWN_TYPE_LEVEL_GEN_TILE_CODE); }};
 
-    std::string_view tile_code_name = g_tile_code_id_to_name[tile_code];
+    std::string_view tile_code_name = g_tile_codes.get_name(tile_code);
+    if (is_level_gen_trace_recording())
+    {
+        trace_tile_code(tile_code_name, self->get_room_template_name(room_template), x, y, layer);
+    }
 
     {
         const bool block_spawn = pre_tile_code_spawn(tile_code_name, x, y, layer, room_template);
@@ -847,18 +962,11 @@ void handle_tile_code(LevelGenSystem* self, std::uint32_t tile_code, std::uint16
         }
     }
 
-    if (g_community_tile_code_aliases.find(tile_code_name) != g_community_tile_code_aliases.end())
-    {
-        std::string_view tile_code_alias_name = g_community_tile_code_aliases[tile_code_name];
-        std::uint32_t tile_code_alias = g_name_to_tile_code_id[tile_code_alias_name];
-        tile_code = tile_code_alias;
-    }
-
-    if (tile_code > g_last_tile_code_id && tile_code < g_last_community_tile_code_id)
+    tile_code = resolve_tile_code_alias(tile_code, tile_code_name);
+    if (const CommunityTileCode* community_tile_code = get_community_tile_code(tile_code))
     {
         auto* layer_ptr = State::get().ptr_local()->layers[layer];
-        const CommunityTileCode& community_tile_code = g_community_tile_codes[tile_code - g_last_tile_code_id - 1];
-        community_tile_code.func(community_tile_code, x, y, layer_ptr);
+        community_tile_code->func(*community_tile_code, x, y, layer_ptr);
     }
     else
     {
@@ -884,55 +992,38 @@ void handle_tile_code(LevelGenSystem* self, std::uint32_t tile_code, std::uint16
     if (!g_floor_requiring_entities.empty())
     {
         Entity* floor{nullptr};
-        for (auto& pending_entity : g_floor_requiring_entities)
-        {
-            for (const auto& pos : pending_entity.pos)
-            {
-                if (std::abs(pos.x - x) < 0.01f && std::abs(pos.y - y) < 0.01f)
-                {
-                    if (auto* entity = get_entity_ptr(pending_entity.uid))
-                    {
-                        if (floor == nullptr)
-                        {
-                            auto* layer_ptr = State::get().ptr_local()->layers[layer];
-                            floor = layer_ptr->get_grid_entity_at(x, y);
-                        }
-
-                        if (floor != nullptr)
-                        {
-                            attach_entity(floor, entity);
-                            if (pos.angle)
-                            {
-                                entity->angle = pos.angle.value();
-                            }
-                            pending_entity.handled = true;
-                            break;
-                        }
-                    }
-                }
-            }
-        }
-
-        std::erase_if(g_floor_requiring_entities, [](const FloorRequiringEntity& ent)
-                      { return ent.handled || get_entity_ptr(ent.uid) == nullptr; });
+        g_floor_requiring_entities.handle_tile(x, y, [&](const FloorRequiringEntity& pending_entity, const FloorRequiringEntity::Position& pos)
+                                               {
+                                                   auto* entity = get_entity_ptr(pending_entity.uid);
+                                                   if (entity == nullptr)
+                                                   {
+                                                       return true;
+                                                   }
+
+                                                   if (floor == nullptr)
+                                                   {
+                                                       auto* layer_ptr = State::get().ptr_local()->layers[layer];
+                                                       floor = layer_ptr->get_grid_entity_at(x, y);
+                                                   }
+
+                                                   if (floor != nullptr)
+                                                   {
+                                                       attach_entity(floor, entity);
+                                                       if (pos.angle)
+                                                       {
+                                                           entity->angle = pos.angle.value();
+                                                       }
+                                                       return true;
+                                                   }
+                                                   return false; });
     }
 
     if (!g_attachee_requiring_entities.empty())
     {
-        for (auto& pending_spawn : g_attachee_requiring_entities)
-        {
-            for (const auto& pos : pending_spawn.pos)
-            {
-                if (std::abs(pos.x - x) < 0.01f && std::abs(pos.y - y) < 0.01f)
-                {
-                    pending_spawn.try_spawn();
-                    pending_spawn.handled = true;
-                }
-            }
-        }
-
-        std::erase_if(g_attachee_requiring_entities, [](const PendingEntitySpawn& ent)
-                      { return ent.handled; });
+        g_attachee_requiring_entities.handle_tile(x, y, [](const PendingEntitySpawn& pending_spawn, const PendingEntitySpawn::Position&)
+                                                  {
+                                                      pending_spawn.try_spawn();
+                                                      return true; });
     }
 }
 
@@ -942,6 +1033,7 @@ void setup_level_files(LevelGenData* level_gen_data, const char* level_file_name
 {
     pre_load_level_files();
     g_setup_level_files_trampoline(level_gen_data, level_file_name, load_generic);
+    g_short_tile_code_index_dirty = true;
 }
 
 ExecutableMemory g_get_room_size_redirect;
@@ -979,12 +1071,10 @@ void get_room_size(uint16_t room_template, uint32_t& room_width, uint32_t& room_
     }
     else
     {
-        auto it = std::find_if(g_room_template_sizes.begin(), g_room_template_sizes.end(), [room_template](auto& t)
-                               { return t.first == room_template; });
         // custom
-        if (it != g_room_template_sizes.end())
+        if (room_template < g_room_template_infos.size() && g_room_template_infos[room_template].size)
         {
-            std::tie(room_width, room_height) = it->second;
+            std::tie(room_width, room_height) = g_room_template_infos[room_template].size.value();
         }
         // default
         else
@@ -1009,21 +1099,28 @@ void get_room_size(const char* room_template_name, uint32_t& room_width, uint32_
 
 using LoadLevelFile = void(LevelGenData*, const char*);
 LoadLevelFile* g_load_level_file_trampoline{nullptr};
+void timed_load_level_file(LevelGenData* level_gen_data, const char* level_file_name)
+{
+    const auto start = std::chrono::steady_clock::now();
+    g_load_level_file_trampoline(level_gen_data, level_file_name);
+    record_level_file_load(level_file_name, std::chrono::steady_clock::now() - start);
+}
 void load_level_file(LevelGenData* level_gen_data, const char* level_file_name)
 {
     if (!g_levels_to_load.empty())
     {
         for (const std::string& level_file : g_levels_to_load)
         {
-            g_load_level_file_trampoline(level_gen_data, level_file.c_str());
+            timed_load_level_file(level_gen_data, level_file.c_str());
         }
         g_levels_to_load.clear();
     }
 
     if (!g_replace_level_loads)
     {
-        g_load_level_file_trampoline(level_gen_data, level_file_name);
+        timed_load_level_file(level_gen_data, level_file_name);
     }
+    g_short_tile_code_index_dirty = true;
 }
 
 using DoExtraSpawns = void(ThemeInfo*, std::uint32_t, std::uint32_t, std::uint32_t, std::uint8_t);
@@ -1234,7 +1331,12 @@ bool handle_chance(SpawnInfo* spawn_info)
     {
         if (community_chance.test_func(community_chance, spawn_info->x, spawn_info->y, layer_ptr))
         {
-            if (g_test_chance(&level_gen_data, community_chance.chance_id))
+            const bool spawn = g_test_chance(&level_gen_data, community_chance.chance_id);
+            if (is_level_gen_trace_recording())
+            {
+                trace_chance(community_chance.chance, spawn_info->x, spawn_info->y, layer, spawn);
+            }
+            if (spawn)
             {
                 community_chance.spawn_func(community_chance, spawn_info->x, spawn_info->y, layer_ptr);
                 return true;
@@ -1247,7 +1349,12 @@ bool handle_chance(SpawnInfo* spawn_info)
         {
             if (chance_provider.provider.is_valid(spawn_info->x, spawn_info->y, layer))
             {
-                if (g_test_chance(&level_gen_data, chance_provider.chance_id))
+                const bool spawn = g_test_chance(&level_gen_data, chance_provider.chance_id);
+                if (is_level_gen_trace_recording())
+                {
+                    trace_chance(g_monster_chances.get_name(chance_provider.chance_id), spawn_info->x, spawn_info->y, layer, spawn);
+                }
+                if (spawn)
                 {
                     chance_provider.provider.do_spawn(spawn_info->x, spawn_info->y, layer);
                     return true;
@@ -1278,12 +1385,17 @@ void LevelGenData::init()
     }
 
     {
-        g_room_template_types.push_back({to_uint(RoomTemplate::MachineBigroomPath), RoomTemplateType::VanillaMachineRoom});
-        g_room_template_types.push_back({to_uint(RoomTemplate::FeelingTomb), RoomTemplateType::VanillaMachineRoom});
-        g_room_template_types.push_back({to_uint(RoomTemplate::MachineWideroomPath), RoomTemplateType::VanillaMachineRoom});
-        g_room_template_types.push_back({to_uint(RoomTemplate::MachineWideroomSide), RoomTemplateType::VanillaMachineRoom});
-        g_room_template_types.push_back({to_uint(RoomTemplate::MachineTallroomPath), RoomTemplateType::VanillaMachineRoom});
-        g_room_template_types.push_back({to_uint(RoomTemplate::CoffinFrog), RoomTemplateType::VanillaMachineRoom});
+        get_room_template_info(to_uint(RoomTemplate::MachineBigroomPath)).type = RoomTemplateType::VanillaMachineRoom;
+        get_room_template_info(to_uint(RoomTemplate::FeelingTomb)).type = RoomTemplateType::VanillaMachineRoom;
+        get_room_template_info(to_uint(RoomTemplate::MachineWideroomPath)).type = RoomTemplateType::VanillaMachineRoom;
+        get_room_template_info(to_uint(RoomTemplate::MachineWideroomSide)).type = RoomTemplateType::VanillaMachineRoom;
+        get_room_template_info(to_uint(RoomTemplate::MachineTallroomPath)).type = RoomTemplateType::VanillaMachineRoom;
+        get_room_template_info(to_uint(RoomTemplate::CoffinFrog)).type = RoomTemplateType::VanillaMachineRoom;
+    }
+
+    for (auto& [name, def] : room_templates)
+    {
+        g_room_templates.add(def.id, name);
     }
 
     // Scan tile codes to know what id to start at
@@ -1293,8 +1405,7 @@ void LevelGenData::init()
         for (auto& [name, def] : tile_codes)
         {
             max_id = std::max(def.id, max_id);
-            g_tile_code_id_to_name[def.id] = name;
-            g_name_to_tile_code_id[name] = def.id;
+            g_tile_codes.add(def.id, name);
         }
 
         // The game uses last id to check if the tilecode is valid using a != instead of a <
@@ -1311,14 +1422,14 @@ void LevelGenData::init()
         for (auto& [name, def] : monster_chances)
         {
             max_id = std::max(def.id, max_id);
-            g_monster_chance_id_to_name[def.id] = name;
+            g_monster_chances.add(def.id, name);
         }
 
         // Getting the last id like this in case the game decides to skip some ids so that last_id != chances.size()
         for (auto& [name, def] : trap_chances)
         {
             max_id = std::max(def.id, max_id);
-            g_trap_chance_id_to_name[def.id] = name;
+            g_trap_chances.add(def.id, name);
         }
 
         // The game doesn't centrally handle chances so we can use whatever id
@@ -1451,26 +1562,18 @@ void LevelGenData::init()
 
         g_load_screen_trampoline = (LoadScreenFun*)get_address("load_screen_func"sv);
 
-        DetourTransactionBegin();
-        DetourUpdateThread(GetCurrentThread());
+        HookTransaction hooks;
+        attach_hook("level_gen", (void**)&g_level_gen_trampoline, level_gen);
+        attach_hook("level_gen_handle_tile_code", (void**)&g_handle_tile_code_trampoline, handle_tile_code);
+        attach_hook("level_gen_setup_level_files", (void**)&g_setup_level_files_trampoline, setup_level_files);
+        attach_hook("level_gen_load_level_file", (void**)&g_load_level_file_trampoline, load_level_file);
+        attach_hook("level_gen_do_extra_spawns", (void**)&g_do_extra_spawns_trampoline, do_extra_spawns);
+        attach_hook("level_gen_generate_room", (void**)&g_generate_room_trampoline, generate_room);
+        attach_hook("level_gen_gather_room_data", (void**)&g_gather_room_data_trampoline, gather_room_data);
+        attach_hook("level_gen_get_random_room_data", (void**)&g_get_random_room_data_trampoline, get_random_room_data);
+        attach_hook("level_gen_spawn_room_from_tile_codes", (void**)&g_spawn_room_from_tile_codes_trampoline, spawn_room_from_tile_codes);
 
-        DetourAttach((void**)&g_level_gen_trampoline, level_gen);
-        DetourAttach((void**)&g_handle_tile_code_trampoline, handle_tile_code);
-        DetourAttach((void**)&g_setup_level_files_trampoline, setup_level_files);
-        DetourAttach((void**)&g_load_level_file_trampoline, load_level_file);
-        DetourAttach((void**)&g_do_extra_spawns_trampoline, do_extra_spawns);
-        DetourAttach((void**)&g_generate_room_trampoline, generate_room);
-        DetourAttach((void**)&g_gather_room_data_trampoline, gather_room_data);
-        DetourAttach((void**)&g_get_random_room_data_trampoline, get_random_room_data);
-        DetourAttach((void**)&g_spawn_room_from_tile_codes_trampoline, spawn_room_from_tile_codes);
-
-        DetourAttach((void**)&g_load_screen_trampoline, load_screen);
-
-        const LONG error = DetourTransactionCommit();
-        if (error != NO_ERROR)
-        {
-            DEBUG("Failed hooking HandleTileCode: {}\n", error);
-        }
+        attach_hook("load_screen_func", (void**)&g_load_screen_trampoline, load_screen);
     }
 
     g_test_chance = (TestChance*)get_address("level_gen_test_spawn_chance");
@@ -1478,9 +1581,16 @@ void LevelGenData::init()
 
 std::optional<std::uint32_t> LevelGenData::get_tile_code(const std::string& tile_code)
 {
+    if (auto id = g_tile_codes.get_id(tile_code))
+    {
+        return id;
+    }
+
+    // Fall back to the game's map in case something was added behind our back
     auto it = tile_codes.find((game_string&)tile_code);
     if (it != tile_codes.end())
     {
+        g_tile_codes.add(it->second.id, it->first);
         return it->second.id;
     }
     return {};
@@ -1495,17 +1605,37 @@ std::uint32_t LevelGenData::define_tile_code(std::string tile_code)
     auto [it, success] = tile_codes.emplace(tile_code.c_str(), TileCodeDef{g_current_tile_code_id});
     g_current_tile_code_id++;
 
-    g_tile_code_id_to_name[it->second.id] = it->first;
-    g_name_to_tile_code_id[it->first] = it->second.id;
+    g_tile_codes.add(it->second.id, it->first);
     return it->second.id;
 }
 
 std::optional<uint8_t> LevelGenData::get_short_tile_code(ShortTileCodeDef short_tile_code_def)
 {
+    if (g_short_tile_code_index_dirty)
+    {
+        g_short_tile_code_index.clear();
+        for (auto [i, def] : short_tile_codes)
+        {
+            g_short_tile_code_index.try_emplace(def, i);
+        }
+        g_short_tile_code_index_dirty = false;
+    }
+
+    // Validate hits in case the game changed short tile codes without going through one of our hooks
+    if (auto it = g_short_tile_code_index.find(short_tile_code_def); it != g_short_tile_code_index.end())
+    {
+        auto def_it = short_tile_codes.find(it->second);
+        if (def_it != short_tile_codes.end() && def_it->second == short_tile_code_def)
+        {
+            return it->second;
+        }
+    }
+
     for (auto [i, def] : short_tile_codes)
     {
         if (def == short_tile_code_def)
         {
+            g_short_tile_code_index_dirty = true;
             return i;
         }
     }
@@ -1523,6 +1653,7 @@ std::optional<ShortTileCodeDef> LevelGenData::get_short_tile_code_def(uint8_t sh
 void LevelGenData::change_short_tile_code(uint8_t short_tile_code, ShortTileCodeDef short_tile_code_def)
 {
     short_tile_codes[short_tile_code] = short_tile_code_def;
+    g_short_tile_code_index_dirty = true;
 }
 std::optional<uint8_t> LevelGenData::define_short_tile_code(ShortTileCodeDef short_tile_code_def)
 {
@@ -1548,6 +1679,7 @@ std::optional<uint8_t> LevelGenData::define_short_tile_code(ShortTileCodeDef sho
     if (smallest_match.has_value())
     {
         short_tile_codes[smallest_match.value()] = short_tile_code_def;
+        g_short_tile_code_index_dirty = true;
         return smallest_match;
     }
 
@@ -1573,10 +1705,20 @@ std::pair<const game_string, ChanceDef>& get_or_emplace_chance(game_unordered_ma
 
 std::optional<std::uint32_t> LevelGenData::get_chance(const std::string& chance)
 {
+    if (auto id = g_monster_chances.get_id(chance))
+    {
+        return id;
+    }
+    if (auto id = g_trap_chances.get_id(chance))
+    {
+        return id;
+    }
+
     {
         auto it = monster_chances.find((game_string&)chance);
         if (it != monster_chances.end())
         {
+            g_monster_chances.add(it->second.id, it->first);
             return it->second.id;
         }
     }
@@ -1584,6 +1726,7 @@ std::optional<std::uint32_t> LevelGenData::get_chance(const std::string& chance)
         auto it = trap_chances.find((game_string&)chance);
         if (it != trap_chances.end())
         {
+            g_trap_chances.add(it->second.id, it->first);
             return it->second.id;
         }
     }
@@ -1601,7 +1744,7 @@ std::uint32_t LevelGenData::define_chance(std::string chance)
     this_chance.id = g_current_chance_id;
     g_current_chance_id++;
 
-    g_monster_chance_id_to_name[this_chance.id] = chance_str;
+    g_monster_chances.add(this_chance.id, chance_str);
     return this_chance.id;
 }
 
@@ -1680,9 +1823,16 @@ void LevelGenData::undefine_extra_spawn(std::uint32_t extra_spawn_id)
 
 std::optional<std::uint16_t> LevelGenData::get_room_template(const std::string& room_template)
 {
+    if (auto id = g_room_templates.get_id(room_template))
+    {
+        return static_cast<std::uint16_t>(id.value());
+    }
+
+    // Fall back to the game's map in case something was added behind our back
     auto it = room_templates.find((game_string&)room_template);
     if (it != room_templates.end())
     {
+        g_room_templates.add(it->second.id, it->first);
         return it->second.id;
     }
     return {};
@@ -1695,35 +1845,33 @@ std::uint16_t LevelGenData::define_room_template(std::string room_template, Room
     }
 
     auto [it, success] = room_templates.emplace(std::move(room_template), RoomTemplateDef{(uint16_t)room_templates.size()});
+    g_room_templates.add(it->second.id, it->first);
 
     if (type != RoomTemplateType::None)
     {
-        g_room_template_types.push_back({it->second.id, type});
+        RoomTemplateInfo& info = get_room_template_info(it->second.id);
+        info.type = type;
         if (type == RoomTemplateType::MachineRoom)
         {
-            g_room_template_sizes.push_back({it->second.id, {10, 8}});
+            info.size = {10, 8};
         }
     }
     return it->second.id;
 }
 bool LevelGenData::set_room_template_size(std::uint16_t room_template, uint16_t width, uint16_t height)
 {
-    auto it = std::find_if(g_room_template_sizes.begin(), g_room_template_sizes.end(), [room_template](auto& t)
-                           { return t.first == room_template; });
-    if (it != g_room_template_sizes.end())
+    if (room_template < g_room_template_infos.size() && g_room_template_infos[room_template].size)
     {
-        it->second = {width, height};
+        g_room_template_infos[room_template].size = {width, height};
         return true;
     }
     return false;
 }
 RoomTemplateType LevelGenData::get_room_template_type(std::uint16_t room_template)
 {
-    auto it = std::find_if(g_room_template_types.begin(), g_room_template_types.end(), [room_template](auto& t)
-                           { return t.first == room_template; });
-    if (it != g_room_template_types.end())
+    if (room_template < g_room_template_infos.size())
     {
-        return it->second;
+        return g_room_template_infos[room_template].type;
     }
     return RoomTemplateType::None;
 }
@@ -1892,10 +2040,16 @@ bool LevelGenSystem::set_shop_type(uint32_t x, uint32_t y, uint8_t l, ShopType _
 
 std::string_view LevelGenSystem::get_room_template_name(uint16_t room_template)
 {
+    if (g_room_templates.contains(room_template))
+    {
+        return g_room_templates.get_name(room_template);
+    }
+
     for (const auto& [name, room_tpl] : data->room_templates)
     {
         if (room_tpl.id == room_template)
         {
+            g_room_templates.add(room_tpl.id, name);
             return name;
         }
     }
@@ -1921,7 +2075,7 @@ LevelChanceDef& get_or_emplace_level_chance(game_unordered_map<std::uint32_t, Le
 
 uint32_t LevelGenSystem::get_procedural_spawn_chance(uint32_t chance_id)
 {
-    if (g_monster_chance_id_to_name.contains(chance_id))
+    if (g_monster_chances.contains(chance_id))
     {
         LevelChanceDef& this_chances = get_or_emplace_level_chance(data->level_monster_chances, chance_id);
         if (!this_chances.chances.empty())
@@ -1938,7 +2092,7 @@ uint32_t LevelGenSystem::get_procedural_spawn_chance(uint32_t chance_id)
         }
     }
 
-    if (g_trap_chance_id_to_name.contains(chance_id))
+    if (g_trap_chances.contains(chance_id))
     {
         LevelChanceDef& this_chances = get_or_emplace_level_chance(data->level_trap_chances, chance_id);
         if (!this_chances.chances.empty())
@@ -1959,7 +2113,7 @@ uint32_t LevelGenSystem::get_procedural_spawn_chance(uint32_t chance_id)
 }
 bool LevelGenSystem::set_procedural_spawn_chance(uint32_t chance_id, uint32_t inverse_chance)
 {
-    if (g_monster_chance_id_to_name.contains(chance_id))
+    if (g_monster_chances.contains(chance_id))
     {
         LevelChanceDef& this_chances = get_or_emplace_level_chance(data->level_monster_chances, chance_id);
         if (inverse_chance == 0)
@@ -1973,7 +2127,7 @@ bool LevelGenSystem::set_procedural_spawn_chance(uint32_t chance_id, uint32_t in
         return true;
     }
 
-    if (g_trap_chance_id_to_name.contains(chance_id))
+    if (g_trap_chances.contains(chance_id))
     {
         LevelChanceDef& this_chances = get_or_emplace_level_chance(data->level_trap_chances, chance_id);
         if (inverse_chance == 0)
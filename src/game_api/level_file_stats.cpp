@@ -0,0 +1,35 @@
+#include "level_file_stats.hpp"
+
+#include <mutex>         // for mutex, lock_guard
+#include <unordered_map> // for unordered_map
+
+namespace
+{
+std::mutex g_level_file_stats_lock;
+std::unordered_map<std::string, LevelFileLoadStats> g_level_file_stats;
+} // namespace
+
+void record_level_file_load(std::string_view file, std::chrono::nanoseconds time)
+{
+    std::lock_guard lock{g_level_file_stats_lock};
+    auto [it, inserted] = g_level_file_stats.try_emplace(std::string{file});
+    LevelFileLoadStats& stats = it->second;
+    if (inserted)
+    {
+        stats.file = it->first;
+    }
+    stats.loads++;
+    stats.last_time = time;
+    stats.total_time += time;
+}
+std::vector<LevelFileLoadStats> get_level_file_load_stats()
+{
+    std::lock_guard lock{g_level_file_stats_lock};
+    std::vector<LevelFileLoadStats> stats;
+    stats.reserve(g_level_file_stats.size());
+    for (const auto& [file, file_stats] : g_level_file_stats)
+    {
+        stats.push_back(file_stats);
+    }
+    return stats;
+}
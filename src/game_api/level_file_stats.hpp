@@ -0,0 +1,19 @@
+#pragma once
+
+#include <chrono>      // for nanoseconds
+#include <cstdint>     // for uint32_t
+#include <string>      // for string
+#include <string_view> // for string_view
+#include <vector>      // for vector
+
+struct LevelFileLoadStats
+{
+    std::string file;
+    uint32_t loads{0};
+    std::chrono::nanoseconds last_time{0};
+    std::chrono::nanoseconds total_time{0};
+};
+
+/// Adds a timing sample for the game parsing `file`
+void record_level_file_load(std::string_view file, std::chrono::nanoseconds time);
+std::vector<LevelFileLoadStats> get_level_file_load_stats();
@@ -0,0 +1,83 @@
+#include "level_gen_replay.hpp"
+
+#include <utility> // for move
+
+LevelGenReplayer::LevelGenReplayer(const LevelGenReplayRules& rules, LevelGenReplaySpawner& spawner)
+    : m_Rules{rules}, m_Spawner{spawner}
+{
+}
+
+LevelGenReplayStats LevelGenReplayer::replay(const LevelGenTrace& trace)
+{
+    m_Stats = {};
+    m_PendingEntities.clear();
+
+    const auto start = std::chrono::steady_clock::now();
+    for (const LevelGenTraceRecord& record : trace.records)
+    {
+        switch (record.event)
+        {
+        case LevelGenTraceEvent::LevelBegin:
+            m_Stats.levels++;
+            m_PendingEntities.clear();
+            break;
+        case LevelGenTraceEvent::TileCode:
+            replay_tile_code(trace.names[record.name_index], trace.names[record.room_template_index], record.x, record.y, record.layer);
+            break;
+        case LevelGenTraceEvent::Chance:
+            m_Stats.chance_rolls++;
+            if (record.result)
+            {
+                m_Stats.successful_chance_rolls++;
+            }
+            break;
+        }
+    }
+    m_Stats.replay_time = std::chrono::steady_clock::now() - start;
+    return m_Stats;
+}
+
+void LevelGenReplayer::add_pending_entity(uint32_t id, std::vector<Position> positions)
+{
+    m_PendingEntities.push_back(PendingEntity{std::move(positions), id});
+    m_Stats.pending_entities++;
+}
+
+void LevelGenReplayer::replay_tile_code(std::string_view tile_code, std::string_view room_template, float x, float y, uint8_t layer)
+{
+    m_Stats.tile_codes++;
+    if (!m_Rules.tile_codes.contains(tile_code))
+    {
+        m_Stats.unknown_tile_codes++;
+        return;
+    }
+
+    // Same order as handle_tile_code, aliases first and community tile codes are picked by what the alias resolved to
+    if (auto it = m_Rules.aliases.find(tile_code); it != m_Rules.aliases.end())
+    {
+        m_Stats.aliased_tile_codes++;
+        tile_code = it->second;
+    }
+
+    if (auto it = m_Rules.community_tile_codes.find(tile_code); it != m_Rules.community_tile_codes.end())
+    {
+        m_Stats.community_tile_codes++;
+        m_Spawner.spawn_community_tile_code(*this, tile_code, it->second, x, y, layer);
+    }
+    else
+    {
+        m_Spawner.spawn_tile_code(*this, tile_code, room_template, x, y, layer);
+    }
+
+    if (!m_PendingEntities.empty())
+    {
+        m_PendingEntities.handle_tile(x, y, [&](const PendingEntity& pending_entity, const Position& pos)
+                                      {
+                                          if (m_Spawner.resolve_pending_entity(pending_entity.id, pos.x, pos.y, layer))
+                                          {
+                                              m_Stats.resolved_pending_entities++;
+                                              return true;
+                                          }
+                                          return false; });
+    }
+}
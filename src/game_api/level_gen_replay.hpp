@@ -0,0 +1,111 @@
+#pragma once
+
+#include <chrono>        // for nanoseconds
+#include <cstddef>       // for size_t
+#include <cstdint>       // for uint8_t, uint32_t
+#include <functional>    // for hash, equal_to
+#include <string>        // for string
+#include <string_view>   // for string_view
+#include <unordered_map> // for unordered_map
+#include <unordered_set> // for unordered_set
+#include <vector>        // for vector
+
+#include "level_gen_trace.hpp"      // for LevelGenTrace
+#include "pending_tile_entries.hpp" // for PendingTileEntries
+
+/// The tile code setup of a session by name, which is all a replay needs to decide what each traced tile code turns into
+struct LevelGenReplayRules
+{
+    // Allows lookups by string_view, so replaying doesn't allocate a string per tile code
+    struct NameHash
+    {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view name) const
+        {
+            return std::hash<std::string_view>{}(name);
+        }
+    };
+    template <class T>
+    using NameMap = std::unordered_map<std::string, T, NameHash, std::equal_to<>>;
+
+    /// Every tile code that can be placed, including community tile codes
+    std::unordered_set<std::string, NameHash, std::equal_to<>> tile_codes;
+    /// Alternative names, map of new_name: existing_name
+    NameMap<std::string> aliases;
+    /// Community tile codes and the entity type they spawn
+    NameMap<std::string> community_tile_codes;
+};
+/// Rules of the current session, only available in game
+LevelGenReplayRules get_level_gen_replay_rules();
+
+class LevelGenReplayer;
+
+/// Receives what a replay decides to spawn, the base class spawns nothing
+class LevelGenReplaySpawner
+{
+  public:
+    virtual ~LevelGenReplaySpawner() = default;
+
+    /// A tile code the game handles itself, `tile_code` is the name after resolving aliases
+    virtual void spawn_tile_code(LevelGenReplayer& /*replayer*/, std::string_view /*tile_code*/, std::string_view /*room_template*/, float /*x*/, float /*y*/, uint8_t /*layer*/)
+    {
+    }
+    /// A community tile code, which may make entities wait for a neighbouring tile through `LevelGenReplayer::add_pending_entity`
+    virtual void spawn_community_tile_code(LevelGenReplayer& /*replayer*/, std::string_view /*tile_code*/, std::string_view /*entity_type*/, float /*x*/, float /*y*/, uint8_t /*layer*/)
+    {
+    }
+    /// Called for a pending entity once a tile it waits for was spawned, returning false keeps it waiting for its other positions
+    virtual bool resolve_pending_entity(uint32_t /*id*/, float /*x*/, float /*y*/, uint8_t /*layer*/)
+    {
+        return true;
+    }
+};
+
+struct LevelGenReplayStats
+{
+    size_t levels{0};
+    size_t tile_codes{0};
+    size_t aliased_tile_codes{0};
+    size_t community_tile_codes{0};
+    /// Tile codes that are not defined by the rules, those are skipped
+    size_t unknown_tile_codes{0};
+    size_t chance_rolls{0};
+    size_t successful_chance_rolls{0};
+    size_t pending_entities{0};
+    size_t resolved_pending_entities{0};
+    std::chrono::nanoseconds replay_time{0};
+};
+
+/// Feeds a recorded trace through the same steps `handle_tile_code` takes, alias resolution, picking community tile codes
+/// and handing entities that wait for a tile to be spawned to that tile, with `spawner` standing in for the game.
+/// Script callbacks and chance rolls are not replayed, chance rolls are only counted with their recorded result.
+class LevelGenReplayer
+{
+  public:
+    struct Position
+    {
+        float x;
+        float y;
+    };
+
+    LevelGenReplayer(const LevelGenReplayRules& rules, LevelGenReplaySpawner& spawner);
+
+    LevelGenReplayStats replay(const LevelGenTrace& trace);
+
+    /// Makes `id` wait until a tile code at one of `positions` was handled, pending entities are dropped at the start of each level like in game
+    void add_pending_entity(uint32_t id, std::vector<Position> positions);
+
+  private:
+    void replay_tile_code(std::string_view tile_code, std::string_view room_template, float x, float y, uint8_t layer);
+
+    struct PendingEntity
+    {
+        std::vector<Position> pos;
+        uint32_t id;
+    };
+
+    const LevelGenReplayRules& m_Rules;
+    LevelGenReplaySpawner& m_Spawner;
+    PendingTileEntries<PendingEntity> m_PendingEntities;
+    LevelGenReplayStats m_Stats;
+};
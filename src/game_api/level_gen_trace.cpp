@@ -0,0 +1,250 @@
+#include "level_gen_trace.hpp"
+
+#include <atomic>        // for atomic_bool
+#include <cstddef>       // for size_t
+#include <cstring>       // for memcpy
+#include <fstream>       // for ifstream, ofstream
+#include <iterator>      // for istreambuf_iterator
+#include <mutex>         // for mutex, lock_guard
+#include <unordered_map> // for unordered_map
+#include <utility>       // for move, exchange
+
+#include "logger.h" // for DEBUG
+
+namespace
+{
+constexpr char g_trace_magic[4]{'O', 'L', 'G', 'T'};
+constexpr uint32_t g_trace_version{2};
+
+struct LevelGenTraceRecorder
+{
+    std::mutex lock;
+    // Checked without taking the lock, so tracing costs nothing on the level gen hot paths while not recording
+    std::atomic_bool recording{false};
+    LevelGenTrace trace;
+    std::unordered_map<std::string, uint16_t> name_indices;
+};
+LevelGenTraceRecorder g_recorder;
+
+uint16_t intern_recorded_name(std::string_view name)
+{
+    auto [it, inserted] = g_recorder.name_indices.try_emplace(std::string{name}, static_cast<uint16_t>(g_recorder.trace.names.size()));
+    if (inserted)
+    {
+        g_recorder.trace.names.push_back(it->first);
+    }
+    return it->second;
+}
+
+template <class T>
+void write_value(std::vector<char>& out, const T& value)
+{
+    const auto* bytes = reinterpret_cast<const char*>(&value);
+    out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+template <class T>
+bool read_value(const std::vector<char>& in, size_t& offset, T& value)
+{
+    if (offset + sizeof(T) > in.size())
+    {
+        return false;
+    }
+    memcpy(&value, in.data() + offset, sizeof(T));
+    offset += sizeof(T);
+    return true;
+}
+} // namespace
+
+void start_level_gen_trace()
+{
+    std::lock_guard lock{g_recorder.lock};
+    g_recorder.trace = {};
+    g_recorder.name_indices.clear();
+    g_recorder.recording = true;
+}
+LevelGenTrace stop_level_gen_trace()
+{
+    std::lock_guard lock{g_recorder.lock};
+    g_recorder.recording = false;
+    g_recorder.name_indices.clear();
+    return std::exchange(g_recorder.trace, {});
+}
+bool is_level_gen_trace_recording()
+{
+    return g_recorder.recording;
+}
+
+void trace_level_begin()
+{
+    if (!g_recorder.recording)
+    {
+        return;
+    }
+
+    std::lock_guard lock{g_recorder.lock};
+    if (g_recorder.recording)
+    {
+        g_recorder.trace.records.push_back({.event = LevelGenTraceEvent::LevelBegin});
+    }
+}
+void trace_tile_code(std::string_view tile_code, std::string_view room_template, float x, float y, uint8_t layer)
+{
+    if (!g_recorder.recording)
+    {
+        return;
+    }
+
+    std::lock_guard lock{g_recorder.lock};
+    if (g_recorder.recording)
+    {
+        g_recorder.trace.records.push_back({
+            .event = LevelGenTraceEvent::TileCode,
+            .name_index = intern_recorded_name(tile_code),
+            .room_template_index = intern_recorded_name(room_template),
+            .x = x,
+            .y = y,
+            .layer = layer,
+        });
+    }
+}
+void trace_chance(std::string_view chance, float x, float y, uint8_t layer, bool result)
+{
+    if (!g_recorder.recording)
+    {
+        return;
+    }
+
+    std::lock_guard lock{g_recorder.lock};
+    if (g_recorder.recording)
+    {
+        g_recorder.trace.records.push_back({
+            .event = LevelGenTraceEvent::Chance,
+            .name_index = intern_recorded_name(chance),
+            .x = x,
+            .y = y,
+            .layer = layer,
+            .result = result,
+        });
+    }
+}
+
+bool save_level_gen_trace(const LevelGenTrace& trace, const std::string& file_path)
+{
+    std::vector<char> data;
+    data.insert(data.end(), std::begin(g_trace_magic), std::end(g_trace_magic));
+    write_value(data, g_trace_version);
+
+    write_value(data, static_cast<uint32_t>(trace.names.size()));
+    for (const std::string& name : trace.names)
+    {
+        write_value(data, static_cast<uint16_t>(name.size()));
+        data.insert(data.end(), name.begin(), name.end());
+    }
+
+    // Level begin markers are a single byte, everything else is stored without padding
+    write_value(data, static_cast<uint32_t>(trace.records.size()));
+    for (const LevelGenTraceRecord& record : trace.records)
+    {
+        write_value(data, record.event);
+        if (record.event == LevelGenTraceEvent::LevelBegin)
+        {
+            continue;
+        }
+
+        write_value(data, record.name_index);
+        if (record.event == LevelGenTraceEvent::TileCode)
+        {
+            write_value(data, record.room_template_index);
+        }
+        write_value(data, record.x);
+        write_value(data, record.y);
+        write_value(data, record.layer);
+        if (record.event == LevelGenTraceEvent::Chance)
+        {
+            write_value(data, static_cast<uint8_t>(record.result));
+        }
+    }
+
+    std::ofstream out(file_path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!out)
+    {
+        DEBUG("Could not write level gen trace {}", file_path);
+        return false;
+    }
+    return true;
+}
+std::optional<LevelGenTrace> load_level_gen_trace(const std::string& file_path)
+{
+    std::ifstream in(file_path, std::ios::binary);
+    if (!in)
+    {
+        return std::nullopt;
+    }
+    const std::vector<char> data{std::istreambuf_iterator<char>{in}, std::istreambuf_iterator<char>{}};
+
+    size_t offset{0};
+    char magic[4];
+    uint32_t version;
+    if (!read_value(data, offset, magic) || memcmp(magic, g_trace_magic, sizeof(magic)) != 0 ||
+        !read_value(data, offset, version) || version != g_trace_version)
+    {
+        DEBUG("{} is not a level gen trace", file_path);
+        return std::nullopt;
+    }
+
+    LevelGenTrace trace;
+    uint32_t name_count;
+    if (!read_value(data, offset, name_count))
+    {
+        return std::nullopt;
+    }
+    for (uint32_t i = 0; i < name_count; ++i)
+    {
+        uint16_t name_size;
+        if (!read_value(data, offset, name_size) || offset + name_size > data.size())
+        {
+            return std::nullopt;
+        }
+        trace.names.emplace_back(data.data() + offset, name_size);
+        offset += name_size;
+    }
+
+    uint32_t record_count;
+    if (!read_value(data, offset, record_count))
+    {
+        return std::nullopt;
+    }
+    trace.records.reserve(record_count);
+    for (uint32_t i = 0; i < record_count; ++i)
+    {
+        LevelGenTraceRecord record{};
+        if (!read_value(data, offset, record.event) || record.event > LevelGenTraceEvent::Chance)
+        {
+            return std::nullopt;
+        }
+
+        if (record.event != LevelGenTraceEvent::LevelBegin)
+        {
+            bool valid = read_value(data, offset, record.name_index) && record.name_index < trace.names.size();
+            if (record.event == LevelGenTraceEvent::TileCode)
+            {
+                valid = valid && read_value(data, offset, record.room_template_index) && record.room_template_index < trace.names.size();
+            }
+            valid = valid && read_value(data, offset, record.x) && read_value(data, offset, record.y) && read_value(data, offset, record.layer);
+            if (record.event == LevelGenTraceEvent::Chance)
+            {
+                uint8_t result;
+                valid = valid && read_value(data, offset, result);
+                record.result = result != 0;
+            }
+            if (!valid)
+            {
+                DEBUG("Level gen trace {} is truncated", file_path);
+                return std::nullopt;
+            }
+        }
+        trace.records.push_back(record);
+    }
+    return trace;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>     // for uint8_t, uint16_t
+#include <optional>    // for optional
+#include <string>      // for string
+#include <string_view> // for string_view
+#include <vector>      // for vector
+
+enum class LevelGenTraceEvent : uint8_t
+{
+    LevelBegin,
+    TileCode,
+    Chance,
+};
+
+struct LevelGenTraceRecord
+{
+    LevelGenTraceEvent event;
+    /// Index into `LevelGenTrace::names`, names are stored instead of ids since ids depend on what mods defined
+    uint16_t name_index{0};
+    /// Index into `LevelGenTrace::names` of the room template a tile code was placed in
+    uint16_t room_template_index{0};
+    float x{0.0f};
+    float y{0.0f};
+    uint8_t layer{0};
+    /// Result of chance rolls
+    bool result{false};
+};
+
+struct LevelGenTrace
+{
+    std::vector<std::string> names;
+    std::vector<LevelGenTraceRecord> records;
+};
+
+/// Starts recording the tile codes and chance rolls of all following level generations, clearing any previous recording
+void start_level_gen_trace();
+/// Stops recording and returns everything recorded since `start_level_gen_trace`
+LevelGenTrace stop_level_gen_trace();
+bool is_level_gen_trace_recording();
+
+void trace_level_begin();
+void trace_tile_code(std::string_view tile_code, std::string_view room_template, float x, float y, uint8_t layer);
+void trace_chance(std::string_view chance, float x, float y, uint8_t layer, bool result);
+
+bool save_level_gen_trace(const LevelGenTrace& trace, const std::string& file_path);
+std::optional<LevelGenTrace> load_level_gen_trace(const std::string& file_path);
@@ -3,27 +3,20 @@
 #include <cstdlib>       // for exit
 #include <cstring>       // for memcpy
 #include <functional>    // for equal_to
+#include <map>           // for map
 #include <new>           // for operator new
 #include <unordered_map> // for unordered_map, _Umap_traits<>::allocator_type
 #include <utility>       // for min, max
 #include <vector>        // for vector, _Vector_iterator, _Vector_const_ite...
 
+#include "code_cave.hpp" // for code_cave_alloc, code_cave_free, code_cave_write, CodeCaveKind
+
 ExecutableMemory::ExecutableMemory(std::string_view raw_code)
 {
-    SYSTEM_INFO system_info;
-    GetSystemInfo(&system_info);
-
-    auto const page_size = system_info.dwPageSize;
-    auto const alloc_size = (raw_code.size() / page_size + 1) * page_size;
-
-    auto const memory = (std::byte*)VirtualAlloc(nullptr, page_size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+    auto const memory = (std::byte*)code_cave_alloc(CodeCaveKind::Code, raw_code.size());
     if (memory)
     {
-        std::memcpy(memory, raw_code.data(), raw_code.size());
-
-        DWORD dummy;
-        VirtualProtect(memory, alloc_size, PAGE_EXECUTE_READ, &dummy);
-
+        code_cave_write(memory, raw_code);
         code = storage_t{memory};
     }
     else
@@ -34,7 +27,7 @@ ExecutableMemory::ExecutableMemory(std::string_view raw_code)
 
 void ExecutableMemory::deleter_t::operator()(std::byte* mem) const
 {
-    VirtualFree(mem, 0, MEM_RELEASE);
+    code_cave_free(mem);
 }
 
 size_t round_up(size_t i, size_t div)
@@ -42,11 +35,63 @@ size_t round_up(size_t i, size_t div)
     return ((i + div - 1) / div) * div;
 }
 
+struct MemoryPatchBatchState
+{
+    uint32_t depth{0};
+    // Original protection of every page touched by the current batch
+    std::map<size_t, DWORD> pages;
+};
+thread_local MemoryPatchBatchState g_patch_batch;
+
+MemoryPatchBatch::MemoryPatchBatch()
+{
+    g_patch_batch.depth++;
+}
+MemoryPatchBatch::~MemoryPatchBatch()
+{
+    if (--g_patch_batch.depth != 0)
+    {
+        return;
+    }
+
+    // Restore runs of adjacent pages that had the same protection in one go
+    auto it = g_patch_batch.pages.begin();
+    while (it != g_patch_batch.pages.end())
+    {
+        const size_t first_page = it->first;
+        const DWORD protect = it->second;
+        size_t end_page = first_page + 0x1000;
+        for (++it; it != g_patch_batch.pages.end() && it->first == end_page && it->second == protect; ++it)
+        {
+            end_page += 0x1000;
+        }
+
+        DWORD old_protect;
+        VirtualProtect((LPVOID)first_page, end_page - first_page, protect, &old_protect);
+    }
+    g_patch_batch.pages.clear();
+}
+
 void write_mem_prot(size_t addr, std::string_view payload, bool prot)
 {
     DWORD old_protect = 0;
     auto page = addr & ~0xFFF;
     auto size = round_up((addr + payload.size() - page), 0x1000);
+    if (prot && g_patch_batch.depth != 0)
+    {
+        // Protection differs per page, so unprotect each page on its own the first time the batch touches it
+        for (size_t batch_page = page; batch_page < page + size; batch_page += 0x1000)
+        {
+            if (!g_patch_batch.pages.contains(batch_page))
+            {
+                VirtualProtect((LPVOID)batch_page, 0x1000, PAGE_EXECUTE_READWRITE, &old_protect);
+                g_patch_batch.pages[batch_page] = old_protect;
+            }
+        }
+        memcpy((void*)addr, payload.data(), payload.size());
+        return;
+    }
+
     if (prot)
     {
         VirtualProtect((void*)page, size, PAGE_EXECUTE_READWRITE, &old_protect);
@@ -80,68 +125,73 @@ size_t function_start(size_t off, uint8_t outside_byte)
 
 LPVOID alloc_mem_rel32(size_t addr, size_t size)
 {
-    const size_t limit_addr = Memory::get().exe_ptr;
-    LPVOID new_array = nullptr;
-    size_t test_addr;
-
-    test_addr = addr + 0x10000; // dunno why
-    if (test_addr <= INT32_MAX)
-        test_addr = 8;
-    else
-        test_addr -= INT32_MAX;
-
-    for (; test_addr < limit_addr; test_addr += 0x100000)
-    {
-        new_array = VirtualAlloc((LPVOID)test_addr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-        if (new_array)
-            break;
-    }
-    return new_array;
+    return code_cave_alloc(CodeCaveKind::Data, size, addr);
+}
+void free_mem_rel32(LPVOID memory)
+{
+    code_cave_free(memory);
 }
 
-std::unordered_map<std::string, std::vector<RecoverableMemory>> original_memory;
-
-void write_mem_recoverable(std::string name, size_t addr, std::string_view payload, bool prot)
+// Holds the original bytes of recoverable writes, these are never freed so blocks are handed out bump-allocator style
+class RecoverableMemoryArena
 {
-    if (!original_memory.contains(name))
+  public:
+    char* allocate(size_t size)
     {
-        char* old_data = (char*)VirtualAlloc(0, payload.size(), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-        if (old_data)
+        if (size > c_BlockSize)
         {
-            memcpy(old_data, (char*)addr, payload.size());
-            original_memory[name] = std::vector<RecoverableMemory>{{addr, old_data, payload.size(), prot}};
-        }
-    }
-    else
-    {
-        bool new_addr = true;
-        for (auto& it : original_memory[name])
-        {
-            if (it.address == addr)
-            {
-                new_addr = false;
-                break;
-            }
+            return m_LargeBlocks.emplace_back(std::make_unique<char[]>(size)).get();
         }
-        if (new_addr)
+        if (m_Blocks.empty() || m_BlockUsed + size > c_BlockSize)
         {
-            char* old_data = (char*)VirtualAlloc(0, payload.size(), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-            if (old_data)
-            {
-                memcpy(old_data, (char*)addr, payload.size());
-                original_memory[name].push_back(RecoverableMemory{addr, old_data, payload.size(), prot});
-            }
+            m_Blocks.push_back(std::make_unique<char[]>(c_BlockSize));
+            m_BlockUsed = 0;
         }
+        char* data = m_Blocks.back().get() + m_BlockUsed;
+        m_BlockUsed += size;
+        return data;
+    }
+
+  private:
+    static constexpr size_t c_BlockSize{0x1000};
+    std::vector<std::unique_ptr<char[]>> m_Blocks;
+    std::vector<std::unique_ptr<char[]>> m_LargeBlocks;
+    size_t m_BlockUsed{0};
+};
+RecoverableMemoryArena g_recoverable_memory_arena;
+
+// Every group is indexed by address, only the first write to an address saves the original bytes
+std::unordered_map<std::string, std::map<size_t, RecoverableMemory>> original_memory;
+
+void write_mem_recoverable(std::string name, size_t addr, std::string_view payload, bool prot)
+{
+    std::map<size_t, RecoverableMemory>& group = original_memory[std::move(name)];
+    if (!group.contains(addr))
+    {
+        char* old_data = g_recoverable_memory_arena.allocate(payload.size());
+        memcpy(old_data, (char*)addr, payload.size());
+        group.emplace(addr, RecoverableMemory{addr, old_data, payload.size(), prot});
     }
     write_mem_prot(addr, payload, prot);
 }
 
 void recover_mem(std::string name, size_t addr)
 {
-    if (original_memory.contains(name))
+    auto it = original_memory.find(name);
+    if (it == original_memory.end())
+    {
+        return;
+    }
+
+    // Restore the whole group in one batch, so no page is left half restored between protection changes
+    MemoryPatchBatch batch;
+    if (!addr)
+    {
+        for (const auto& [address, memory] : it->second)
+            write_mem_prot(memory.address, std::string_view{memory.old_data, memory.size}, memory.prot_used);
+    }
+    else if (auto memory = it->second.find(addr); memory != it->second.end())
     {
-        for (auto& it : original_memory[name])
-            if (!addr || addr == it.address)
-                write_mem_prot(it.address, std::string_view{it.old_data, it.size}, it.prot_used);
+        write_mem_prot(memory->second.address, std::string_view{memory->second.old_data, memory->second.size}, memory->second.prot_used);
     }
 }
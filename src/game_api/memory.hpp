@@ -88,7 +88,21 @@ struct RecoverableMemory
     bool prot_used;
 };
 
+/// Groups all protected writes made while it is alive, so every touched page changes protection once per batch instead of twice per write.
+/// Batches nest, pages get their original protection back when the outermost batch ends.
+class MemoryPatchBatch
+{
+  public:
+    MemoryPatchBatch();
+    ~MemoryPatchBatch();
+
+    MemoryPatchBatch(const MemoryPatchBatch&) = delete;
+    MemoryPatchBatch& operator=(const MemoryPatchBatch&) = delete;
+};
+
+/// Allocates read-write memory that can be addressed with a rel32 operand at `addr`, release it with `free_mem_rel32`
 LPVOID alloc_mem_rel32(size_t addr, size_t size);
+void free_mem_rel32(LPVOID memory);
 void write_mem_prot(size_t addr, std::string_view payload, bool prot);
 void write_mem_prot(size_t addr, std::string payload, bool prot);
 void write_mem(size_t addr, std::string payload);
@@ -1,6 +1,5 @@
 #include "movable_behavior.hpp"
 
-#include <detours.h> // for DetourTransactionBegin, DetourUpdateThread, ...
 #include <list>      // for _List_iterator, _List_const_ite...
 #include <map>       // for _Tree_iterator, _Tree_const_ite...
 #include <string>    // for operator""sv
@@ -8,6 +7,7 @@
 
 #include "containers/custom_map.hpp" // for custom_map
 #include "containers/custom_set.hpp" // for custom_set
+#include "hook_registry.hpp"         // for attach_hook
 #include "memory.hpp"                // for Memory
 #include "movable.hpp"               // for Movable
 #include "search.hpp"                // for get_address
@@ -251,22 +251,13 @@ void update_movable(Movable& movable, const Vec2& move_xy, float sprint_factor,
 
 void init_behavior_hooks()
 {
-    DetourTransactionBegin();
-    DetourUpdateThread(GetCurrentThread());
-
     auto memory = Memory::get();
 
     g_entity_turn_trampoline = (EntityTurn*)memory.at_exe(get_virtual_function_address(VTABLE_OFFSET::MONS_SNAKE, 0x10));
-    DetourAttach((void**)&g_entity_turn_trampoline, &entity_turn);
+    attach_hook("entity_turn", (void**)&g_entity_turn_trampoline, &entity_turn);
 
 #ifdef HOOK_MOVE_ENTITY
     g_update_movable_trampoline = (UpdateMovable*)memory.at_exe(0x228e3580);
-    DetourAttach((void**)&g_update_movable_trampoline, &update_movable);
+    attach_hook("update_movable", (void**)&g_update_movable_trampoline, &update_movable);
 #endif
-
-    const LONG error = DetourTransactionCommit();
-    if (error != NO_ERROR)
-    {
-        DEBUG("Failed hooking behavior hooks: {}\n", error);
-    }
 }
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cmath>         // for abs, lround
+#include <cstddef>       // for size_t
+#include <cstdint>       // for uint32_t, int32_t, uint64_t
+#include <optional>      // for optional
+#include <unordered_map> // for unordered_map
+#include <utility>       // for move
+#include <vector>        // for vector, erase
+
+// Entries waiting for a tile to be spawned, indexed by the tiles they wait for so that each tile only has to look at its own entries
+template <class T>
+class PendingTileEntries
+{
+  public:
+    void push_back(T entry)
+    {
+        std::uint32_t slot;
+        if (m_FreeSlots.empty())
+        {
+            slot = static_cast<std::uint32_t>(m_Entries.size());
+            m_Entries.emplace_back(std::move(entry));
+        }
+        else
+        {
+            slot = m_FreeSlots.back();
+            m_FreeSlots.pop_back();
+            m_Entries[slot] = std::move(entry);
+        }
+
+        for (const auto& pos : m_Entries[slot]->pos)
+        {
+            std::vector<std::uint32_t>& bucket = m_Buckets[tile_key(pos.x, pos.y)];
+            if (bucket.empty() || bucket.back() != slot)
+            {
+                bucket.push_back(slot);
+            }
+        }
+        m_Size++;
+    }
+
+    bool empty() const
+    {
+        return m_Size == 0;
+    }
+    void clear()
+    {
+        m_Entries.clear();
+        m_FreeSlots.clear();
+        m_Buckets.clear();
+        m_Size = 0;
+    }
+
+    /// Calls `fun(entry, pos)` for entries with a position at `x, y`, in the order they were added, and removes the entry if `fun` returns true
+    template <class FunT>
+    void handle_tile(float x, float y, FunT&& fun)
+    {
+        auto it = m_Buckets.find(tile_key(x, y));
+        if (it == m_Buckets.end())
+        {
+            return;
+        }
+
+        // Copy since removing entries changes the bucket, slots are only freed after the loop so `fun` can safely add new entries
+        const std::vector<std::uint32_t> slots = it->second;
+        std::vector<std::uint32_t> freed_slots;
+        for (std::uint32_t slot : slots)
+        {
+            std::optional<T>& entry = m_Entries[slot];
+            if (!entry)
+            {
+                continue;
+            }
+
+            for (const auto& pos : entry->pos)
+            {
+                if (std::abs(pos.x - x) < 0.01f && std::abs(pos.y - y) < 0.01f)
+                {
+                    if (fun(entry.value(), pos))
+                    {
+                        remove(slot);
+                        freed_slots.push_back(slot);
+                    }
+                    break;
+                }
+            }
+        }
+        m_FreeSlots.insert(m_FreeSlots.end(), freed_slots.begin(), freed_slots.end());
+    }
+
+  private:
+    static std::uint64_t tile_key(float x, float y)
+    {
+        const auto ix = static_cast<std::uint32_t>(static_cast<std::int32_t>(std::lround(x)));
+        const auto iy = static_cast<std::uint32_t>(static_cast<std::int32_t>(std::lround(y)));
+        return (static_cast<std::uint64_t>(ix) << 32) | iy;
+    }
+
+    void remove(std::uint32_t slot)
+    {
+        for (const auto& pos : m_Entries[slot]->pos)
+        {
+            auto it = m_Buckets.find(tile_key(pos.x, pos.y));
+            if (it != m_Buckets.end())
+            {
+                std::erase(it->second, slot);
+                if (it->second.empty())
+                {
+                    m_Buckets.erase(it);
+                }
+            }
+        }
+        m_Entries[slot].reset();
+        m_Size--;
+    }
+
+    std::vector<std::optional<T>> m_Entries;
+    std::vector<std::uint32_t> m_FreeSlots;
+    std::unordered_map<std::uint64_t, std::vector<std::uint32_t>> m_Buckets;
+    size_t m_Size{0};
+};
@@ -19,23 +19,10 @@ PRNG& PRNG::get_local()
 
 void PRNG::seed(int64_t seed)
 {
-    auto next_pair = [useed = static_cast<uint64_t>(seed)]() mutable
-    {
-        // advance state
-        useed = (uint64_t((useed & 0xffffffff) == 0) - (useed & 0xffffffff)) * -0x61939c2f98956567;
-        useed = (((useed >> 0x1c) ^ useed) >> 0x17) ^ useed;
-
-        // generate next pair
-        PRNG::prng_pair useed_pair;
-        useed_pair.first = useed * -0x61939c2f98956567;
-        useed_pair.second = (useed * -0x7cc4ab2b38000000 | useed_pair.first >> 0x25) * -0x61939c2f98956567;
-        useed_pair.first = (useed_pair.first >> 0x1c ^ useed_pair.first) >> 0x17 ^ useed_pair.first;
-        return useed_pair;
-    };
-
+    std::uint64_t seed_state = static_cast<std::uint64_t>(seed);
     for (auto& pair : pairs)
     {
-        pair = next_pair();
+        pair = next_seed_pair(seed_state);
     }
 }
 
@@ -43,19 +30,36 @@ PRNG::prng_pair PRNG::get_and_advance(PRNG_CLASS type)
 {
     prng_pair& pair = pairs[type];
     prng_pair copy = pair;
-
-    const std::uint64_t lower = pair.first;
-    const std::uint64_t upper = pair.second;
-
-    const std::uint64_t rest = upper - lower;
-
-    pair = {
-        static_cast<std::uint64_t>(static_cast<std::int64_t>(upper) * -0x2c7cc17fb0b3a8b5),
-        pair.second = rest * 0x8000000 | rest >> 0x25,
-    };
-
+    step_pair(pair);
     return copy;
 }
+void PRNG::advance(PRNG_CLASS type, size_t count)
+{
+    // Mixing rotations with modular arithmetic leaves no closed form to skip ahead with,
+    // so step a local copy instead, which keeps the whole loop in registers
+    prng_pair pair = pairs[type];
+    for (; count >= 4; count -= 4)
+    {
+        step_pair(pair);
+        step_pair(pair);
+        step_pair(pair);
+        step_pair(pair);
+    }
+    for (; count > 0; --count)
+    {
+        step_pair(pair);
+    }
+    pairs[type] = pair;
+}
+void PRNG::peek(PRNG_CLASS type, std::span<prng_pair> out) const
+{
+    prng_pair pair = pairs[type];
+    for (prng_pair& next : out)
+    {
+        next = pair;
+        step_pair(pair);
+    }
+}
 
 std::int64_t PRNG::internal_random_index(std::int64_t size, PRNG_CLASS type)
 {
@@ -69,21 +73,11 @@ std::optional<std::int64_t> PRNG::internal_random_int(std::int64_t min, std::int
         return std::nullopt;
     }
 
-    static auto wrap = [](std::int64_t val, std::int64_t _min, std::int64_t _max)
-    {
-        const auto diff = _max - _min;
-
-        if (val < _min)
-            val += diff * ((_min - val) / diff + 1);
-
-        return _min + (val - _min) % diff;
-    };
-
     prng_pair pair = get_and_advance(type);
 
     // Technically not a uniform distribution, but we have 64bit to map to a range that is many orders of magnitude smaller
     // So in the grand scheme this is close enough to a uniform distribution
-    return wrap(static_cast<std::int64_t>(pair.first), min, max);
+    return wrap_to_range(pair.first, min, max);
 }
 
 bool PRNG::random_chance(std::int64_t inverse_chance, PRNG_CLASS type)
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <array>    // for array
 #include <cstddef>  // for size_t
 #include <cstdint>  // for int64_t, uint64_t
 #include <optional> // for optional
+#include <span>     // for span
 #include <utility>  // for pair
 
 struct PRNG
@@ -33,6 +35,39 @@ struct PRNG
 
     using prng_pair = std::pair<std::uint64_t, std::uint64_t>;
     prng_pair get_and_advance(PRNG_CLASS type);
+    /// Same as calling `get_and_advance(type)` `count` times
+    void advance(PRNG_CLASS type, size_t count);
+    /// Writes the pairs the next `out.size()` calls to `get_and_advance(type)` would return to `out`, without advancing
+    void peek(PRNG_CLASS type, std::span<prng_pair> out) const;
+
+    /// Advances the seed expansion state and returns the next of the ten pairs, `seed` calls this once per pair
+    static prng_pair next_seed_pair(std::uint64_t& seed_state)
+    {
+        seed_state = (std::uint64_t((seed_state & 0xffffffff) == 0) - (seed_state & 0xffffffff)) * -0x61939c2f98956567;
+        seed_state = (((seed_state >> 0x1c) ^ seed_state) >> 0x17) ^ seed_state;
+
+        prng_pair pair;
+        pair.first = seed_state * -0x61939c2f98956567;
+        pair.second = (seed_state * -0x7cc4ab2b38000000 | pair.first >> 0x25) * -0x61939c2f98956567;
+        pair.first = (pair.first >> 0x1c ^ pair.first) >> 0x17 ^ pair.first;
+        return pair;
+    }
+    /// Advances a single pair the same way `get_and_advance` does
+    static void step_pair(prng_pair& pair)
+    {
+        const std::uint64_t rest = pair.second - pair.first;
+        pair.first = static_cast<std::uint64_t>(static_cast<std::int64_t>(pair.second) * -0x2c7cc17fb0b3a8b5);
+        pair.second = rest * 0x8000000 | rest >> 0x25;
+    }
+    /// Maps a raw draw into `[min, max)` the same way `internal_random_int` does, `max` has to be greater than `min`
+    static std::int64_t wrap_to_range(std::uint64_t value, std::int64_t min, std::int64_t max)
+    {
+        std::int64_t val = static_cast<std::int64_t>(value);
+        const auto diff = max - min;
+        if (val < min)
+            val += diff * ((min - val) / diff + 1);
+        return min + (val - min) % diff;
+    }
 
     std::pair<int64_t, int64_t> get_pair(size_t index);
     void set_pair(size_t index, int64_t first, int64_t second);
@@ -0,0 +1,137 @@
+#include "prng_batch.hpp"
+
+#include <algorithm> // for min, max
+#include <array>     // for array
+#include <thread>    // for thread
+
+namespace
+{
+// Lanes have no dependencies between each other, so these loops vectorize when the compiler targets a wide enough instruction set
+constexpr size_t g_lane_count{8};
+// Small batches are not worth the thread startup
+constexpr size_t g_min_seeds_per_thread{4096};
+
+using LaneState = std::array<uint64_t, g_lane_count>;
+using LanePairs = std::array<PRNG::prng_pair, g_lane_count>;
+
+// Expands `count` seeds starting at `seeds`, skipping straight to the pair of `prng_class`
+void seed_lanes(const int64_t* seeds, size_t count, size_t prng_class, LanePairs& pairs)
+{
+    LaneState seed_state{};
+    for (size_t lane = 0; lane < count; ++lane)
+    {
+        seed_state[lane] = static_cast<uint64_t>(seeds[lane]);
+    }
+    for (size_t i = 0; i <= prng_class; ++i)
+    {
+        for (size_t lane = 0; lane < g_lane_count; ++lane)
+        {
+            pairs[lane] = PRNG::next_seed_pair(seed_state[lane]);
+        }
+    }
+}
+
+template <class LaneFun>
+void for_each_lane_group(std::span<const int64_t> seeds, LaneFun&& lane_fun)
+{
+    const size_t seed_count = seeds.size();
+    auto run_range = [&](size_t begin, size_t end)
+    {
+        for (size_t first = begin; first < end; first += g_lane_count)
+        {
+            lane_fun(first, std::min(g_lane_count, end - first));
+        }
+    };
+
+    const size_t hardware_threads = std::max(1u, std::thread::hardware_concurrency());
+    const size_t thread_count = std::min(hardware_threads, seed_count / g_min_seeds_per_thread);
+    if (thread_count <= 1)
+    {
+        run_range(0, seed_count);
+        return;
+    }
+
+    // Keep range boundaries on a lane group so threads never share one
+    const size_t groups = (seed_count + g_lane_count - 1) / g_lane_count;
+    const size_t groups_per_thread = (groups + thread_count - 1) / thread_count;
+    std::vector<std::thread> workers;
+    workers.reserve(thread_count - 1);
+    for (size_t i = 1; i < thread_count; ++i)
+    {
+        const size_t begin = std::min(seed_count, i * groups_per_thread * g_lane_count);
+        const size_t end = std::min(seed_count, (i + 1) * groups_per_thread * g_lane_count);
+        workers.emplace_back(run_range, begin, end);
+    }
+    run_range(0, std::min(seed_count, groups_per_thread * g_lane_count));
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+} // namespace
+
+namespace PrngBatch
+{
+void seed(std::span<const int64_t> seeds, PRNG::prng_pair* out)
+{
+    for_each_lane_group(seeds, [&](size_t first, size_t count)
+                        {
+                            LaneState seed_state{};
+                            for (size_t lane = 0; lane < count; ++lane)
+                            {
+                                seed_state[lane] = static_cast<uint64_t>(seeds[first + lane]);
+                            }
+                            for (size_t i = 0; i < 10; ++i)
+                            {
+                                LanePairs pairs;
+                                for (size_t lane = 0; lane < g_lane_count; ++lane)
+                                {
+                                    pairs[lane] = PRNG::next_seed_pair(seed_state[lane]);
+                                }
+                                for (size_t lane = 0; lane < count; ++lane)
+                                {
+                                    out[(first + lane) * 10 + i] = pairs[lane];
+                                }
+                            } });
+}
+
+void draw(std::span<const int64_t> seeds, PRNG::PRNG_CLASS prng_class, size_t draw_count, PRNG::prng_pair* out)
+{
+    for_each_lane_group(seeds, [&](size_t first, size_t count)
+                        {
+                            LanePairs pairs;
+                            seed_lanes(seeds.data() + first, count, prng_class, pairs);
+                            for (size_t i = 0; i < draw_count; ++i)
+                            {
+                                for (size_t lane = 0; lane < count; ++lane)
+                                {
+                                    out[(first + lane) * draw_count + i] = pairs[lane];
+                                }
+                                for (size_t lane = 0; lane < g_lane_count; ++lane)
+                                {
+                                    PRNG::step_pair(pairs[lane]);
+                                }
+                            } });
+}
+
+std::vector<int64_t> random_int(std::span<const int64_t> seeds, PRNG::PRNG_CLASS prng_class, size_t draw_count, int64_t min, int64_t max)
+{
+    std::vector<int64_t> values(seeds.size() * draw_count);
+    for_each_lane_group(seeds, [&](size_t first, size_t count)
+                        {
+                            LanePairs pairs;
+                            seed_lanes(seeds.data() + first, count, prng_class, pairs);
+                            for (size_t i = 0; i < draw_count; ++i)
+                            {
+                                for (size_t lane = 0; lane < count; ++lane)
+                                {
+                                    values[(first + lane) * draw_count + i] = PRNG::wrap_to_range(pairs[lane].first, min, max + 1);
+                                }
+                                for (size_t lane = 0; lane < g_lane_count; ++lane)
+                                {
+                                    PRNG::step_pair(pairs[lane]);
+                                }
+                            } });
+    return values;
+}
+} // namespace PrngBatch
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef> // for size_t
+#include <cstdint> // for int64_t, uint64_t
+#include <span>    // for span
+#include <vector>  // for vector
+
+#include "prng.hpp" // for PRNG
+
+/// Evaluates the prng for many seeds at once without touching the game state, meant for offline seed searching.
+/// Seeds are processed in fixed width lanes split across worker threads, results are bit-exact with `PRNG::seed` and `PRNG::get_and_advance`.
+namespace PrngBatch
+{
+/// Writes the ten pairs `PRNG::seed` would produce for each seed to `out`, which must hold `seeds.size() * 10` pairs
+void seed(std::span<const int64_t> seeds, PRNG::prng_pair* out);
+/// Writes the first `draw_count` pairs drawn from `prng_class` right after seeding to `out`, which must hold `seeds.size() * draw_count` pairs
+void draw(std::span<const int64_t> seeds, PRNG::PRNG_CLASS prng_class, size_t draw_count, PRNG::prng_pair* out);
+/// Same as calling `PRNG::random_int(min, max, prng_class)` `draw_count` times right after seeding, returns `seeds.size() * draw_count` values
+/// `max` has to be at least `min`
+std::vector<int64_t> random_int(std::span<const int64_t> seeds, PRNG::PRNG_CLASS prng_class, size_t draw_count, int64_t min, int64_t max);
+} // namespace PrngBatch
@@ -0,0 +1,236 @@
+#include "prng_history.hpp"
+
+#include <bit> // for popcount
+
+namespace
+{
+// Every keyframe stores all pairs, so restoring never walks back more than this many frames
+constexpr uint64_t g_keyframe_interval{32};
+// Most frames only advance a few classes, the pair buffer is sized for this average and drops old frames if it is exceeded
+constexpr size_t g_pairs_per_frame{4};
+constexpr uint16_t g_all_pairs_mask{(1 << 10) - 1};
+// Upper bound on draws `diff` steps through per class before giving up
+constexpr int64_t g_max_diff_draws{1 << 20};
+} // namespace
+
+PrngHistory& PrngHistory::get()
+{
+    static PrngHistory history;
+    return history;
+}
+
+void PrngHistory::set_capacity(size_t frames)
+{
+    clear();
+    m_Capacity = frames;
+    // The oldest requested frame may need up to a whole keyframe interval of older frames to be rebuilt from, plus a slot for the frame being written
+    const size_t entries = frames == 0 ? 0 : frames + g_keyframe_interval;
+    m_Entries.resize(entries);
+    m_Entries.shrink_to_fit();
+    // On top of the average, every keyframe interval in the window needs room for one full keyframe
+    const size_t keyframes = entries == 0 ? 0 : entries / g_keyframe_interval + 2;
+    m_Pairs.resize(entries * g_pairs_per_frame + keyframes * 10);
+    m_Pairs.shrink_to_fit();
+}
+
+void PrngHistory::record(uint32_t frame, const PRNG& prng)
+{
+    if (m_Entries.empty())
+    {
+        return;
+    }
+
+    if (m_EntriesWritten != m_FirstEntry)
+    {
+        const uint32_t last_frame = m_Entries[(m_EntriesWritten - 1) % m_Entries.size()].frame;
+        if (frame == last_frame)
+        {
+            return;
+        }
+        if (frame < last_frame)
+        {
+            clear();
+        }
+    }
+
+    uint16_t changed_mask{0};
+    for (size_t i = 0; i < 10; ++i)
+    {
+        if (prng.pairs[i] != m_Last[i])
+        {
+            changed_mask |= static_cast<uint16_t>(1 << i);
+        }
+    }
+    if (m_EntriesWritten == m_FirstEntry || m_EntriesWritten % g_keyframe_interval == 0)
+    {
+        changed_mask = g_all_pairs_mask;
+    }
+    else
+    {
+        // Busy frames can push the pairs of the newest keyframe out of the buffer, write a new one before that happens so the history is never left without a starting point
+        const uint64_t pairs_written = m_PairsWritten + std::popcount(changed_mask);
+        const uint64_t oldest_pair = pairs_written > m_Pairs.size() ? pairs_written - m_Pairs.size() : 0;
+        if (m_Entries[m_LastKeyframe % m_Entries.size()].first_pair < oldest_pair)
+        {
+            changed_mask = g_all_pairs_mask;
+        }
+    }
+
+    const uint64_t first_pair = m_PairsWritten;
+    for (size_t i = 0; i < 10; ++i)
+    {
+        if (changed_mask & (1 << i))
+        {
+            m_Pairs[m_PairsWritten % m_Pairs.size()] = prng.pairs[i];
+            ++m_PairsWritten;
+        }
+    }
+    m_Last = prng.pairs;
+
+    if (changed_mask == g_all_pairs_mask)
+    {
+        m_LastKeyframe = m_EntriesWritten;
+    }
+    m_Entries[m_EntriesWritten % m_Entries.size()] = Entry{frame, changed_mask, first_pair};
+    ++m_EntriesWritten;
+
+    // Drop frames whose pairs were just overwritten, the frames after them up to the next keyframe can't be rebuilt anymore either
+    const uint64_t oldest_pair = m_PairsWritten > m_Pairs.size() ? m_PairsWritten - m_Pairs.size() : 0;
+    if (m_Entries[m_FirstEntry % m_Entries.size()].first_pair < oldest_pair)
+    {
+        while (m_Entries[m_FirstEntry % m_Entries.size()].first_pair < oldest_pair || !is_keyframe(m_FirstEntry))
+        {
+            ++m_FirstEntry;
+        }
+    }
+
+    // Keep the last `m_Capacity` frames, starting at the keyframe the oldest of them is rebuilt from
+    if (m_EntriesWritten - m_FirstEntry > m_Capacity)
+    {
+        for (uint64_t i = m_EntriesWritten - m_Capacity; i > m_FirstEntry; --i)
+        {
+            if (is_keyframe(i))
+            {
+                m_FirstEntry = i;
+                break;
+            }
+        }
+    }
+}
+void PrngHistory::clear()
+{
+    m_EntriesWritten = 0;
+    m_FirstEntry = 0;
+    m_PairsWritten = 0;
+    m_LastKeyframe = 0;
+}
+
+bool PrngHistory::is_keyframe(uint64_t entry_index) const
+{
+    return m_Entries[entry_index % m_Entries.size()].changed_mask == g_all_pairs_mask;
+}
+
+std::optional<std::pair<uint32_t, uint32_t>> PrngHistory::get_range() const
+{
+    // The oldest kept frame is always a keyframe, so every kept frame can be restored
+    if (m_FirstEntry == m_EntriesWritten)
+    {
+        return std::nullopt;
+    }
+    return std::pair{m_Entries[m_FirstEntry % m_Entries.size()].frame, m_Entries[(m_EntriesWritten - 1) % m_Entries.size()].frame};
+}
+
+std::optional<uint64_t> PrngHistory::find_entry(uint32_t frame) const
+{
+    uint64_t low = m_FirstEntry;
+    uint64_t high = m_EntriesWritten;
+    while (low < high)
+    {
+        const uint64_t mid = low + (high - low) / 2;
+        const uint32_t mid_frame = m_Entries[mid % m_Entries.size()].frame;
+        if (mid_frame == frame)
+        {
+            return mid;
+        }
+        if (mid_frame < frame)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::array<PRNG::prng_pair, 10>> PrngHistory::get_snapshot(uint32_t frame) const
+{
+    const auto entry_index = find_entry(frame);
+    if (!entry_index)
+    {
+        return std::nullopt;
+    }
+
+    // Walk back until every pair was found, at the latest this stops at the previous keyframe
+    std::array<PRNG::prng_pair, 10> pairs;
+    uint16_t found_mask{0};
+    for (uint64_t i = entry_index.value() + 1; i-- > m_FirstEntry;)
+    {
+        const Entry& entry = m_Entries[i % m_Entries.size()];
+        const uint16_t new_mask = entry.changed_mask & ~found_mask;
+        for (size_t j = 0; j < 10; ++j)
+        {
+            if (new_mask & (1 << j))
+            {
+                const uint64_t pair_offset = std::popcount(static_cast<uint16_t>(entry.changed_mask & ((1 << j) - 1)));
+                pairs[j] = m_Pairs[(entry.first_pair + pair_offset) % m_Pairs.size()];
+            }
+        }
+        found_mask |= new_mask;
+        if (found_mask == g_all_pairs_mask)
+        {
+            return pairs;
+        }
+    }
+    return std::nullopt;
+}
+bool PrngHistory::restore(uint32_t frame, PRNG& prng) const
+{
+    if (auto pairs = get_snapshot(frame))
+    {
+        prng.pairs = pairs.value();
+        return true;
+    }
+    return false;
+}
+
+std::optional<std::unordered_map<int, int64_t>> PrngHistory::diff(uint32_t from_frame, uint32_t to_frame) const
+{
+    const auto from = get_snapshot(from_frame);
+    const auto to = get_snapshot(to_frame);
+    if (!from || !to)
+    {
+        return std::nullopt;
+    }
+
+    std::unordered_map<int, int64_t> advanced;
+    for (size_t i = 0; i < 10; ++i)
+    {
+        PRNG::prng_pair pair = from.value()[i];
+        const PRNG::prng_pair& target = to.value()[i];
+        if (pair == target)
+        {
+            continue;
+        }
+
+        int64_t draws = 0;
+        while (pair != target && draws < g_max_diff_draws)
+        {
+            PRNG::step_pair(pair);
+            ++draws;
+        }
+        advanced[static_cast<int>(i)] = pair == target ? draws : -1;
+    }
+    return advanced;
+}
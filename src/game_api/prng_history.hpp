@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>         // for array
+#include <cstddef>       // for size_t
+#include <cstdint>       // for uint16_t, uint32_t, uint64_t
+#include <optional>      // for optional
+#include <unordered_map> // for unordered_map
+#include <utility>       // for pair
+#include <vector>        // for vector
+
+#include "prng.hpp" // for PRNG
+
+/// Per-frame history of the game prng, so tooling can jump the prng back to any recorded frame without replaying from level start.
+/// Every frame only stores the pairs that changed since the previous frame, with a full keyframe at a fixed interval to bound restore cost.
+class PrngHistory
+{
+  public:
+    static PrngHistory& get();
+
+    /// Keeps at most `frames` frames of history, `0` disables recording and drops all recorded frames
+    void set_capacity(size_t frames);
+    size_t get_capacity() const
+    {
+        return m_Capacity;
+    }
+
+    /// Records `prng` for `frame`, does nothing if `frame` was already recorded. Recording an earlier frame than the last one starts a new history.
+    void record(uint32_t frame, const PRNG& prng);
+    void clear();
+
+    /// Returns the range of frames in which every frame can be restored
+    std::optional<std::pair<uint32_t, uint32_t>> get_range() const;
+    std::optional<std::array<PRNG::prng_pair, 10>> get_snapshot(uint32_t frame) const;
+    /// Overwrites the pairs of `prng` with the ones recorded for `frame`, returns false if the frame is not in the history
+    bool restore(uint32_t frame, PRNG& prng) const;
+
+    /// Returns how many draws each class that changed between `from_frame` and `to_frame` advanced by, or -1 if it was reseeded or modified otherwise
+    std::optional<std::unordered_map<int, int64_t>> diff(uint32_t from_frame, uint32_t to_frame) const;
+
+  private:
+    struct Entry
+    {
+        uint32_t frame;
+        uint16_t changed_mask;
+        uint64_t first_pair;
+    };
+
+    std::optional<uint64_t> find_entry(uint32_t frame) const;
+    bool is_keyframe(uint64_t entry_index) const;
+
+    size_t m_Capacity{0};
+    std::vector<Entry> m_Entries;
+    std::vector<PRNG::prng_pair> m_Pairs;
+    uint64_t m_EntriesWritten{0};
+    uint64_t m_FirstEntry{0};
+    uint64_t m_PairsWritten{0};
+    // Index of the newest keyframe, the history always keeps at least this one
+    uint64_t m_LastKeyframe{0};
+    std::array<PRNG::prng_pair, 10> m_Last{};
+};
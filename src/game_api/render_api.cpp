@@ -3,7 +3,6 @@
 #include <Windows.h>    // for MultiByteToWideChar, GetCurrentThread
 #include <array>        // for array
 #include <cstddef>      // for size_t
-#include <detours.h>    // for DetourAttach, DetourTransactionBegin
 #include <fmt/format.h> // for check_format_string, format, vformat
 #include <list>         // for _List_iterator, _List_const_iterator
 #include <optional>     // for optional, nullopt
@@ -12,6 +11,7 @@
 #include <vector>       // for vector
 
 #include "entity.hpp"             // for Entity, EntityDB
+#include "hook_registry.hpp"      // for attach_hook, register_lazy_hook
 #include "level_api.hpp"          // for ThemeInfo
 #include "logger.h"               // for DEBUG
 #include "memory.hpp"             // for memory_read, to_le_bytes, write_mem_prot
@@ -532,38 +532,29 @@ void init_render_api_hooks()
 
     g_prepare_text_trampoline = (PrepareTextFun*)get_address("prepare_text_for_rendering");
 
-    DetourTransactionBegin();
-    DetourUpdateThread(GetCurrentThread());
-
-    DetourAttach((void**)&g_render_loading_trampoline, render_loading);
-    DetourAttach((void**)&g_render_layer_trampoline, render_layer);
-    DetourAttach((void**)&g_render_hud_trampoline, &render_hud);
-    DetourAttach((void**)&g_render_pause_menu_trampoline, &render_pause_menu);
-    DetourAttach((void**)&g_render_draw_depth_trampoline, &render_draw_depth);
-    DetourAttach((void**)&g_render_journal_page_journalmenu_trampoline, &render_journal_page_journalmenu);
-    DetourAttach((void**)&g_render_journal_page_progress_trampoline, &render_journal_page_progress);
-    DetourAttach((void**)&g_render_journal_page_place_trampoline, &render_journal_page_place);
-    DetourAttach((void**)&g_render_journal_page_people_trampoline, &render_journal_page_people);
-    DetourAttach((void**)&g_render_journal_page_bestiary_trampoline, &render_journal_page_bestiary);
-    DetourAttach((void**)&g_render_journal_page_items_trampoline, &render_journal_page_items);
-    DetourAttach((void**)&g_render_journal_page_traps_trampoline, &render_journal_page_traps);
-    DetourAttach((void**)&g_render_journal_page_story_trampoline, &render_journal_page_story);
-    DetourAttach((void**)&g_render_journal_page_feats_trampoline, &render_journal_page_feats);
-    DetourAttach((void**)&g_render_journal_page_deathcause_trampoline, &render_journal_page_deathcause);
-    DetourAttach((void**)&g_render_journal_page_deathmenu_trampoline, &render_journal_page_deathmenu);
-    DetourAttach((void**)&g_render_journal_page_recap_trampoline, &render_journal_page_recap);
-    DetourAttach((void**)&g_render_journal_page_player_profile_trampoline, &render_journal_page_player_profile);
-    DetourAttach((void**)&g_render_journal_page_last_game_played_trampoline, &render_journal_page_last_game_played);
-    DetourAttach((void**)&g_on_show_journal_trampoline, &on_open_journal_chapter);
-    DetourAttach((void**)&g_on_select_from_journal_menu_trampoline, &on_select_from_journal);
-
-    DetourAttach((void**)&g_prepare_text_trampoline, prepare_text);
-
-    const LONG error = DetourTransactionCommit();
-    if (error != NO_ERROR)
-    {
-        DEBUG("Failed hooking render_api: {}\n", error);
-    }
+    HookTransaction hooks;
+    attach_hook("render_loading", (void**)&g_render_loading_trampoline, render_loading);
+    attach_hook("render_layer", (void**)&g_render_layer_trampoline, render_layer);
+    attach_hook("render_hud", (void**)&g_render_hud_trampoline, &render_hud);
+    attach_hook("render_pause_menu", (void**)&g_render_pause_menu_trampoline, &render_pause_menu);
+    attach_hook("render_draw_depth", (void**)&g_render_draw_depth_trampoline, &render_draw_depth);
+    register_lazy_hook("render_journal_page", "render_journal_page_journalmenu", (void**)&g_render_journal_page_journalmenu_trampoline, &render_journal_page_journalmenu);
+    register_lazy_hook("render_journal_page", "render_journal_page_progress", (void**)&g_render_journal_page_progress_trampoline, &render_journal_page_progress);
+    register_lazy_hook("render_journal_page", "render_journal_page_place", (void**)&g_render_journal_page_place_trampoline, &render_journal_page_place);
+    register_lazy_hook("render_journal_page", "render_journal_page_people", (void**)&g_render_journal_page_people_trampoline, &render_journal_page_people);
+    register_lazy_hook("render_journal_page", "render_journal_page_bestiary", (void**)&g_render_journal_page_bestiary_trampoline, &render_journal_page_bestiary);
+    register_lazy_hook("render_journal_page", "render_journal_page_items", (void**)&g_render_journal_page_items_trampoline, &render_journal_page_items);
+    register_lazy_hook("render_journal_page", "render_journal_page_traps", (void**)&g_render_journal_page_traps_trampoline, &render_journal_page_traps);
+    register_lazy_hook("render_journal_page", "render_journal_page_story", (void**)&g_render_journal_page_story_trampoline, &render_journal_page_story);
+    register_lazy_hook("render_journal_page", "render_journal_page_feats", (void**)&g_render_journal_page_feats_trampoline, &render_journal_page_feats);
+    register_lazy_hook("render_journal_page", "render_journal_page_deathcause", (void**)&g_render_journal_page_deathcause_trampoline, &render_journal_page_deathcause);
+    register_lazy_hook("render_journal_page", "render_journal_page_deathmenu", (void**)&g_render_journal_page_deathmenu_trampoline, &render_journal_page_deathmenu);
+    register_lazy_hook("render_journal_page", "render_journal_page_recap", (void**)&g_render_journal_page_recap_trampoline, &render_journal_page_recap);
+    register_lazy_hook("render_journal_page", "render_journal_page_player_profile", (void**)&g_render_journal_page_player_profile_trampoline, &render_journal_page_player_profile);
+    register_lazy_hook("render_journal_page", "render_journal_page_last_game_played", (void**)&g_render_journal_page_last_game_played_trampoline, &render_journal_page_last_game_played);
+    attach_hook("on_show_journal", (void**)&g_on_show_journal_trampoline, &on_open_journal_chapter);
+    attach_hook("on_select_from_journal_menu", (void**)&g_on_select_from_journal_menu_trampoline, &on_select_from_journal);
+    attach_hook("prepare_text", (void**)&g_prepare_text_trampoline, prepare_text);
 }
 
 Entity* RenderInfo::get_entity() const
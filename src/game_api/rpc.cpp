@@ -2,6 +2,7 @@
 
 #include <Windows.h>        // for VirtualFree, MEM_RELEASE, GetCurrent...
 #include <array>            // for array
+#include <bit>              // for countr_zero
 #include <cmath>            // for round, pow, sqrt
 #include <cstring>          // for size_t, memcpy
 #include <detours.h>        // for DetourAttach, DetourTransactionBegin
@@ -27,12 +28,14 @@
 #include "entities_liquids.hpp" // for Liquid
 #include "entities_mounts.hpp"  // for Mount
 #include "entity.hpp"           // for get_entity_ptr, to_id, Entity, EntityDB
+#include "entity_query.hpp"     // for entities_by_mask, EntityTypeSet, collect_entity_uids, ...
 #include "game_manager.hpp"     //
+#include "hitbox_batch.hpp"     // for HitboxBatch, append_overlapping
 #include "items.hpp"            // for Items
-#include "layer.hpp"            // for EntityList, EntityList::Range, Layer
+#include "layer.hpp"            // for EntityList, EntityList::Range, Layer, MaskEntityLists
 #include "logger.h"             // for DEBUG
 #include "math.hpp"             // for AABB
-#include "memory.hpp"           // for write_mem_prot, write_mem_recoverable
+#include "memory.hpp"           // for write_mem_prot, write_mem_recoverable, MemoryPatchBatch, free_mem_rel32
 #include "movable.hpp"          // for Movable
 #include "particles.hpp"        // for ParticleEmitterInfo
 #include "search.hpp"           // for get_address, find_inst
@@ -339,15 +342,12 @@ void foreach_mask(uint32_t mask, Layer* l, FunT&& fun)
     }
     else
     {
-        for (uint32_t test_flag = 1U; test_flag < 0x8000; test_flag <<= 1U)
+        const MaskEntityLists& lists = l->get_mask_lists();
+        for (uint32_t bits = mask & 0x7fff; bits != 0; bits &= bits - 1)
         {
-            if (mask & test_flag)
+            if (const EntityList* entities = lists[std::countr_zero(bits)])
             {
-                const auto& it = l->entities_by_mask.find(test_flag);
-                if (it != l->entities_by_mask.end())
-                {
-                    fun(it->second);
-                }
+                fun(*entities);
             }
         }
     }
@@ -357,58 +357,40 @@ std::vector<uint32_t> get_entities_by(std::vector<ENT_TYPE> entity_types, uint32
 {
     auto state = State::get();
     std::vector<uint32_t> found;
-    const std::vector<ENT_TYPE> proper_types = get_proper_types(std::move(entity_types));
+    const EntityTypeSet types{get_proper_types(std::move(entity_types))};
 
-    auto push_matching_types = [&proper_types, &found](const EntityList& entities)
+    auto push_matching = [&types, &found, mask](Layer* l)
     {
-        for (auto& item : entities.entities())
+        // With at most one mask bit no entity can be in two lists, so whole lists can be copied without looking at the entities
+        if (types.matches_all() && (mask & (mask - 1)) == 0)
         {
-            if (entity_type_check(proper_types, item->type->id))
-            {
-                found.push_back(item->uid);
-            }
+            foreach_mask(mask, l, [&found](const EntityList& entities)
+                         {
+                             const auto uids = entities.uids();
+                             found.insert(found.end(), uids.begin(), uids.end()); });
+        }
+        else
+        {
+            const MaskedEntityView view = entities_by_mask(l, mask);
+            const std::vector<uint32_t> uids = collect_entity_uids({&view, 1}, [&types](Entity* entity)
+                                                                   { return types.contains(entity->type->id); });
+            found.insert(found.end(), uids.begin(), uids.end());
         }
-    };
-    auto insert_all_uids = [&found](const EntityList& entities)
-    {
-        const auto uids = entities.uids();
-        found.insert(found.end(), uids.begin(), uids.end());
     };
 
     if (layer == LAYER::BOTH)
     {
-        if (proper_types.empty() || proper_types[0] == 0)
+        if (types.matches_all() && mask == 0) // all entities
         {
-            if (mask == 0) // all entities
-            {
-                // this exception for small improvments with calling reserve once
-                found.reserve(found.size() + (size_t)state.layer(0)->all_entities.size + (size_t)state.layer(1)->all_entities.size);
-                found.insert(found.end(), state.layer(0)->all_entities.uids().begin(), state.layer(0)->all_entities.uids().end());
-                found.insert(found.end(), state.layer(1)->all_entities.uids().begin(), state.layer(1)->all_entities.uids().end());
-            }
-            else // all types
-            {
-                foreach_mask(mask, state.layer(0), insert_all_uids);
-                foreach_mask(mask, state.layer(1), insert_all_uids);
-            }
-        }
-        else
-        {
-            foreach_mask(mask, state.layer(0), push_matching_types);
-            foreach_mask(mask, state.layer(1), push_matching_types);
+            // this exception for small improvments with calling reserve once
+            found.reserve((size_t)state.layer(0)->all_entities.size + (size_t)state.layer(1)->all_entities.size);
         }
+        push_matching(state.layer(0));
+        push_matching(state.layer(1));
     }
     else
     {
-        uint8_t correct_layer = enum_to_layer(layer);
-        if (proper_types.empty() || proper_types[0] == 0) // all types
-        {
-            foreach_mask(mask, state.layer(correct_layer), insert_all_uids);
-        }
-        else
-        {
-            foreach_mask(mask, state.layer(correct_layer), push_matching_types);
-        }
+        push_matching(state.layer(enum_to_layer(layer)));
     }
     return found;
 }
@@ -420,54 +402,57 @@ std::vector<uint32_t> get_entities_by(ENT_TYPE entity_type, uint32_t mask, LAYER
 std::vector<uint32_t> get_entities_at(std::vector<ENT_TYPE> entity_types, uint32_t mask, float x, float y, LAYER layer, float radius)
 {
     auto state = State::get();
-    std::vector<uint32_t> found;
-    const std::vector<ENT_TYPE> proper_types = get_proper_types(std::move(entity_types));
-    auto push_entities_at = [&x, &y, &radius, &proper_types, &found](const EntityList& entities)
+    const EntityTypeSet types{get_proper_types(std::move(entity_types))};
+    const auto entities_at = [x, y, radius, &types](Entity* entity)
     {
-        for (auto& item : entities.entities())
-        {
-            auto [ix, iy] = item->position();
-            float distance = sqrt(pow(x - ix, 2.0f) + pow(y - iy, 2.0f));
-            if (distance < radius && entity_type_check(proper_types, item->type->id))
-            {
-                found.push_back(item->uid);
-            }
-        }
+        const auto [ix, iy] = entity->position();
+        return std::sqrt(std::pow(x - ix, 2.0f) + std::pow(y - iy, 2.0f)) < radius && types.contains(entity->type->id);
     };
     if (layer == LAYER::BOTH)
     {
-        foreach_mask(mask, state.layer(0), push_entities_at);
-        foreach_mask(mask, state.layer(1), push_entities_at);
+        // Both layers in one query so they are split across threads together
+        const MaskedEntityView views[]{entities_by_mask(state.layer(0), mask), entities_by_mask(state.layer(1), mask)};
+        return collect_entity_uids(views, entities_at);
     }
-    else
-    {
-        foreach_mask(mask, state.layer(enum_to_layer(layer)), push_entities_at);
-    }
-    return found;
+    const MaskedEntityView view = entities_by_mask(state.layer(enum_to_layer(layer)), mask);
+    return collect_entity_uids({&view, 1}, entities_at);
 }
 std::vector<uint32_t> get_entities_at(ENT_TYPE entity_type, uint32_t mask, float x, float y, LAYER layer, float radius)
 {
     return get_entities_at(std::vector<ENT_TYPE>{entity_type}, mask, x, y, layer, radius);
 }
 
+std::vector<uint32_t> get_entities_overlapping_in(std::span<const MaskedEntityView> views, const EntityTypeSet& types, AABB hitbox)
+{
+    // Gather the hitboxes of matching entities and test them against the query box a whole batch at a time
+    return collect_entity_uids_by(views, [&types, hitbox](auto&& walk, std::vector<uint32_t>& found)
+                                  {
+                                      HitboxBatch batch;
+                                      walk([&](Entity* entity)
+                                           {
+                                               if (!types.contains(entity->type->id))
+                                                   return;
+                                               batch.push_back(entity);
+                                               if (batch.full())
+                                               {
+                                                   append_overlapping(hitbox, batch, found);
+                                                   batch.clear();
+                                               } });
+                                      append_overlapping(hitbox, batch, found); });
+}
+
 std::vector<uint32_t> get_entities_overlapping_hitbox(std::vector<ENT_TYPE> entity_types, uint32_t mask, AABB hitbox, LAYER layer)
 {
     auto state = State::get();
-    std::vector<uint32_t> result;
-    const std::vector<ENT_TYPE> proper_types = get_proper_types(std::move(entity_types));
     if (layer == LAYER::BOTH)
     {
-        std::vector<uint32_t> result2;
-        result = get_entities_overlapping_by_pointer(proper_types, mask, hitbox.left, hitbox.bottom, hitbox.right, hitbox.top, state.layer(0));
-        result2 = get_entities_overlapping_by_pointer(proper_types, mask, hitbox.left, hitbox.bottom, hitbox.right, hitbox.top, state.layer(1));
-        result.insert(result.end(), result2.begin(), result2.end());
-    }
-    else
-    {
-        uint8_t actual_layer = enum_to_layer(layer);
-        result = get_entities_overlapping_by_pointer(proper_types, mask, hitbox.left, hitbox.bottom, hitbox.right, hitbox.top, state.layer(actual_layer));
+        // Both layers in one query so they are split across threads together
+        const EntityTypeSet types{get_proper_types(std::move(entity_types))};
+        const MaskedEntityView views[]{entities_by_mask(state.layer(0), mask), entities_by_mask(state.layer(1), mask)};
+        return get_entities_overlapping_in(views, types, hitbox);
     }
-    return result;
+    uint8_t actual_layer = enum_to_layer(layer);
+    return get_entities_overlapping_by_pointer(get_proper_types(std::move(entity_types)), mask, hitbox.left, hitbox.bottom, hitbox.right, hitbox.top, state.layer(actual_layer));
 }
 std::vector<uint32_t> get_entities_overlapping_hitbox(ENT_TYPE entity_type, uint32_t mask, AABB hitbox, LAYER layer)
 {
@@ -485,18 +470,10 @@ std::vector<uint32_t> get_entities_overlapping(ENT_TYPE entity_type, uint32_t ma
 
 std::vector<uint32_t> get_entities_overlapping_by_pointer(std::vector<ENT_TYPE> entity_types, uint32_t mask, float sx, float sy, float sx2, float sy2, Layer* layer)
 {
-    std::vector<uint32_t> found;
-    foreach_mask(mask, layer, [&entity_types, &found, &sx, &sy, &sx2, &sy2](const EntityList& entities)
-                 {
-                     for (auto& item : entities.entities())
-                     {
-                         if (entity_type_check(std::move(entity_types), item->type->id) && item->overlaps_with(sx, sy, sx2, sy2))
-                         {
-                             found.push_back(item->uid);
-                         }
-                     } });
-
-    return found;
+    const EntityTypeSet types{entity_types};
+    const AABB hitbox{sx, sy2, sx2, sy};
+    const MaskedEntityView view = entities_by_mask(layer, mask);
+    return get_entities_overlapping_in({&view, 1}, types, hitbox);
 }
 std::vector<uint32_t> get_entities_overlapping_by_pointer(ENT_TYPE entity_type, uint32_t mask, float sx, float sy, float sx2, float sy2, Layer* layer)
 {
@@ -1382,7 +1359,7 @@ void change_sunchallenge_spawns(std::vector<ENT_TYPE> ent_types)
     if (ent_types_size == 0)
     {
         if (modified)
-            VirtualFree(old_types_array, 0, MEM_RELEASE);
+            free_mem_rel32(old_types_array);
 
         recover_mem("sunchallenge_spawn");
         modified = false;
@@ -1409,6 +1386,7 @@ void change_sunchallenge_spawns(std::vector<ENT_TYPE> ent_types)
 
     if (old_size == ent_types_size)
     {
+        MemoryPatchBatch batch;
         for (uint32_t i = 0; i < ent_types_size; ++i)
             write_mem_recoverable("sunchallenge_spawn", (size_t)&old_types_array[i], ent_types[i], true);
 
@@ -1420,7 +1398,7 @@ void change_sunchallenge_spawns(std::vector<ENT_TYPE> ent_types)
     if (new_array)
     {
         if (modified)
-            VirtualFree(old_types_array, 0, MEM_RELEASE);
+            free_mem_rel32(old_types_array);
 
         memcpy(new_array, ent_types.data(), data_size);
         int32_t rel = static_cast<int32_t>((size_t)new_array - (offset + 4));
@@ -1445,7 +1423,7 @@ void change_diceshop_prizes(std::vector<ENT_TYPE> ent_types)
         if (!ent_types.size())
         {
             if (!original_instr)
-                VirtualFree(old_types_array, 0, MEM_RELEASE);
+                free_mem_rel32(old_types_array);
 
             recover_mem("diceshop_prizes");
         }
@@ -1455,6 +1433,7 @@ void change_diceshop_prizes(std::vector<ENT_TYPE> ent_types)
     if ((original_instr && ent_types.size() == 25) ||                              // if it's the unchanged instruction and we set the same number of ent_type's
         (!original_instr && memory_read<uint8_t>(offset + 5) == ent_types.size())) // or new instruction but the same size
     {
+        MemoryPatchBatch batch;
         for (unsigned int i = 0; i < ent_types.size(); ++i)
             write_mem_recoverable("diceshop_prizes", (size_t)&old_types_array[i], ent_types[i], true);
 
@@ -1467,7 +1446,7 @@ void change_diceshop_prizes(std::vector<ENT_TYPE> ent_types)
     if (new_array)
     {
         if (!original_instr)
-            VirtualFree(old_types_array, 0, MEM_RELEASE);
+            free_mem_rel32(old_types_array);
 
         memcpy(new_array, ent_types.data(), data_size);
         int32_t rel = static_cast<int32_t>((size_t)new_array - (array_offset + 4));
@@ -1506,7 +1485,7 @@ void change_altar_damage_spawns(std::vector<ENT_TYPE> ent_types)
     if (ent_types.empty())
     {
         if (!original_instr)
-            VirtualFree(old_types_array, 0, MEM_RELEASE);
+            free_mem_rel32(old_types_array);
 
         recover_mem("altar_damage_spawn");
         return;
@@ -1514,6 +1493,7 @@ void change_altar_damage_spawns(std::vector<ENT_TYPE> ent_types)
     if (!original_instr && memory_read<uint8_t>(code_offset + 2) == ent_types.size())
     {
         // original array is used for something else as well, so i never edit that content
+        MemoryPatchBatch batch;
         for (uint32_t i = 0; i < ent_types.size(); ++i)
             write_mem_recoverable("altar_damage_spawn", (size_t)&old_types_array[i], ent_types[i], true);
 
@@ -1524,7 +1504,7 @@ void change_altar_damage_spawns(std::vector<ENT_TYPE> ent_types)
     if (new_array)
     {
         if (!original_instr)
-            VirtualFree(old_types_array, 0, MEM_RELEASE);
+            free_mem_rel32(old_types_array);
 
         memcpy(new_array, ent_types.data(), data_size);
         int32_t rel = static_cast<int32_t>((size_t)new_array - (array_offset + 4));
@@ -1561,7 +1541,7 @@ void change_waddler_drop(std::vector<ENT_TYPE> ent_types)
         if (!ent_types.size())
         {
             if (modified)
-                VirtualFree(old_types_array, 0, MEM_RELEASE);
+                free_mem_rel32(old_types_array);
 
             recover_mem("waddler_drop");
             modified = false;
@@ -1572,6 +1552,7 @@ void change_waddler_drop(std::vector<ENT_TYPE> ent_types)
     if ((!modified && ent_types.size() == 3) ||                         // if it's the unchanged instruction and we set the same number of ent_type's
         (modified && memory_read<uint8_t>(offset) == ent_types.size())) // or new instruction but the same size
     {
+        MemoryPatchBatch batch;
         for (unsigned int i = 0; i < ent_types.size(); ++i)
             write_mem_recoverable("waddler_drop", (size_t)&old_types_array[i], ent_types[i], true);
 
@@ -1584,7 +1565,7 @@ void change_waddler_drop(std::vector<ENT_TYPE> ent_types)
     if (new_array)
     {
         if (modified)
-            VirtualFree(old_types_array, 0, MEM_RELEASE);
+            free_mem_rel32(old_types_array);
 
         memcpy(new_array, ent_types.data(), data_size);
         int32_t rel = static_cast<int32_t>((size_t)new_array - (array_offset + 4));
@@ -1831,7 +1812,7 @@ void set_level_string(std::u16string_view text)
     {
         if (text_data_length != 0)
         {
-            VirtualFree(data, 0, MEM_RELEASE);
+            free_mem_rel32(data);
         }
         text_data_length = text.length() == 0 ? 1 : text.length(); // just to make sure it's not set to 0
 
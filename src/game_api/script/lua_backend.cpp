@@ -14,6 +14,7 @@
 #include "constants.hpp"                    // for no_return_str
 #include "entities_chars.hpp"               // for Player
 #include "entity.hpp"                       // for Entity, get_entity_ptr
+#include "entity_change_feed.hpp"           // for unsubscribe_entity_changes
 #include "handle_lua_function.hpp"          // for handle_function
 #include "items.hpp"                        // for Inventory
 #include "level_api.hpp"                    // for LevelGenData, LevelGenSy...
@@ -23,12 +24,15 @@
 #include "math.hpp"                         // for AABB
 #include "movable_behavior.hpp"             // for CustomMovableBehavior
 #include "overloaded.hpp"                   // for overloaded
+#include "prng.hpp"                         // for PRNG
+#include "prng_history.hpp"                 // for PrngHistory
 #include "rpc.hpp"                          // for get_frame_count, get_pla...
 #include "screen.hpp"                       // for get_screen_ptr, Screen
 #include "script_util.hpp"                  // for InputString
 #include "sound_manager.hpp"                // for SoundManager
 #include "state.hpp"                        // for StateMemory, State, get_...
 #include "strings.hpp"                      // for clear_custom_shopitem_names
+#include "texture_compression.hpp"          // for clear_texture_compressions
 #include "usertypes/gui_lua.hpp"            // for GuiDrawContext
 #include "usertypes/level_lua.hpp"          // for PreHandleRoomTilesContext
 #include "usertypes/save_context.hpp"       // for LoadContext, SaveContext
@@ -98,6 +102,12 @@ void LuaBackend::clear_all_callbacks()
         sound_manager->clear_callback(id);
     }
     vanilla_sound_callbacks.clear();
+    for (auto id : entity_change_feeds)
+    {
+        unsubscribe_entity_changes(id);
+    }
+    entity_change_feeds.clear();
+    clear_texture_compressions(self);
     pre_tile_code_callbacks.clear();
     post_tile_code_callbacks.clear();
     pre_entity_spawn_callbacks.clear();
@@ -383,6 +393,13 @@ bool LuaBackend::update()
             }
         }
 
+        if (!g_state->pause && get_frame_count() != state.time_global &&
+            ((g_state->screen >= (int)ON::CAMP && g_state->screen <= (int)ON::DEATH) || g_state->screen == (int)ON::ARENA_MATCH))
+        {
+            // Same condition as ON.GAMEFRAME, the history is shared so only the first script to get here records the frame
+            PrngHistory::get().record(now, PRNG::get());
+        }
+
         for (auto& [id, callback] : callbacks)
         {
             if (is_callback_cleared(id))
@@ -269,6 +269,7 @@ class LuaBackend
     std::unordered_map<int, ScreenCallback> callbacks;
     std::unordered_map<int, ScreenCallback> load_callbacks;
     std::vector<std::uint32_t> vanilla_sound_callbacks;
+    std::vector<std::uint32_t> entity_change_feeds;
     std::vector<LevelGenCallback> pre_tile_code_callbacks;
     std::vector<LevelGenCallback> post_tile_code_callbacks;
     std::vector<EntitySpawnCallback> pre_entity_spawn_callbacks;
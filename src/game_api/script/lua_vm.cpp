@@ -36,6 +36,7 @@
 #include "entity.hpp"                              // for get_entity_ptr
 #include "game_manager.hpp"                        // for get_game_manager
 #include "handle_lua_function.hpp"                 // for handle_function
+#include "hook_registry.hpp"                       // for install_lazy_hooks
 #include "items.hpp"                               // for Inventory
 #include "layer.hpp"                               // for g_level_max_x
 #include "lua_backend.hpp"                         // for LuaBackend, ON
@@ -74,7 +75,9 @@
 #include "usertypes/entities_monsters_lua.hpp"     // for register_usertypes
 #include "usertypes/entities_mounts_lua.hpp"       // for register_usertypes
 #include "usertypes/entity_casting_lua.hpp"        // for register_usertypes
+#include "usertypes/entity_change_feed_lua.hpp"    // for register_usertypes
 #include "usertypes/entity_lua.hpp"                // for register_usertypes
+#include "usertypes/entity_snapshot_lua.hpp"       // for register_usertypes
 #include "usertypes/flags_lua.hpp"                 // for register_usertypes
 #include "usertypes/game_manager_lua.hpp"          // for register_usertypes
 #include "usertypes/gui_lua.hpp"                   // for register_usertypes
@@ -158,6 +161,8 @@ end
     NVanillaRender::register_usertypes(lua);
     NTexture::register_usertypes(lua);
     NEntity::register_usertypes(lua);
+    NEntitySnapshot::register_usertypes(lua);
+    NEntityChangeFeed::register_usertypes(lua);
     NEntitiesChars::register_usertypes(lua);
     NEntitiesFloors::register_usertypes(lua);
     NEntitiesActiveFloors::register_usertypes(lua);
@@ -363,6 +368,8 @@ end
     {
         auto backend = LuaBackend::get_calling_backend();
         auto luaCb = ScreenCallback{cb, event, -1};
+        if (event == ON::RENDER_POST_JOURNAL_PAGE)
+            install_lazy_hooks("render_journal_page"); // Nobody else needs these, so they are only attached once a script asks for them
         if (luaCb.screen == ON::LOAD)
             backend->load_callbacks[backend->cbcount] = luaCb; // Make sure load always runs before other callbacks
         else
@@ -846,6 +853,15 @@ end
     /// NoDoc
     /// Get the [Entity](#Entity) behind an uid, without converting to the correct type (do not use, use `get_entity` instead)
     lua["get_entity_raw"] = get_entity_ptr;
+    /// Get the Entity behind each uid in `uids`, converted to the correct type, with `nil` for uids that don't exist. Faster than calling [get_entity](#get_entity) for every uid.
+    // lua["get_entities_from_uids"] = [](std::vector<uint32_t> uids) -> std::vector<Entity*> {};
+    /// NoDoc
+    lua["get_entities_raw"] = [](std::vector<uint32_t> uids) -> std::vector<Entity*>
+    {
+        std::vector<Entity*> entities(uids.size());
+        get_entity_ptrs(uids, entities);
+        return entities;
+    };
     lua.script(R"##(
         function cast_entity(entity_raw)
             if entity_raw == nil then
@@ -871,6 +887,17 @@ end
 
             return cast_entity(entity_raw)
         end
+        function get_entities_from_uids(uids)
+            local entities_raw = get_entities_raw(uids)
+            local entities = {}
+            for i = 1, #uids do
+                local entity_raw = entities_raw[i]
+                if entity_raw ~= nil then
+                    entities[i] = cast_entity(entity_raw)
+                end
+            end
+            return entities
+        end
         )##");
     /// Get the [EntityDB](#EntityDB) behind an ENT_TYPE...
     lua["get_type"] = get_type;
@@ -0,0 +1,77 @@
+#include "entity_change_feed_lua.hpp"
+
+#include <algorithm>   // for find
+#include <optional>    // for optional
+#include <sol/sol.hpp> // for global_table, proxy_key_t, state, readonly
+#include <span>        // for span
+#include <vector>      // for vector
+
+#include "entity_change_feed.hpp" // for EntityChangeDelta, subscribe_entity_changes, ...
+#include "script/lua_backend.hpp" // for LuaBackend
+
+namespace NEntityChangeFeed
+{
+void register_usertypes(sol::state& lua)
+{
+    /// Starts recording which entities spawn and get destroyed, pull the changes with `pull_entity_changes`. Much cheaper than comparing `get_entities_by` results every frame.
+    /// If `move_epsilon` is bigger than 0 entities that moved further than that since they were last reported are returned as well.
+    /// Only the entities in `move_uids` and those added with `watch_entity_moves` are checked for moves, leave it out to check every entity, which costs a lookup per entity in the level on every pull.
+    /// Changes are kept for a limited time, pull at least every few frames or `overflowed` will be set on the next pull.
+    lua["subscribe_entity_changes"] = [](std::optional<float> move_epsilon, std::optional<std::vector<uint32_t>> move_uids) -> EntityChangeFeedId
+    {
+        std::optional<std::span<const uint32_t>> move_uids_span;
+        if (move_uids)
+        {
+            move_uids_span = *move_uids;
+        }
+        const EntityChangeFeedId id = subscribe_entity_changes(move_epsilon.value_or(0.0f), move_uids_span);
+        LuaBackend::get_calling_backend()->entity_change_feeds.push_back(id);
+        return id;
+    };
+    /// Stops a subscription created with `subscribe_entity_changes`
+    lua["unsubscribe_entity_changes"] = [](EntityChangeFeedId id)
+    {
+        auto backend = LuaBackend::get_calling_backend();
+        auto it = std::find(backend->entity_change_feeds.begin(), backend->entity_change_feeds.end(), id);
+        if (it != backend->entity_change_feeds.end())
+        {
+            unsubscribe_entity_changes(id);
+            backend->entity_change_feeds.erase(it);
+        }
+    };
+    /// Adds entities to the ones a subscription created with `move_uids` checks for moves
+    lua["watch_entity_moves"] = [](EntityChangeFeedId id, std::vector<uint32_t> uids)
+    {
+        auto backend = LuaBackend::get_calling_backend();
+        if (std::find(backend->entity_change_feeds.begin(), backend->entity_change_feeds.end(), id) != backend->entity_change_feeds.end())
+        {
+            watch_entity_moves(id, uids);
+        }
+    };
+    /// Returns everything that changed since the last call for this subscription, or `nil` if the subscription does not exist
+    lua["pull_entity_changes"] = [](EntityChangeFeedId id) -> std::optional<EntityChangeDelta>
+    {
+        auto backend = LuaBackend::get_calling_backend();
+        if (std::find(backend->entity_change_feeds.begin(), backend->entity_change_feeds.end(), id) == backend->entity_change_feeds.end())
+        {
+            return std::nullopt;
+        }
+        return pull_entity_changes(id);
+    };
+
+    /// Returned by `pull_entity_changes`
+    lua.new_usertype<EntityChangeDelta>(
+        "EntityChangeDelta",
+        sol::no_constructor,
+        "frame",
+        sol::readonly(&EntityChangeDelta::frame),
+        "spawned",
+        sol::readonly(&EntityChangeDelta::spawned),
+        "destroyed",
+        sol::readonly(&EntityChangeDelta::destroyed),
+        "moved",
+        sol::readonly(&EntityChangeDelta::moved),
+        "overflowed",
+        sol::readonly(&EntityChangeDelta::overflowed));
+}
+} // namespace NEntityChangeFeed
@@ -0,0 +1,126 @@
+#include "entity_snapshot_lua.hpp"
+
+#include <cstdint>     // for uint32_t
+#include <optional>    // for optional
+#include <sol/sol.hpp> // for global_table, proxy_key_t, state, readonly, as_table
+#include <vector>      // for vector
+
+#include "aliases.hpp"         // for LAYER
+#include "entity_snapshot.hpp" // for EntitySnapshot, take_entity_snapshot, SNAPSHOT_COLUMN
+
+namespace NEntitySnapshot
+{
+void register_usertypes(sol::state& lua)
+{
+    /// Copies the `columns` (a combination of [SNAPSHOT_COLUMN](#SNAPSHOT_COLUMN), default `SNAPSHOT_COLUMN.ALL`) of every entity in `layer` (default `LAYER.BOTH`) in a single pass.
+    /// Use this instead of `get_entity` and reading fields in a loop when looking at the whole level, the snapshot does not change when the entities do.
+    lua["get_entity_snapshot"] = [](std::optional<uint32_t> columns, std::optional<LAYER> layer) -> EntitySnapshot
+    {
+        return take_entity_snapshot(columns.value_or(static_cast<uint32_t>(SNAPSHOT_COLUMN::ALL)), layer.value_or(LAYER::BOTH));
+    };
+
+    auto get_column = [](const EntitySnapshot& self, SNAPSHOT_COLUMN column, sol::this_state s) -> sol::object
+    {
+        switch (column)
+        {
+        case SNAPSHOT_COLUMN::UID:
+            return sol::make_object(s, sol::as_table(self.uid));
+        case SNAPSHOT_COLUMN::TYPE:
+            return sol::make_object(s, sol::as_table(self.type));
+        case SNAPSHOT_COLUMN::X:
+            return sol::make_object(s, sol::as_table(self.x));
+        case SNAPSHOT_COLUMN::Y:
+            return sol::make_object(s, sol::as_table(self.y));
+        case SNAPSHOT_COLUMN::LAYER:
+            return sol::make_object(s, sol::as_table(self.layer));
+        case SNAPSHOT_COLUMN::FLAGS:
+            return sol::make_object(s, sol::as_table(self.flags));
+        case SNAPSHOT_COLUMN::MORE_FLAGS:
+            return sol::make_object(s, sol::as_table(self.more_flags));
+        case SNAPSHOT_COLUMN::MASK:
+            return sol::make_object(s, sol::as_table(self.mask));
+        case SNAPSHOT_COLUMN::OVERLAY:
+            return sol::make_object(s, sol::as_table(self.overlay));
+        case SNAPSHOT_COLUMN::HEALTH:
+            return sol::make_object(s, sol::as_table(self.health));
+        default:
+            return sol::lua_nil;
+        }
+    };
+
+    /// Returned by `get_entity_snapshot`, every column is an array with one value per entity, columns that were not requested are empty.
+    /// Indexing a column (`snapshot.x[i]`) goes through the game for every access, `get_column` copies a whole column into a plain Lua table at once, which is faster to loop over.
+    lua.new_usertype<EntitySnapshot>(
+        "EntitySnapshot",
+        sol::no_constructor,
+        "columns",
+        sol::readonly(&EntitySnapshot::columns),
+        "size",
+        sol::readonly(&EntitySnapshot::size),
+        "uid",
+        sol::readonly(&EntitySnapshot::uid),
+        "type",
+        sol::readonly(&EntitySnapshot::type),
+        "x",
+        sol::readonly(&EntitySnapshot::x),
+        "y",
+        sol::readonly(&EntitySnapshot::y),
+        "layer",
+        sol::readonly(&EntitySnapshot::layer),
+        "flags",
+        sol::readonly(&EntitySnapshot::flags),
+        "more_flags",
+        sol::readonly(&EntitySnapshot::more_flags),
+        "mask",
+        sol::readonly(&EntitySnapshot::mask),
+        "overlay",
+        sol::readonly(&EntitySnapshot::overlay),
+        "health",
+        sol::readonly(&EntitySnapshot::health),
+        "get_column",
+        get_column);
+
+    lua.create_named_table(
+        "SNAPSHOT_COLUMN",
+        "UID",
+        SNAPSHOT_COLUMN::UID,
+        "TYPE",
+        SNAPSHOT_COLUMN::TYPE,
+        "X",
+        SNAPSHOT_COLUMN::X,
+        "Y",
+        SNAPSHOT_COLUMN::Y,
+        "LAYER",
+        SNAPSHOT_COLUMN::LAYER,
+        "FLAGS",
+        SNAPSHOT_COLUMN::FLAGS,
+        "MORE_FLAGS",
+        SNAPSHOT_COLUMN::MORE_FLAGS,
+        "MASK",
+        SNAPSHOT_COLUMN::MASK,
+        "OVERLAY",
+        SNAPSHOT_COLUMN::OVERLAY,
+        "HEALTH",
+        SNAPSHOT_COLUMN::HEALTH,
+        "ALL",
+        SNAPSHOT_COLUMN::ALL);
+    /* SNAPSHOT_COLUMN
+    // UID
+    // TYPE
+    // ENT_TYPE of the entity
+    // X
+    // Absolute position, including overlays
+    // Y
+    // LAYER
+    // FLAGS
+    // MORE_FLAGS
+    // MASK
+    // Search flags of the entity type, see MASK
+    // OVERLAY
+    // Uid of the overlay, -1 if there is none
+    // HEALTH
+    // 0 for entities that are not movable
+    // ALL
+    */
+}
+} // namespace NEntitySnapshot
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace sol
+{
+class state;
+} // namespace sol
+
+namespace NEntitySnapshot
+{
+void register_usertypes(sol::state& lua);
+};
@@ -1,16 +1,21 @@
 #include "prng_lua.hpp"
 
-#include <algorithm>   // for max
-#include <cstdint>     // for int64_t
-#include <new>         // for operator new
-#include <optional>    // for optional
-#include <sol/sol.hpp> // for global_table, proxy_key_t, state, overload, call
-#include <string>      // for allocator, operator==
-#include <tuple>       // for get
-#include <type_traits> // for move, declval
-#include <utility>     // for min, max, get
-
-#include "prng.hpp" // for PRNG, PRNG::ENTITY_VARIATION, PRNG::EXTRA_SPAWNS
+#include <algorithm>     // for max
+#include <cstdint>       // for int64_t
+#include <limits>        // for numeric_limits
+#include <new>           // for operator new
+#include <optional>      // for optional
+#include <sol/sol.hpp>   // for global_table, proxy_key_t, state, overload, call
+#include <string>        // for allocator, operator==
+#include <tuple>         // for get
+#include <type_traits>   // for move, declval
+#include <unordered_map> // for unordered_map
+#include <utility>       // for min, max, get
+#include <vector>        // for vector
+
+#include "prng.hpp"         // for PRNG, PRNG::ENTITY_VARIATION, PRNG::EXTRA_SPAWNS
+#include "prng_batch.hpp"   // for random_int
+#include "prng_history.hpp" // for PrngHistory
 
 namespace NPRNG
 {
@@ -18,12 +23,72 @@ void register_usertypes(sol::state& lua)
 {
     auto random = sol::overload(static_cast<float (PRNG::*)()>(&PRNG::random), static_cast<std::optional<std::int64_t> (PRNG::*)(std::int64_t)>(&PRNG::random), static_cast<std::optional<std::int64_t> (PRNG::*)(std::int64_t, std::int64_t)>(&PRNG::random));
 
+    // Lua numbers go straight into the prng, so keep classes inside the 10 pairs and counts small enough to not stall the game thread
+    static constexpr int64_t c_max_advance{1 << 24};
+    static constexpr int64_t c_max_peek{1 << 16};
+    static constexpr int64_t c_max_batch_values{1 << 22};
+    auto is_valid_class = [](PRNG::PRNG_CLASS type)
+    {
+        return type >= 0 && type <= 9;
+    };
+
+    auto advance = [is_valid_class](PRNG& prng, PRNG::PRNG_CLASS type, int64_t count) -> bool
+    {
+        if (!is_valid_class(type) || count < 0 || count > c_max_advance)
+        {
+            return false;
+        }
+        prng.advance(type, static_cast<size_t>(count));
+        return true;
+    };
+    auto peek = [is_valid_class](PRNG& prng, PRNG::PRNG_CLASS type, int64_t count) -> std::optional<std::vector<int64_t>>
+    {
+        if (!is_valid_class(type) || count < 0 || count > c_max_peek)
+        {
+            return std::nullopt;
+        }
+        const size_t size = static_cast<size_t>(count);
+        std::vector<PRNG::prng_pair> pairs(size);
+        prng.peek(type, pairs);
+        std::vector<int64_t> values(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            values[i] = static_cast<int64_t>(pairs[i].first);
+        }
+        return values;
+    };
+
     /// Seed the game prng.
     lua["seed_prng"] = [](int64_t seed)
     {
         PRNG::get().seed(seed);
     };
 
+    /// Evaluates `random_int(min, max, prng_class)` `draw_count` times for every seed in `seeds`, as if `seed_prng` had just been called with that seed.
+    /// Returns an array of results per seed in the same order as `seeds`, or `nil` if `max < min`, `draw_count` is not positive or `#seeds * draw_count` is above 4194304.
+    /// Does not touch the game prng, use this to search for seeds without generating levels.
+    lua["prng_batch_random_int"] = [is_valid_class](std::vector<int64_t> seeds, PRNG::PRNG_CLASS prng_class, int64_t draw_count, int64_t min, int64_t max) -> std::optional<std::vector<std::vector<int64_t>>>
+    {
+        if (max < min || max == std::numeric_limits<int64_t>::max() || !is_valid_class(prng_class))
+        {
+            return std::nullopt;
+        }
+        if (draw_count <= 0 || draw_count > c_max_batch_values || seeds.size() > static_cast<size_t>(c_max_batch_values / draw_count))
+        {
+            return std::nullopt;
+        }
+        const size_t draws = static_cast<size_t>(draw_count);
+
+        const std::vector<int64_t> values = PrngBatch::random_int(seeds, prng_class, draws, min, max);
+        std::vector<std::vector<int64_t>> results(seeds.size());
+        for (size_t i = 0; i < seeds.size(); ++i)
+        {
+            const auto first = values.begin() + i * draws;
+            results[i].assign(first, first + draws);
+        }
+        return results;
+    };
+
     /// PRNG (short for Pseudo-Random-Number-Generator) holds 10 128bit wide buffers of memory that are mutated on every generation of a random number.
     /// The game uses specific buffers for specific scenarios, for example the third buffer is used every time particles are spawned to determine a random velocity.
     /// The used buffer is determined by [PRNG_CLASS](#PRNG_CLASS). If you want to make a mod that does not affect level generation but still uses the prng then you want to stay away from specific buffers.
@@ -42,6 +107,10 @@ void register_usertypes(sol::state& lua)
         &PRNG::random_int,
         "random",
         random,
+        "advance",
+        advance,
+        "peek",
+        peek,
         "get_pair",
         &PRNG::get_pair,
         "set_pair",
@@ -50,6 +119,29 @@ void register_usertypes(sol::state& lua)
     /// The global prng state, calling any function on it will advance the prng state, thus desynchronizing clients if it does not happen on both clients.
     lua["prng"] = &PRNG::get();
 
+    /// Keep a history of the global prng for the last `frames` game frames, recorded at the same time as `ON.GAMEFRAME`. Set to 0 to stop recording, which is the default.
+    /// Frames where a lot of classes advance take more space, so fewer frames may be kept than requested.
+    lua["set_prng_history_size"] = [](size_t frames)
+    {
+        PrngHistory::get().set_capacity(frames);
+    };
+    /// Returns the first and last frame (as in `get_frame`) that can be restored with `restore_prng`, or `nil` if nothing was recorded yet
+    lua["get_prng_history_range"] = []() -> std::optional<std::pair<uint32_t, uint32_t>>
+    {
+        return PrngHistory::get().get_range();
+    };
+    /// Set the global prng back to the state it had at `frame`, returns `false` if that frame is not in the history. See `set_prng_history_size`
+    lua["restore_prng"] = [](uint32_t frame) -> bool
+    {
+        return PrngHistory::get().restore(frame, PRNG::get());
+    };
+    /// Compare the recorded prng at two frames, returns a table mapping every [PRNG_CLASS](#PRNG_CLASS) that changed to the number of draws it advanced by,
+    /// or -1 if it was changed in another way (e.g. reseeded). Returns `nil` if either frame is not in the history
+    lua["get_prng_diff"] = [](uint32_t from_frame, uint32_t to_frame) -> std::optional<std::unordered_map<int, int64_t>>
+    {
+        return PrngHistory::get().diff(from_frame, to_frame);
+    };
+
     /// Determines what class of prng is used, which in turn determines which parts of the game's future prng is affected. See more info at [PRNG](#PRNG)
     /// For example when choosing `PRNG_CLASS.PROCEDURAL_SPAWNS` to generate a random number, random Tiamat spawns will not be affected.
     /// Any integer in the range [0, 9] is a valid class, some are however not documented because of missing information.
@@ -2,7 +2,6 @@
 
 #include <Windows.h>             // for GetModuleHandleA, GetProcAddress
 #include <algorithm>             // for max
-#include <detours.h>             // for DetourAttach, DetourTransactionBegin
 #include <exception>             // for exception
 #include <new>                   // for operator new
 #include <sockpp/inet_address.h> // for inet_address
@@ -16,6 +15,7 @@
 #include <winsock2.h>            // for sockaddr_in, SOCKET
 #include <ws2tcpip.h>            // for inet_ntop
 
+#include "hook_registry.hpp"      // for attach_hook, HookTransaction
 #include "logger.h"               // for DEBUG, ByteStr
 #include "script/lua_backend.hpp" // for LuaBackend
 #include "script/safe_cb.hpp"     // for make_safe_cb
@@ -94,15 +94,9 @@ void register_usertypes(sol::state& lua)
     {
         g_sendto_trampoline = (NetFun*)GetProcAddress(GetModuleHandleA("ws2_32.dll"), "sendto");
         g_recvfrom_trampoline = (NetFun*)GetProcAddress(GetModuleHandleA("ws2_32.dll"), "recvfrom");
-        DetourTransactionBegin();
-        DetourUpdateThread(GetCurrentThread());
-        DetourAttach((void**)&g_sendto_trampoline, mySendto);
-        DetourAttach((void**)&g_recvfrom_trampoline, myRecvfrom);
-        const LONG error = DetourTransactionCommit();
-        if (error != NO_ERROR)
-        {
-            DEBUG("Failed hooking network: {}\n", error);
-        }
+        HookTransaction hooks;
+        attach_hook("sendto", (void**)&g_sendto_trampoline, mySendto);
+        attach_hook("recvfrom", (void**)&g_recvfrom_trampoline, myRecvfrom);
     };
 }
 }; // namespace NSocket
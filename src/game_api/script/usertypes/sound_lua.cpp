@@ -27,7 +27,7 @@
 #include "logger.h"               // for DEBUG
 #include "script/lua_backend.hpp" // for LuaBackend
 #include "script/safe_cb.hpp"     // for make_safe_cb
-#include "sound_manager.hpp"      // for CustomSound, PlayingSound, SoundMa...
+#include "sound_manager.hpp"      // for CustomSound, PendingSound, PlayingSound, ...
 #include "string_aliases.hpp"     // for VANILLA_SOUND
 
 namespace NSound
@@ -47,16 +47,27 @@ void register_usertypes(sol::state& lua, SoundManager* sound_manager)
     }
 
     /// Loads a sound from disk relative to this script, ownership might be shared with other code that loads the same file. Returns nil if file can't be found
-    lua["create_sound"] = [](std::string path) -> sol::optional<CustomSound>
+    /// Pass `SOUND_TYPE.MUSIC` to stream the file while it plays instead of loading it all at once, which keeps memory low for long tracks.
+    /// Streamed sounds are not shared and can only be played once at a time.
+    lua["create_sound"] = [](std::string path, std::optional<SOUND_TYPE> sound_type) -> sol::optional<CustomSound>
     {
         auto backend = LuaBackend::get_calling_backend();
-        if (CustomSound sound = backend->sound_manager->get_sound((backend->get_root_path() / path).string()))
+        auto full_path = (backend->get_root_path() / path).string();
+        if (CustomSound sound = sound_type == SOUND_TYPE::Music ? backend->sound_manager->get_stream(std::move(full_path)) : backend->sound_manager->get_sound(std::move(full_path)))
         {
             return sound;
         }
         return sol::nullopt;
     };
 
+    /// Loads a sound from disk relative to this script on a background thread, so loading many sounds doesn't freeze the game.
+    /// Returns a `PendingSound`, call `PendingSound:get()` once `PendingSound:is_ready()` returns true to get the sound
+    lua["create_sound_async"] = [](std::string path) -> PendingSound
+    {
+        auto backend = LuaBackend::get_calling_backend();
+        return backend->sound_manager->get_sound_async((backend->get_root_path() / path).string());
+    };
+
     /// Gets an existing sound, either if a file at the same path was already loaded or if it is already loaded by the game
     lua["get_sound"] = [](std::string path_or_vanilla_sound) -> sol::optional<CustomSound>
     {
@@ -124,6 +135,23 @@ void register_usertypes(sol::state& lua, SoundManager* sound_manager)
             get_parameters);
     }
 
+    auto pending_get = [](PendingSound& self) -> sol::optional<CustomSound>
+    {
+        if (CustomSound sound = self.get())
+        {
+            return sound;
+        }
+        return sol::nullopt;
+    };
+    /// Handle to a sound that is being loaded in the background, returned by `create_sound_async`
+    /// `get()` returns nil while the sound is still loading or if it failed to load
+    lua.new_usertype<PendingSound>(
+        "PendingSound",
+        "is_ready",
+        &PendingSound::is_ready,
+        "get",
+        pending_get);
+
     auto set_callback = [](PlayingSound* sound, sol::function callback)
     {
         sound->set_callback(make_safe_cb<void()>(std::move(callback)));
@@ -18,7 +18,7 @@
 #include "aliases.hpp"            // for TEXTURE
 #include "file_api.hpp"           // for get_image_file_path
 #include "script/lua_backend.hpp" // for LuaBackend
-#include "texture.hpp"            // for TextureDefinition, get_texture
+#include "texture.hpp"            // for TextureDefinition, TEXTURE_COMPRESSION, get_texture
 
 namespace NTexture
 {
@@ -35,7 +35,7 @@ void register_usertypes(sol::state& lua)
     {
         auto backend = LuaBackend::get_calling_backend();
         texture_data.texture_path = get_image_file_path(backend->get_root(), std::move(texture_data.texture_path));
-        return define_texture(std::move(texture_data));
+        return define_texture(std::move(texture_data), backend->self);
     };
     /// Gets a texture with the same definition as the given, if none exists returns `nil`
     lua["get_texture"] = [](TextureDefinition texture_data) -> std::optional<TEXTURE>
@@ -65,6 +65,7 @@ void register_usertypes(sol::state& lua)
     /// `tile_width` and `tile_height` define the size of a single tile, the image will automatically be divided into these tiles.
     /// Tiles are labeled in sequence starting at the top left, going right and down at the end of the image (you know, like sentences work in the English language). Use those numbers in `Entity::animation_frame`.
     /// `sub_image_offset_x`, `sub_image_offset_y`, `sub_image_width` and `sub_image_height` can be used if only a part of the image should be used. Leave them at zero to ignore this.
+    /// `compression` selects a block compressed format for png/bmp/tga images, see [TEXTURE_COMPRESSION](#TEXTURE_COMPRESSION). Compressed textures need `width` and `height` to be multiples of 4, otherwise they are loaded uncompressed.
     lua.new_usertype<TextureDefinition>(
         "TextureDefinition",
         "texture_path",
@@ -84,7 +85,23 @@ void register_usertypes(sol::state& lua)
         "sub_image_width",
         &TextureDefinition::sub_image_width,
         "sub_image_height",
-        &TextureDefinition::sub_image_height);
+        &TextureDefinition::sub_image_height,
+        "compression",
+        &TextureDefinition::compression);
+
+    lua.create_named_table("TEXTURE_COMPRESSION", "DEFAULT", TEXTURE_COMPRESSION::DEFAULT, "NONE", TEXTURE_COMPRESSION::NONE, "BC1", TEXTURE_COMPRESSION::BC1, "BC3", TEXTURE_COMPRESSION::BC3, "BC7", TEXTURE_COMPRESSION::BC7);
+    /* TEXTURE_COMPRESSION
+    // DEFAULT
+    // Use the compression selected in the Overlunky settings, uncompressed unless changed
+    // NONE
+    // Uncompressed 32-bit RGBA, 4 bytes per pixel
+    // BC1
+    // 0.5 bytes per pixel, 1-bit alpha, for opaque or cut-out sprites
+    // BC3
+    // 1 byte per pixel, smooth alpha
+    // BC7
+    // 1 byte per pixel, best quality
+    */
 
     lua.create_named_table("TEXTURE"
                            //, "DATA_TEXTURES_PLACEHOLDER_0", 0
@@ -1,11 +1,16 @@
 #include "sound_manager.hpp"
 
-#include <Windows.h> // for GetProcAddress, GetModuleHandle, HMODULE
-#include <algorithm> // for clamp
-#include <cstdint>   // for uint32_t
-#include <exception> // for exception
-#include <memory>    // for remove_if, unique_ptr
-#include <mutex>     // for lock_guard, mutex
+#include <Windows.h>          // for GetProcAddress, GetModuleHandle, HMODULE
+#include <algorithm>          // for clamp
+#include <atomic>             // for atomic_bool
+#include <condition_variable> // for condition_variable
+#include <cstring>            // for memset
+#include <cstdint>            // for uint32_t
+#include <deque>              // for deque
+#include <exception>          // for exception
+#include <memory>             // for remove_if, unique_ptr
+#include <mutex>              // for lock_guard, mutex
+#include <thread>             // for thread
 
 #include "entity.hpp"             //
 #include "logger.h"               // for DEBUG
@@ -279,16 +284,167 @@ bool PlayingSound::set_parameter(VANILLA_SOUND_PARAM parameter_index, float valu
     return m_SoundManager->set_parameter(*this, parameter_index, value);
 }
 
+struct PendingSoundState
+{
+    std::string path;
+    std::atomic_bool done{false};
+    std::shared_ptr<const DecodedAudioBuffer> buffer;
+};
+
+PendingSound::PendingSound(std::shared_ptr<PendingSoundState> state, SoundManager* sound_manager)
+    : m_State{std::move(state)}, m_SoundManager{sound_manager}
+{
+}
+
+bool PendingSound::is_ready()
+{
+    return m_State == nullptr || m_State->done.load(std::memory_order_acquire);
+}
+CustomSound PendingSound::get()
+{
+    if (!is_ready() || m_SoundManager == nullptr)
+    {
+        return CustomSound{nullptr, nullptr};
+    }
+    if (CustomSound sound = m_SoundManager->get_existing_sound(m_State->path))
+    {
+        return sound;
+    }
+    if (m_State->buffer == nullptr)
+    {
+        return CustomSound{nullptr, nullptr};
+    }
+    return m_SoundManager->create_sound(m_State->path, m_State->buffer);
+}
+
+struct SoundManager::Stream
+{
+    std::unique_ptr<AudioStream> decoder;
+};
+
 struct SoundManager::Sound
 {
     std::uint32_t ref_count;
-    DecodedAudioBuffer buffer;
+    DecodedAudioBufferPtr buffer;
+    std::unique_ptr<Stream> stream;
+    bool streamed{false};
     std::string path;
     FMOD::Sound* fmod_sound{nullptr};
 };
 
-SoundManager::SoundManager(DecodeAudioFile* decode_function)
-    : m_DecodeFunction{decode_function}
+struct SoundManager::DecodeCache
+{
+    static constexpr std::size_t c_MaxSize{256 * 1024 * 1024};
+
+    struct Entry
+    {
+        DecodedAudioBufferPtr buffer;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    std::mutex lock;
+    std::unordered_map<std::string, Entry, PathHash, std::equal_to<>> decoded;
+    std::list<std::string> lru; // most recently used at the front
+    std::size_t total_size{0};
+
+    std::unordered_map<std::string, std::shared_ptr<PendingSoundState>, PathHash, std::equal_to<>> in_flight;
+    std::condition_variable decode_done;
+
+    std::deque<std::shared_ptr<PendingSoundState>> queue;
+    std::condition_variable queue_not_empty;
+    std::thread worker;
+    bool stop{false};
+
+    DecodedAudioBufferPtr find(std::string_view path)
+    {
+        auto it = decoded.find(path);
+        if (it == decoded.end())
+        {
+            return nullptr;
+        }
+        lru.splice(lru.begin(), lru, it->second.lru_it);
+        return it->second.buffer;
+    }
+
+    void insert(const std::string& path, DecodedAudioBufferPtr buffer)
+    {
+        if (decoded.contains(path))
+        {
+            return;
+        }
+
+        total_size += buffer->data_size;
+        lru.push_front(path);
+        decoded[path] = Entry{std::move(buffer), lru.begin()};
+
+        // Only evict buffers that no loaded sound uses anymore, those wouldn't free any memory
+        for (auto it = lru.end(); it != lru.begin() && total_size > c_MaxSize;)
+        {
+            --it;
+            auto entry_it = decoded.find(*it);
+            if (entry_it->second.buffer.use_count() == 1)
+            {
+                total_size -= entry_it->second.buffer->data_size;
+                decoded.erase(entry_it);
+                it = lru.erase(it);
+            }
+        }
+    }
+
+    void run(DecodeAudioFile* decode_function)
+    {
+        while (true)
+        {
+            std::shared_ptr<PendingSoundState> state;
+            {
+                std::unique_lock unique_lock{lock};
+                queue_not_empty.wait(unique_lock, [this]()
+                                     { return stop || !queue.empty(); });
+                if (stop)
+                {
+                    return;
+                }
+                state = std::move(queue.front());
+                queue.pop_front();
+            }
+
+            DecodedAudioBufferPtr buffer = decode(decode_function, state->path);
+            {
+                std::lock_guard lock_guard{lock};
+                complete(*state, std::move(buffer));
+            }
+            decode_done.notify_all();
+        }
+    }
+
+    static DecodedAudioBufferPtr decode(DecodeAudioFile* decode_function, const std::string& path)
+    {
+        try
+        {
+            return std::make_shared<const DecodedAudioBuffer>(decode_function(path.c_str()));
+        }
+        catch (std::exception& except)
+        {
+            DEBUG("Failed loading audio file {}\n{}", path, except.what());
+            return nullptr;
+        }
+    }
+
+    // Must be called with `lock` held, waiters on `decode_done` have to be notified afterwards
+    void complete(PendingSoundState& state, DecodedAudioBufferPtr buffer)
+    {
+        if (buffer != nullptr)
+        {
+            insert(state.path, buffer);
+        }
+        in_flight.erase(state.path);
+        state.buffer = std::move(buffer);
+        state.done.store(true, std::memory_order_release);
+    }
+};
+
+SoundManager::SoundManager(DecodeAudioFile* decode_function, OpenAudioStream* open_stream_function)
+    : m_DecodeFunction{decode_function}, m_OpenStreamFunction{open_stream_function}, m_DecodeCache{std::make_unique<DecodeCache>()}
 {
     m_IsInit = true;
 #define AUDIO_INIT_ERROR(format, ...) \
@@ -416,6 +572,8 @@ SoundManager::SoundManager(DecodeAudioFile* decode_function)
         m_CreateSound = reinterpret_cast<FMOD::CreateSound*>(GetProcAddress(fmod, "FMOD_System_CreateSound"));
         m_ReleaseSound = reinterpret_cast<FMOD::ReleaseSound*>(GetProcAddress(fmod, "FMOD_Sound_Release"));
         m_PlaySound = reinterpret_cast<FMOD::PlaySound*>(GetProcAddress(fmod, "FMOD_System_PlaySound"));
+        m_SoundGetUserData = reinterpret_cast<FMOD::SoundGetUserData*>(GetProcAddress(fmod, "FMOD_Sound_GetUserData"));
+        s_SoundGetUserData = m_SoundGetUserData;
 
         m_ChannelIsPlaying = reinterpret_cast<FMOD::ChannelIsPlaying*>(GetProcAddress(fmod, "FMOD_Channel_IsPlaying"));
         m_ChannelStop = reinterpret_cast<FMOD::ChannelStop*>(GetProcAddress(fmod, "FMOD_Channel_Stop"));
@@ -438,47 +596,156 @@ SoundManager::SoundManager(DecodeAudioFile* decode_function)
 }
 SoundManager::~SoundManager()
 {
-    for (Sound& sound : m_SoundStorage)
+    if (m_DecodeCache->worker.joinable())
     {
-        m_ReleaseSound(sound.fmod_sound);
+        {
+            std::lock_guard lock{m_DecodeCache->lock};
+            m_DecodeCache->stop = true;
+        }
+        m_DecodeCache->queue_not_empty.notify_all();
+        m_DecodeCache->worker.join();
+    }
+
+    for (auto& [path, sound] : m_SoundStorage)
+    {
+        m_ReleaseSound(sound->fmod_sound);
+    }
+    for (auto& [fmod_sound, sound] : m_StreamStorage)
+    {
+        m_ReleaseSound(fmod_sound);
     }
 }
 
 CustomSound SoundManager::get_sound(std::string path)
 {
-    auto it = std::find_if(m_SoundStorage.begin(), m_SoundStorage.end(), [&path](const Sound& sound)
-                           { return sound.path == path; });
+    if (CustomSound sound = get_existing_sound(path))
+    {
+        return sound;
+    }
+
+    if (DecodedAudioBufferPtr buffer = decode_sound(path))
+    {
+        return create_sound(std::move(path), std::move(buffer));
+    }
+    return CustomSound{nullptr, nullptr};
+}
+CustomSound SoundManager::get_sound(const char* path)
+{
+    return get_sound(std::string{path});
+}
+CustomSound SoundManager::get_existing_sound(std::string_view path)
+{
+    auto it = m_SoundStorage.find(path);
     if (it != m_SoundStorage.end())
     {
-        it->ref_count++;
-        return CustomSound{it->fmod_sound, this};
+        it->second->ref_count++;
+        return CustomSound{it->second->fmod_sound, this};
     }
+    return CustomSound{nullptr, nullptr};
+}
+PendingSound SoundManager::get_sound_async(std::string path)
+{
+    auto state = std::make_shared<PendingSoundState>();
+    state->path = std::move(path);
 
-    DecodedAudioBuffer buffer;
-    try
     {
-        buffer = m_DecodeFunction(path.c_str());
+        std::lock_guard lock{m_DecodeCache->lock};
+        // Hold on to the buffer, the script may release the loaded sound before it calls `get`
+        if (auto it = m_SoundStorage.find(state->path); it != m_SoundStorage.end())
+        {
+            state->buffer = it->second->buffer;
+            state->done = true;
+            return PendingSound{std::move(state), this};
+        }
+        if (DecodedAudioBufferPtr buffer = m_DecodeCache->find(state->path))
+        {
+            state->buffer = std::move(buffer);
+            state->done = true;
+            return PendingSound{std::move(state), this};
+        }
+        if (auto it = m_DecodeCache->in_flight.find(state->path); it != m_DecodeCache->in_flight.end())
+        {
+            return PendingSound{it->second, this};
+        }
+
+        if (!m_DecodeCache->worker.joinable())
+        {
+            m_DecodeCache->worker = std::thread([this]()
+                                                { m_DecodeCache->run(m_DecodeFunction); });
+        }
+        m_DecodeCache->in_flight[state->path] = state;
+        m_DecodeCache->queue.push_back(state);
     }
-    catch (std::exception& except)
+    m_DecodeCache->queue_not_empty.notify_one();
+
+    return PendingSound{std::move(state), this};
+}
+SoundManager::DecodedAudioBufferPtr SoundManager::decode_sound(const std::string& path)
+{
+    std::shared_ptr<PendingSoundState> stolen_state;
     {
-        DEBUG("Failed loading audio file {}\n{}", path, except.what());
-        return CustomSound{nullptr, nullptr};
+        std::unique_lock lock{m_DecodeCache->lock};
+        if (DecodedAudioBufferPtr buffer = m_DecodeCache->find(path))
+        {
+            return buffer;
+        }
+
+        if (auto it = m_DecodeCache->in_flight.find(path); it != m_DecodeCache->in_flight.end())
+        {
+            std::shared_ptr<PendingSoundState> state = it->second;
+
+            // Still waiting behind other files, take it off the queue and decode it right here instead of waiting for the worker to get to it
+            auto& queue = m_DecodeCache->queue;
+            if (auto queued_it = std::find(queue.begin(), queue.end(), state); queued_it != queue.end())
+            {
+                queue.erase(queued_it);
+                stolen_state = std::move(state);
+            }
+            else
+            {
+                // The worker is decoding it right now, wait for that instead of decoding twice
+                m_DecodeCache->decode_done.wait(lock, [&state]()
+                                                { return state->done.load(std::memory_order_acquire); });
+                return state->buffer;
+            }
+        }
+    }
+
+    DecodedAudioBufferPtr buffer = DecodeCache::decode(m_DecodeFunction, path);
+
+    if (stolen_state != nullptr)
+    {
+        {
+            std::lock_guard lock{m_DecodeCache->lock};
+            m_DecodeCache->complete(*stolen_state, buffer);
+        }
+        m_DecodeCache->decode_done.notify_all();
+        return buffer;
     }
 
-    Sound new_sound;
-    new_sound.ref_count = 1;
-    new_sound.buffer = std::move(buffer);
-    new_sound.path = std::move(path);
+    if (buffer != nullptr)
+    {
+        std::lock_guard lock{m_DecodeCache->lock};
+        m_DecodeCache->insert(path, buffer);
+    }
+    return buffer;
+}
+CustomSound SoundManager::create_sound(std::string path, DecodedAudioBufferPtr buffer)
+{
+    auto new_sound = std::make_unique<Sound>();
+    new_sound->ref_count = 1;
+    new_sound->buffer = std::move(buffer);
+    new_sound->path = path;
 
     FMOD::FMOD_MODE mode =
         (FMOD::FMOD_MODE)(FMOD::FMOD_MODE::MODE_CREATESAMPLE | FMOD::FMOD_MODE::MODE_OPENMEMORY_POINT | FMOD::FMOD_MODE::MODE_OPENRAW | FMOD::FMOD_MODE::MODE_IGNORETAGS | FMOD::FMOD_MODE::MODE_LOOP_OFF);
 
     FMOD::CREATESOUNDEXINFO create_sound_exinfo{};
     create_sound_exinfo.cbsize = sizeof(create_sound_exinfo);
-    create_sound_exinfo.length = (std::uint32_t)new_sound.buffer.data_size - 32;
-    create_sound_exinfo.numchannels = new_sound.buffer.num_channels;
-    create_sound_exinfo.defaultfrequency = new_sound.buffer.frequency;
-    create_sound_exinfo.format = [path](SoundFormat format)
+    create_sound_exinfo.length = (std::uint32_t)new_sound->buffer->data_size - 32;
+    create_sound_exinfo.numchannels = new_sound->buffer->num_channels;
+    create_sound_exinfo.defaultfrequency = new_sound->buffer->frequency;
+    create_sound_exinfo.format = [&path](SoundFormat format)
     {
         switch (format)
         {
@@ -496,64 +763,160 @@ CustomSound SoundManager::get_sound(std::string path)
         case SoundFormat::PCM_FLOAT:
             return FMOD::SOUND_FORMAT::PCMFLOAT;
         }
-    }(new_sound.buffer.format);
+    }(new_sound->buffer->format);
 
-    auto data = (const char*)new_sound.buffer.data.get() + 16; // 16 bytes padding in front
-    FMOD::FMOD_RESULT err = m_CreateSound(m_FmodSystem, data, mode, &create_sound_exinfo, &new_sound.fmod_sound);
+    auto data = (const char*)new_sound->buffer->data.get() + 16; // 16 bytes padding in front
+    FMOD::FMOD_RESULT err = m_CreateSound(m_FmodSystem, data, mode, &create_sound_exinfo, &new_sound->fmod_sound);
     if (err != FMOD::FMOD_RESULT::OK)
     {
         return CustomSound{nullptr, nullptr};
     }
 
-    m_SoundStorage.push_back(std::move(new_sound));
-    return CustomSound{m_SoundStorage.back().fmod_sound, this};
+    FMOD::Sound* fmod_sound = new_sound->fmod_sound;
+    m_FmodSoundToSound[fmod_sound] = new_sound.get();
+    m_SoundStorage[std::move(path)] = std::move(new_sound);
+    return CustomSound{fmod_sound, this};
 }
-CustomSound SoundManager::get_sound(const char* path)
+CustomSound SoundManager::get_stream(std::string path)
 {
-    return get_sound(std::string{path});
+    auto new_sound = std::make_unique<Sound>();
+    new_sound->ref_count = 1;
+    new_sound->streamed = true;
+
+    std::unique_ptr<AudioStream> decoder = m_OpenStreamFunction != nullptr ? m_OpenStreamFunction(path.c_str()) : nullptr;
+    if (decoder != nullptr && m_SoundGetUserData != nullptr)
+    {
+        auto stream = std::make_unique<Stream>();
+        stream->decoder = std::move(decoder);
+
+        FMOD::CREATESOUNDEXINFO create_sound_exinfo{};
+        create_sound_exinfo.cbsize = sizeof(create_sound_exinfo);
+        create_sound_exinfo.length = static_cast<std::uint32_t>(stream->decoder->data_size());
+        create_sound_exinfo.numchannels = stream->decoder->num_channels();
+        create_sound_exinfo.defaultfrequency = stream->decoder->frequency();
+        create_sound_exinfo.format = [](SoundFormat format)
+        {
+            switch (format)
+            {
+            default:
+                return FMOD::SOUND_FORMAT::NONE;
+            case SoundFormat::PCM_8:
+                return FMOD::SOUND_FORMAT::PCM8;
+            case SoundFormat::PCM_16:
+                return FMOD::SOUND_FORMAT::PCM16;
+            case SoundFormat::PCM_24:
+                return FMOD::SOUND_FORMAT::PCM24;
+            case SoundFormat::PCM_32:
+                return FMOD::SOUND_FORMAT::PCM32;
+            case SoundFormat::PCM_FLOAT:
+                return FMOD::SOUND_FORMAT::PCMFLOAT;
+            }
+        }(stream->decoder->format());
+        create_sound_exinfo.pcmreadcallback = reinterpret_cast<void*>(&stream_pcm_read);
+        create_sound_exinfo.pcmsetposcallback = reinterpret_cast<void*>(&stream_pcm_set_position);
+        create_sound_exinfo.userdata = reinterpret_cast<std::intptr_t>(stream.get());
+
+        FMOD::FMOD_MODE mode = (FMOD::FMOD_MODE)(FMOD::FMOD_MODE::MODE_OPENUSER | FMOD::FMOD_MODE::MODE_CREATESTREAM | FMOD::FMOD_MODE::MODE_LOOP_OFF);
+        if (create_sound_exinfo.format != FMOD::SOUND_FORMAT::NONE &&
+            m_CreateSound(m_FmodSystem, nullptr, mode, &create_sound_exinfo, &new_sound->fmod_sound) == FMOD::FMOD_RESULT::OK)
+        {
+            new_sound->stream = std::move(stream);
+        }
+    }
+
+    if (new_sound->fmod_sound == nullptr)
+    {
+        // No chunked decoder for this format, let Fmod stream it with its own codecs
+        FMOD::FMOD_MODE mode = (FMOD::FMOD_MODE)(FMOD::FMOD_MODE::MODE_CREATESTREAM | FMOD::FMOD_MODE::MODE_IGNORETAGS | FMOD::FMOD_MODE::MODE_LOOP_OFF);
+        if (m_CreateSound(m_FmodSystem, path.c_str(), mode, nullptr, &new_sound->fmod_sound) != FMOD::FMOD_RESULT::OK)
+        {
+            DEBUG("Could not stream audio file {}, loading it in one go instead...", path);
+            return get_sound(std::move(path));
+        }
+    }
+
+    FMOD::Sound* fmod_sound = new_sound->fmod_sound;
+    m_FmodSoundToSound[fmod_sound] = new_sound.get();
+    m_StreamStorage[fmod_sound] = std::move(new_sound);
+    return CustomSound{fmod_sound, this};
 }
-CustomSound SoundManager::get_existing_sound(std::string_view path)
+FMOD::FMOD_RESULT SoundManager::stream_pcm_read(FMOD::Sound* fmod_sound, void* data, std::uint32_t data_size)
 {
-    auto it = std::find_if(m_SoundStorage.begin(), m_SoundStorage.end(), [&path](const Sound& sound)
-                           { return sound.path == path; });
-    if (it != m_SoundStorage.end())
+    Stream* stream{nullptr};
+    if (s_SoundGetUserData(fmod_sound, reinterpret_cast<void**>(&stream)) != FMOD::FMOD_RESULT::OK || stream == nullptr)
     {
-        it->ref_count++;
-        return CustomSound{it->fmod_sound, this};
+        return FMOD::FMOD_RESULT::ERR_INVALID_PARAM;
     }
-    return CustomSound{nullptr, nullptr};
+
+    // Runs on Fmods stream thread, the decoder writes straight into Fmods buffer in whatever block size it asks for
+    auto* out = static_cast<std::byte*>(data);
+    const std::size_t written = stream->decoder->read(out, data_size);
+    std::memset(out + written, 0, data_size - written);
+
+    return FMOD::FMOD_RESULT::OK;
+}
+FMOD::FMOD_RESULT SoundManager::stream_pcm_set_position(FMOD::Sound* fmod_sound, int, std::uint32_t position, FMOD::TIMEUNIT position_type)
+{
+    Stream* stream{nullptr};
+    if (s_SoundGetUserData(fmod_sound, reinterpret_cast<void**>(&stream)) != FMOD::FMOD_RESULT::OK || stream == nullptr)
+    {
+        return FMOD::FMOD_RESULT::ERR_INVALID_PARAM;
+    }
+
+    std::size_t frame{position};
+    switch (position_type)
+    {
+    case FMOD::TIMEUNIT::PCM:
+        break;
+    case FMOD::TIMEUNIT::PCMBYTES:
+        frame /= std::max<std::size_t>(stream->decoder->frame_size(), 1);
+        break;
+    case FMOD::TIMEUNIT::MS:
+        frame = static_cast<std::size_t>(static_cast<std::uint64_t>(position) * stream->decoder->frequency() / 1000);
+        break;
+    default:
+        return FMOD::FMOD_RESULT::ERR_UNSUPPORTED;
+    }
+    return stream->decoder->seek(frame) ? FMOD::FMOD_RESULT::OK : FMOD::FMOD_RESULT::ERR_INVALID_POSITION;
 }
 void SoundManager::acquire_sound(FMOD::Sound* fmod_sound)
 {
-    auto it = std::find_if(m_SoundStorage.begin(), m_SoundStorage.end(), [fmod_sound](const Sound& sound)
-                           { return sound.fmod_sound == fmod_sound; });
-    if (it == m_SoundStorage.end())
+    auto it = m_FmodSoundToSound.find(fmod_sound);
+    if (it == m_FmodSoundToSound.end())
     {
         DEBUG("Trying to acquire sound that does not exist...");
         return;
     }
 
-    it->ref_count++;
+    it->second->ref_count++;
 }
 void SoundManager::release_sound(FMOD::Sound* fmod_sound)
 {
-    auto it = std::find_if(m_SoundStorage.begin(), m_SoundStorage.end(), [fmod_sound](const Sound& sound)
-                           { return sound.fmod_sound == fmod_sound; });
-    if (it == m_SoundStorage.end())
+    auto it = m_FmodSoundToSound.find(fmod_sound);
+    if (it == m_FmodSoundToSound.end())
     {
         DEBUG("Trying to release sound that does not exist...");
         return;
     }
 
     // TODO: Really worth releasing or should we just keep this for eternity?
-    if (it->ref_count == 1)
+    Sound* sound = it->second;
+    if (sound->ref_count == 1)
     {
-        m_ReleaseSound(it->fmod_sound);
-        m_SoundStorage.erase(it);
+        m_ReleaseSound(sound->fmod_sound);
+        m_FmodSoundToSound.erase(it);
+        if (sound->streamed)
+        {
+            m_StreamStorage.erase(fmod_sound);
+        }
+        else
+        {
+            m_SoundStorage.erase(m_SoundStorage.find(sound->path));
+        }
     }
     else
     {
-        it->ref_count--;
+        sound->ref_count--;
     }
 }
 PlayingSound SoundManager::play_sound(FMOD::Sound* fmod_sound, bool paused, bool as_music)
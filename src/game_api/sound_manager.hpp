@@ -5,6 +5,7 @@
 #include <cstdint>
 #include <functional>
 #include <list>
+#include <memory>
 #include <new>
 #include <optional>
 #include <string>
@@ -22,6 +23,7 @@
 
 class SoundManager;
 class PlayingSound;
+struct PendingSoundState;
 
 using SoundCallbackFunction = std::function<void()>;
 using EventCallbackFunction = std::function<void(PlayingSound)>;
@@ -72,6 +74,29 @@ class CustomSound
     SoundManager* m_SoundManager{nullptr};
 };
 
+class PendingSound
+{
+    friend class SoundManager;
+
+  public:
+    PendingSound(const PendingSound& rhs) = default;
+    PendingSound(PendingSound&& rhs) noexcept = default;
+    PendingSound& operator=(const PendingSound& rhs) = default;
+    PendingSound& operator=(PendingSound&& rhs) noexcept = default;
+    ~PendingSound() = default;
+
+    /// Returns true once decoding has finished, successful or not
+    bool is_ready();
+    /// Returns the sound once it is ready, an empty sound if decoding failed or is still in progress
+    CustomSound get();
+
+  private:
+    PendingSound(std::shared_ptr<PendingSoundState> state, SoundManager* sound_manager);
+
+    std::shared_ptr<PendingSoundState> m_State;
+    SoundManager* m_SoundManager{nullptr};
+};
+
 using PlayingSoundHandle = std::variant<FMOD::Channel*, FMODStudio::EventInstance*, std::monostate>;
 class PlayingSound
 {
@@ -114,7 +139,7 @@ class PlayingSound
 class SoundManager
 {
   public:
-    SoundManager(DecodeAudioFile* decode_function);
+    SoundManager(DecodeAudioFile* decode_function, OpenAudioStream* open_stream_function = nullptr);
     ~SoundManager();
 
     SoundManager(const SoundManager&) = delete;
@@ -130,6 +155,10 @@ class SoundManager
     CustomSound get_sound(std::string path);
     CustomSound get_sound(const char* path);
     CustomSound get_existing_sound(std::string_view path);
+    /// Decodes the file on a worker thread, the returned handle gives access to the sound once decoding finished
+    PendingSound get_sound_async(std::string path);
+    /// Creates a sound that is decoded while playing, meant for long music tracks. Streams are never shared and can only play once at a time
+    CustomSound get_stream(std::string path);
     void acquire_sound(FMOD::Sound* fmod_sound);
     void release_sound(FMOD::Sound* fmod_sound);
     PlayingSound play_sound(FMOD::Sound* fmod_sound, bool paused, bool as_music);
@@ -178,12 +207,14 @@ class SoundManager
     bool m_IsInit{false};
 
     DecodeAudioFile* m_DecodeFunction{nullptr};
+    OpenAudioStream* m_OpenStreamFunction{nullptr};
 
     FMOD::System* m_FmodSystem{nullptr};
 
     FMOD::CreateSound* m_CreateSound{nullptr};
     FMOD::ReleaseSound* m_ReleaseSound{nullptr};
     FMOD::PlaySound* m_PlaySound{nullptr};
+    FMOD::SoundGetUserData* m_SoundGetUserData{nullptr};
 
     FMOD::ChannelIsPlaying* m_ChannelIsPlaying{nullptr};
     FMOD::ChannelStop* m_ChannelStop{nullptr};
@@ -247,9 +278,34 @@ class SoundManager
     static_assert(sizeof(EventDescription) == 0x1a0);
     SoundData m_SoundData;
 
-    struct Sound;
+    using DecodedAudioBufferPtr = std::shared_ptr<const DecodedAudioBuffer>;
+    friend class PendingSound;
+
+    DecodedAudioBufferPtr decode_sound(const std::string& path);
+    CustomSound create_sound(std::string path, DecodedAudioBufferPtr buffer);
 
-    std::vector<Sound> m_SoundStorage;
+    struct PathHash
+    {
+        using is_transparent = void;
+        std::size_t operator()(std::string_view path) const
+        {
+            return std::hash<std::string_view>{}(path);
+        }
+    };
+
+    struct Sound;
+    std::unordered_map<std::string, std::unique_ptr<Sound>, PathHash, std::equal_to<>> m_SoundStorage;
+    std::unordered_map<FMOD::Sound*, Sound*> m_FmodSoundToSound;
+    std::unordered_map<FMOD::Sound*, std::unique_ptr<Sound>> m_StreamStorage;
+
+    struct Stream;
+    static FMOD::FMOD_RESULT stream_pcm_read(FMOD::Sound* fmod_sound, void* data, std::uint32_t data_size);
+    static FMOD::FMOD_RESULT stream_pcm_set_position(FMOD::Sound* fmod_sound, int sub_sound, std::uint32_t position, FMOD::TIMEUNIT position_type);
+    static inline FMOD::SoundGetUserData* s_SoundGetUserData{nullptr};
+
+    // Decoded PCM stays around after its sound was released, so reloading a script doesn't decode everything again
+    struct DecodeCache;
+    std::unique_ptr<DecodeCache> m_DecodeCache;
 };
 
 struct SoundInfo
@@ -4,7 +4,6 @@
 #include <array>       // for array
 #include <cmath>       // for roundf, INFINITY
 #include <cstddef>     // for size_t
-#include <detours.h>   // for DetourAttach, DetourTransactionBegin
 #include <functional>  // for function, _Func_impl_no_alloc<>::_M...
 #include <new>         // for operator new
 #include <optional>    // for optional
@@ -12,23 +11,25 @@
 #include <utility>     // for pair, identity, min, _Find_fn, find
 #include <vector>      // for vector, allocator, _Vector_iterator
 
-#include "entities_chars.hpp"    // for Player
-#include "entities_items.hpp"    // for ClimbableRope
-#include "entities_liquids.hpp"  // for Lava
-#include "entities_monsters.hpp" // for Shopkeeper, RoomOwner
-#include "entity.hpp"            // for to_id, Entity, get_entity_ptr, Enti...
-#include "items.hpp"             //
-#include "layer.hpp"             // for Layer, g_level_max_y, g_level_max_x
-#include "level_api.hpp"         // for LevelGenSystem, ThemeInfo
-#include "logger.h"              // for DEBUG
-#include "math.hpp"              // for AABB
-#include "memory.hpp"            // for write_mem_prot, memory_read
-#include "prng.hpp"              // for PRNG, PRNG::PRNG_CLASS, PRNG::ENTIT...
-#include "script/events.hpp"     // for post_entity_spawn, pre_entity_spawn
-#include "search.hpp"            // for get_address
-#include "state.hpp"             // for enum_to_layer, State, StateMemory
-#include "state_structs.hpp"     // for LiquidTileSpawnData, LiquidPhysics
-#include "util.hpp"              // for OnScopeExit
+#include "entities_chars.hpp"     // for Player
+#include "entities_items.hpp"     // for ClimbableRope
+#include "entities_liquids.hpp"   // for Lava
+#include "entities_monsters.hpp"  // for Shopkeeper, RoomOwner
+#include "entity.hpp"             // for to_id, Entity, get_entity_ptr, Enti...
+#include "entity_change_feed.hpp" // for record_entity_spawn
+#include "hook_registry.hpp"      // for attach_hook
+#include "items.hpp"              //
+#include "layer.hpp"              // for Layer, g_level_max_y, g_level_max_x
+#include "level_api.hpp"          // for LevelGenSystem, ThemeInfo
+#include "logger.h"               // for DEBUG
+#include "math.hpp"               // for AABB
+#include "memory.hpp"             // for write_mem_prot, memory_read
+#include "prng.hpp"               // for PRNG, PRNG::PRNG_CLASS, PRNG::ENTIT...
+#include "script/events.hpp"      // for post_entity_spawn, pre_entity_spawn
+#include "search.hpp"             // for get_address
+#include "state.hpp"              // for enum_to_layer, State, StateMemory
+#include "state_structs.hpp"      // for LiquidTileSpawnData, LiquidPhysics
+#include "util.hpp"               // for OnScopeExit
 
 struct Items;
 
@@ -631,6 +632,7 @@ Entity* spawn_entity(EntityFactory* entity_factory, std::uint32_t entity_type, f
     }
 
     post_entity_spawn(spawned_ent, g_SpawnTypeFlags);
+    record_entity_spawn(spawned_ent);
     if (g_temp_entity_spawn_hook)
     {
         g_temp_entity_spawn_hook(spawned_ent);
@@ -646,20 +648,8 @@ Entity* spawn_entity(EntityFactory* entity_factory, std::uint32_t entity_type, f
 
 void init_spawn_hooks()
 {
-    {
-        DetourTransactionBegin();
-        DetourUpdateThread(GetCurrentThread());
-
-        g_spawn_entity_trampoline = (SpawnEntityFun*)get_address("spawn_entity");
-
-        DetourAttach((void**)&g_spawn_entity_trampoline, (SpawnEntityFun*)spawn_entity);
-
-        const LONG error = DetourTransactionCommit();
-        if (error != NO_ERROR)
-        {
-            DEBUG("Failed hooking SpawnEntity: {}\n", error);
-        }
-    }
+    g_spawn_entity_trampoline = (SpawnEntityFun*)get_address("spawn_entity");
+    attach_hook("spawn_entity", (void**)&g_spawn_entity_trampoline, (SpawnEntityFun*)spawn_entity);
 }
 
 void spawn_player(int8_t player_slot, float x, float y)
@@ -1,18 +1,21 @@
 #include "state.hpp"
 
 #include <Windows.h>   // for GetCurrentThread, LONG, NO_ERROR
+#include <algorithm>   // for min
+#include <array>       // for array
 #include <cmath>       // for abs
 #include <cstdlib>     // for size_t, abs
-#include <detours.h>   // for DetourAttach, DetourTransactionBegin
 #include <functional>  // for _Func_class, function
 #include <new>         // for operator new
 #include <string>      // for allocator, operator""sv, operator""s
 #include <type_traits> // for move
+#include <xmmintrin.h> // for _mm_prefetch
 
 #include "entities_chars.hpp"    // for Player
 #include "entity.hpp"            // for to_id, Entity, HookWithId, EntityDB
 #include "entity_hooks_info.hpp" // for Player
 #include "game_manager.hpp"      // for get_game_manager, GameManager, SaveR...
+#include "hook_registry.hpp"     // for attach_hook, HookTransaction
 #include "items.hpp"             // for Items, SelectPlayerSlot
 #include "level_api.hpp"         // for LevelGenSystem, LevelGenSystem::(ano...
 #include "logger.h"              // for DEBUG
@@ -183,17 +186,8 @@ void hook_godmode_functions()
         g_on_damage_trampoline = (OnDamageFun*)addr_damage;
         g_on_instagib_trampoline = (OnInstaGibFun*)addr_insta;
 
-        DetourTransactionBegin();
-        DetourUpdateThread(GetCurrentThread());
-
-        DetourAttach((void**)&g_on_damage_trampoline, &on_damage);
-        DetourAttach((void**)&g_on_instagib_trampoline, &on_instagib);
-
-        const LONG error = DetourTransactionCommit();
-        if (error != NO_ERROR)
-        {
-            DEBUG("Failed hooking on_damage/instagib: {}\n", error);
-        }
+        attach_hook("on_damage", (void**)&g_on_damage_trampoline, &on_damage);
+        attach_hook("insta_gib", (void**)&g_on_instagib_trampoline, &on_instagib);
 
         functions_hooked = true;
     }
@@ -226,6 +220,8 @@ State& State::get()
         const bool do_hooks = get_do_hooks();
         if (do_hooks)
         {
+            // Attach all startup hooks in one go, instead of suspending threads for every module
+            HookTransaction hooks;
             STATE.ptr_main()->level_gen->init();
             init_spawn_hooks();
             init_behavior_hooks();
@@ -489,40 +485,105 @@ uint32_t lowbias32_r(uint32_t x)
     x ^= x >> 16;
     return x;
 }
-Entity* find(StateMemory* state, uint32_t uid)
+// Remembers where in uid_to_entity_data a uid was last found, direct-mapped by the low bits of the uid since uids are handed out in sequence.
+// A hit is checked against the hashed uid stored in that slot, which also catches destroyed, moved and rehashed entries, so nothing has to invalidate it.
+struct UidLookupMemoEntry
 {
-    // Ported from MauveAlert's python code in the CAT tracker
+    const RobinHoodTableEntry* data{nullptr};
+    uint32_t mask{0};
+    uint32_t uid{0};
+    uint32_t uid_plus_one{0};
+    uint32_t index{0};
+};
+struct UidLookupMemo
+{
+    std::array<UidLookupMemoEntry, 256> entries{};
+    UidLookupStats stats;
+};
+thread_local UidLookupMemo g_uid_lookup_memo;
 
-    // -1 (0xFFFFFFFF) is used as a null-like value for uids.
-    if (uid == ~0)
-    {
-        return nullptr;
-    }
+// Returns the index of `target_uid_plus_one` in uid_to_entity_data, or ~0 if it is not in there
+uint32_t find_uid_index(StateMemory* state, uint32_t target_uid_plus_one)
+{
+    // Ported from MauveAlert's python code in the CAT tracker
 
     const uint32_t mask = state->uid_to_entity_mask;
-    const uint32_t target_uid_plus_one = lowbias32(uid + 1);
     uint32_t cur_index = target_uid_plus_one & mask;
     while (true)
     {
         auto entry = state->uid_to_entity_data[cur_index];
         if (entry.uid_plus_one == target_uid_plus_one)
         {
-            return entry.entity;
+            return cur_index;
         }
 
         if (entry.uid_plus_one == 0)
         {
-            return nullptr;
+            return ~0u;
         }
 
         if (((cur_index - target_uid_plus_one) & mask) > ((cur_index - entry.uid_plus_one) & mask))
         {
-            return nullptr;
+            return ~0u;
         }
 
         cur_index = (cur_index + (uint32_t)1) & mask;
     }
 }
+Entity* find_and_remember(StateMemory* state, uint32_t uid, uint32_t target_uid_plus_one)
+{
+    const uint32_t index = find_uid_index(state, target_uid_plus_one);
+    if (index == ~0u)
+    {
+        return nullptr;
+    }
+    g_uid_lookup_memo.entries[uid & 0xff] = UidLookupMemoEntry{state->uid_to_entity_data, state->uid_to_entity_mask, uid, target_uid_plus_one, index};
+    return state->uid_to_entity_data[index].entity;
+}
+Entity* find(StateMemory* state, uint32_t uid)
+{
+    // -1 (0xFFFFFFFF) is used as a null-like value for uids.
+    if (uid == ~0)
+    {
+        return nullptr;
+    }
+
+    const UidLookupMemoEntry& memo = g_uid_lookup_memo.entries[uid & 0xff];
+    if (memo.uid == uid && memo.data == state->uid_to_entity_data && memo.mask == state->uid_to_entity_mask)
+    {
+        const RobinHoodTableEntry& entry = state->uid_to_entity_data[memo.index];
+        if (entry.uid_plus_one == memo.uid_plus_one)
+        {
+            g_uid_lookup_memo.stats.memo_hits++;
+            return entry.entity;
+        }
+    }
+    g_uid_lookup_memo.stats.memo_misses++;
+
+    return find_and_remember(state, uid, lowbias32(uid + 1));
+}
+void find_many(StateMemory* state, std::span<const uint32_t> uids, std::span<Entity*> entities)
+{
+    // Hash a block of uids and prefetch their home slots before probing any of them, so the cache misses overlap
+    constexpr size_t block_size = 16;
+    std::array<uint32_t, block_size> hashes;
+    const uint32_t mask = state->uid_to_entity_mask;
+    for (size_t block_start = 0; block_start < uids.size(); block_start += block_size)
+    {
+        const size_t count = std::min(block_size, uids.size() - block_start);
+        for (size_t i = 0; i < count; ++i)
+        {
+            hashes[i] = lowbias32(uids[block_start + i] + 1);
+            _mm_prefetch(reinterpret_cast<const char*>(&state->uid_to_entity_data[hashes[i] & mask]), _MM_HINT_T0);
+        }
+        for (size_t i = 0; i < count; ++i)
+        {
+            const uint32_t uid = uids[block_start + i];
+            const uint32_t index = uid == ~0 ? ~0u : find_uid_index(state, hashes[i]);
+            entities[block_start + i] = index == ~0u ? nullptr : state->uid_to_entity_data[index].entity;
+        }
+    }
+}
 Entity* State::find(uint32_t uid)
 {
     return ::find(ptr(), uid);
@@ -531,6 +592,15 @@ Entity* State::find_local(uint32_t uid)
 {
     return ::find(ptr_local(), uid);
 }
+void State::find_many(std::span<const uint32_t> uids, std::span<Entity*> entities)
+{
+    ::find_many(ptr(), uids, entities);
+}
+
+UidLookupStats get_uid_lookup_stats()
+{
+    return g_uid_lookup_memo.stats;
+}
 
 LiquidPhysicsEngine* State::get_correct_liquid_engine(ENT_TYPE liquid_type)
 {
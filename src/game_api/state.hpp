@@ -3,6 +3,7 @@
 #include <array>   // for array
 #include <cstddef> // for size_t
 #include <cstdint> // for uint8_t, uint32_t, int32_t, int8_t, uin...
+#include <span>    // for span
 #include <utility> // for pair
 #include <vector>  // for vector
 
@@ -293,6 +294,8 @@ struct State
 
     Entity* find(uint32_t uid);
     Entity* find_local(uint32_t uid);
+    /// Looks up all `uids` at once, writing the results to `entities` which must be at least as large
+    void find_many(std::span<const uint32_t> uids, std::span<Entity*> entities);
 
     static std::pair<float, float> get_camera_position();
     void set_camera_position(float cx, float cy);
@@ -307,3 +310,11 @@ uint8_t enum_to_layer(const LAYER layer);
 
 uint32_t lowbias32(uint32_t x);
 uint32_t lowbias32_r(uint32_t x);
+
+struct UidLookupStats
+{
+    uint64_t memo_hits{0};
+    uint64_t memo_misses{0};
+};
+/// Stats of the uid lookup memo of the calling thread
+UidLookupStats get_uid_lookup_stats();
@@ -1,8 +1,8 @@
 #include "steam_api.hpp"
 
 #include <array>     // for array, _Array_const_iterator
-#include <detours.h> // for DetourAttach, DetourTransactionBegin
 
+#include "hook_registry.hpp" // for attach_hook
 #include "memory.hpp" // for vtable_find
 #include "script/events.hpp"
 #include "search.hpp" // for get_address
@@ -142,17 +142,8 @@ void init_achievement_hooks()
         g_get_feat_trampoline = (GetFeatFun*)get_address("get_feat"sv);
         g_set_feat_trampoline = (SetFeatFun*)get_address("set_feat"sv);
 
-        DetourTransactionBegin();
-        DetourUpdateThread(GetCurrentThread());
-
-        DetourAttach((void**)&g_get_feat_trampoline, &feat_unlocked);
-        DetourAttach((void**)&g_set_feat_trampoline, &unlock_feat);
-
-        const LONG error = DetourTransactionCommit();
-        if (error != NO_ERROR)
-        {
-            DEBUG("Failed hooking feats: {}\n", error);
-        }
+        attach_hook("get_feat", (void**)&g_get_feat_trampoline, &feat_unlocked);
+        attach_hook("set_feat", (void**)&g_set_feat_trampoline, &unlock_feat);
 
         hooked = true;
     }
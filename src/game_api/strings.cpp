@@ -13,8 +13,8 @@
 #include <utility>       // for max, min, pair
 
 #include "containers/game_allocator.hpp" // for game_free, game_malloc
-#include "detours.h"                     // for DetourAttach, DetourTransac...
 #include "entity.hpp"                    // for get_type, Entity, EntityDB
+#include "hook_registry.hpp"             // for attach_hook
 #include "logger.h"                      // for DEBUG
 #include "memory.hpp"                    // for Memory
 #include "script/events.hpp"             // for pre_speach_bubble, pre_toast
@@ -109,18 +109,9 @@ void strings_init()
     g_speach_bubble_trampoline = (OnNPCDialogueFun*)addr_npcdialogue;
     g_toast_trampoline = (OnToastFun*)addr_toastfun;
 
-    DetourTransactionBegin();
-    DetourUpdateThread(GetCurrentThread());
-
-    DetourAttach((void**)&g_on_shopnameformat_trampoline, &on_shopitemnameformat);
-    DetourAttach((void**)&g_speach_bubble_trampoline, &OnNPCDialogue);
-    DetourAttach((void**)&g_toast_trampoline, &OnToast);
-
-    const LONG error = DetourTransactionCommit();
-    if (error != NO_ERROR)
-    {
-        DEBUG("Failed hooking strings stuff: {}\n", error);
-    }
+    attach_hook("shop_item_name_format", (void**)&g_on_shopnameformat_trampoline, &on_shopitemnameformat);
+    attach_hook("speech_bubble", (void**)&g_speach_bubble_trampoline, &OnNPCDialogue);
+    attach_hook("toast", (void**)&g_toast_trampoline, &OnToast);
 }
 
 const char16_t** get_strings_table()
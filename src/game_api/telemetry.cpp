@@ -0,0 +1,141 @@
+#include "telemetry.hpp"
+
+#include <Windows.h> // for CreateFileMappingW, MapViewOfFile, UnmapViewOfFile, CloseHandle, ...
+#include <algorithm> // for min, copy_n
+#include <vector>    // for vector
+
+#include "entities_chars.hpp" // for Player
+#include "entity_db.hpp"      // for EntityDB
+#include "items.hpp"          // for Items, Inventory
+#include "layer.hpp"          // for Layer, EntityList
+#include "logger.h"           // for DEBUG
+#include "state.hpp"          // for State, StateMemory
+
+namespace
+{
+struct TelemetryWriter
+{
+    HANDLE mapping{nullptr};
+    TelemetrySegment* segment{nullptr};
+    bool has_published{false};
+    uint32_t last_frame{0};
+    TelemetryStats stats;
+};
+TelemetryWriter g_telemetry;
+
+bool open_telemetry()
+{
+    g_telemetry.mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(TelemetrySegment), g_telemetry_mapping_name);
+    if (g_telemetry.mapping == nullptr)
+    {
+        DEBUG("Could not create telemetry mapping: {:#x}", GetLastError());
+        return false;
+    }
+    g_telemetry.segment = static_cast<TelemetrySegment*>(MapViewOfFile(g_telemetry.mapping, FILE_MAP_WRITE, 0, 0, sizeof(TelemetrySegment)));
+    if (g_telemetry.segment == nullptr)
+    {
+        DEBUG("Could not map telemetry mapping: {:#x}", GetLastError());
+        CloseHandle(g_telemetry.mapping);
+        g_telemetry.mapping = nullptr;
+        return false;
+    }
+
+    // The mapping may already exist if we were reinjected, keep counting from where it was so readers don't see the sequence go back
+    TelemetrySegment& segment = *g_telemetry.segment;
+    segment.magic = g_telemetry_magic;
+    segment.version = g_telemetry_version;
+    segment.data_size = sizeof(TelemetryData);
+    segment.sequence.store(segment.sequence.load(std::memory_order_relaxed) & ~1u, std::memory_order_release);
+    g_telemetry.stats.open = true;
+    return true;
+}
+
+void gather_player(TelemetryPlayer& out, Player* player)
+{
+    out = TelemetryPlayer{.uid = -1, .holding_uid = -1};
+    if (player == nullptr)
+    {
+        return;
+    }
+
+    const auto [x, y] = player->position();
+    out.uid = player->uid;
+    out.type = player->type->id;
+    out.x = x;
+    out.y = y;
+    out.layer = player->layer;
+    out.health = player->health;
+    if (player->inventory_ptr != nullptr)
+    {
+        out.bombs = player->inventory_ptr->bombs;
+        out.ropes = player->inventory_ptr->ropes;
+    }
+    out.holding_uid = player->holding_uid;
+}
+} // namespace
+
+void publish_telemetry()
+{
+    auto state = State::get();
+    StateMemory* state_ptr = state.ptr();
+    if (state_ptr == nullptr)
+    {
+        return;
+    }
+
+    // Called once per rendered frame, only publish when the game actually advanced
+    const uint32_t frame = state.get_frame_count();
+    if (g_telemetry.has_published && frame == g_telemetry.last_frame)
+    {
+        return;
+    }
+    if (g_telemetry.segment == nullptr && !open_telemetry())
+    {
+        return;
+    }
+
+    // Gather everything first so the segment is only in the odd state for a single copy
+    TelemetryData data{};
+    data.frame = frame;
+    data.screen = state_ptr->screen;
+    data.world = state_ptr->world;
+    data.level = state_ptr->level;
+    data.theme = state_ptr->theme;
+    data.level_count = state_ptr->level_count;
+    data.time_level = state_ptr->time_level;
+    data.time_total = state_ptr->time_total;
+    data.time_last_level = state_ptr->time_last_level;
+    data.seed = state_ptr->seed;
+    data.player_count = state_ptr->items->player_count;
+    for (uint8_t i = 0; i < 4; ++i)
+    {
+        gather_player(data.players[i], state_ptr->items->player(i));
+    }
+    const std::vector<int64_t> prng = state.read_prng();
+    std::copy_n(prng.begin(), std::min<size_t>(prng.size(), 20), data.prng);
+    data.entity_count[0] = state.layer(0)->all_entities.size;
+    data.entity_count[1] = state.layer(1)->all_entities.size;
+
+    telemetry_write(*g_telemetry.segment, data);
+    g_telemetry.has_published = true;
+    g_telemetry.last_frame = frame;
+    g_telemetry.stats.published_frames++;
+}
+
+void close_telemetry()
+{
+    if (g_telemetry.segment != nullptr)
+    {
+        UnmapViewOfFile(g_telemetry.segment);
+        CloseHandle(g_telemetry.mapping);
+        g_telemetry.segment = nullptr;
+        g_telemetry.mapping = nullptr;
+    }
+    g_telemetry.has_published = false;
+    g_telemetry.stats.open = false;
+}
+
+TelemetryStats get_telemetry_stats()
+{
+    return g_telemetry.stats;
+}
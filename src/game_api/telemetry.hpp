@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm> // for min
+#include <atomic>    // for atomic, atomic_thread_fence, memory_order_...
+#include <cstddef>   // for size_t, offsetof
+#include <cstdint>   // for uint32_t, int32_t, uint8_t, int64_t, uint64_t
+#include <cstring>   // for memcpy, memset
+
+// Layout of the shared memory segment Overlunky publishes every frame for external trackers and overlays.
+// This header only depends on the standard library so readers can include it as is, the segment is named `g_telemetry_mapping_name`.
+// Fields are only ever appended to TelemetryData, `version` changes whenever existing fields change meaning.
+
+inline constexpr const wchar_t* g_telemetry_mapping_name{L"Local\\OverlunkyTelemetry"};
+inline constexpr uint32_t g_telemetry_magic{0x4d544c4f}; // "OLTM"
+inline constexpr uint32_t g_telemetry_version{1};
+
+struct TelemetryPlayer
+{
+    /// -1 if there is no player in this slot
+    int32_t uid;
+    uint32_t type;
+    float x;
+    float y;
+    uint8_t layer;
+    uint8_t health;
+    uint8_t bombs;
+    uint8_t ropes;
+    int32_t holding_uid;
+};
+
+struct TelemetryData
+{
+    /// Same as `get_frame`, changes every game frame
+    uint32_t frame;
+    uint32_t screen;
+    uint8_t world;
+    uint8_t level;
+    uint8_t theme;
+    uint8_t level_count;
+    uint32_t time_level;
+    uint32_t time_total;
+    uint32_t time_last_level;
+    uint32_t seed;
+    uint8_t player_count;
+    uint8_t padding[3];
+    TelemetryPlayer players[4];
+    /// All 10 prng pairs, as returned by `read_prng`
+    int64_t prng[20];
+    /// Size of `all_entities` of the front and back layer
+    uint32_t entity_count[2];
+};
+
+struct TelemetrySegment
+{
+    uint32_t magic;
+    uint32_t version;
+    /// sizeof(TelemetryData) of the writer, readers should not read past it
+    uint32_t data_size;
+    /// Odd while the writer is updating `data`, incremented by 2 for every published frame
+    std::atomic<uint32_t> sequence;
+    TelemetryData data;
+};
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+static_assert(offsetof(TelemetrySegment, data) == 16);
+
+// Seqlock writer, there must only ever be one writer per segment
+inline void telemetry_write(TelemetrySegment& segment, const TelemetryData& data)
+{
+    const uint32_t sequence = segment.sequence.load(std::memory_order_relaxed);
+    segment.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&segment.data, &data, sizeof(TelemetryData));
+    segment.sequence.store(sequence + 2, std::memory_order_release);
+}
+enum class TelemetryReadResult
+{
+    Ok,
+    /// The writer was updating the segment, just try again
+    Busy,
+    /// The segment was not set up yet or was written by an incompatible version, trying again only helps in the first case
+    Incompatible,
+};
+// Seqlock reader, fields that an older writer does not know about yet are zeroed
+inline TelemetryReadResult telemetry_try_read(const TelemetrySegment& segment, TelemetryData& data)
+{
+    const uint32_t sequence_before = segment.sequence.load(std::memory_order_acquire);
+    if (segment.magic != g_telemetry_magic || segment.version != g_telemetry_version)
+    {
+        return TelemetryReadResult::Incompatible;
+    }
+    if (sequence_before & 1)
+    {
+        return TelemetryReadResult::Busy;
+    }
+    const size_t data_size = std::min<size_t>(segment.data_size, sizeof(TelemetryData));
+    std::memcpy(&data, &segment.data, data_size);
+    std::memset(reinterpret_cast<char*>(&data) + data_size, 0, sizeof(TelemetryData) - data_size);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return segment.sequence.load(std::memory_order_relaxed) == sequence_before ? TelemetryReadResult::Ok : TelemetryReadResult::Busy;
+}
+
+struct TelemetryStats
+{
+    bool open{false};
+    uint64_t published_frames{0};
+};
+
+/// Copies the current game state into the shared memory segment, creating it on the first call
+void publish_telemetry();
+/// Unmaps the segment, readers see it disappear once they close their handles as well
+void close_telemetry();
+TelemetryStats get_telemetry_stats();
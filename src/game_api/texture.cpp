@@ -13,6 +13,7 @@
 #include "memory.hpp"
 #include "render_api.hpp"
 #include "search.hpp"
+#include "texture_compression.hpp"
 
 Textures* get_textures()
 {
@@ -58,7 +59,7 @@ Texture* get_texture(TEXTURE texture_id)
     return nullptr;
 }
 
-TEXTURE define_texture(TextureDefinition data)
+TEXTURE define_texture(TextureDefinition data, const void* owner)
 {
     auto& render = RenderAPI::get();
 
@@ -67,6 +68,12 @@ TEXTURE define_texture(TextureDefinition data)
         return existing.value();
     }
 
+    // The compression is remembered per image, a definition that doesn't ask for one must not undo what another definition of the same image picked
+    if (data.compression != TEXTURE_COMPRESSION::DEFAULT)
+    {
+        set_texture_compression(data.texture_path, data.compression, owner);
+    }
+
     if (data.sub_image_width == 0 || data.sub_image_height == 0)
     {
         data.sub_image_width = data.width;
@@ -33,6 +33,15 @@ struct Textures
     std::array<Texture*, 0x192> texture_map;
 };
 
+enum class TEXTURE_COMPRESSION : uint8_t
+{
+    DEFAULT,
+    NONE,
+    BC1,
+    BC3,
+    BC7,
+};
+
 struct TextureDefinition
 {
     std::string texture_path;
@@ -44,12 +53,13 @@ struct TextureDefinition
     uint32_t sub_image_offset_y{0};
     uint32_t sub_image_width{0};
     uint32_t sub_image_height{0};
+    TEXTURE_COMPRESSION compression{TEXTURE_COMPRESSION::DEFAULT};
 };
 
 Textures* get_textures();
 TextureDefinition get_texture_definition(TEXTURE texture_id);
 Texture* get_texture(TEXTURE texture_id);
-TEXTURE define_texture(TextureDefinition data);
+TEXTURE define_texture(TextureDefinition data, const void* owner = nullptr);
 std::optional<TEXTURE> get_texture(TextureDefinition data);
 std::optional<TEXTURE> get_texture(std::string_view texture_name);
 void reload_texture(const char* texture_name);  // Does a lookup for the right texture to reload
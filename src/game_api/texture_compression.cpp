@@ -0,0 +1,413 @@
+#include "texture_compression.hpp"
+
+#include <algorithm>     // for swap, clamp
+#include <array>         // for array
+#include <climits>       // for INT_MAX
+#include <cstdlib>       // for abs
+#include <cstring>       // for memcpy
+#include <emmintrin.h>   // for _mm_loadu_si128, _mm_min_epu8, _mm_max_epu8, ...
+#include <mutex>         // for mutex, lock_guard
+#include <string>        // for string
+#include <unordered_map> // for unordered_map, erase_if
+
+namespace
+{
+std::mutex g_texture_compression_lock;
+TEXTURE_COMPRESSION g_default_texture_compression{TEXTURE_COMPRESSION::NONE};
+struct RequestedCompression
+{
+    TEXTURE_COMPRESSION compression;
+    const void* owner;
+};
+std::unordered_map<std::string, RequestedCompression> g_texture_compressions;
+
+// A 4x4 block of RGBA8 pixels, row by row
+using PixelBlock = std::array<uint8_t, 64>;
+
+void load_block(const uint8_t* rgba, uint32_t width, uint32_t block_x, uint32_t block_y, PixelBlock& block)
+{
+    const uint8_t* src = rgba + (static_cast<size_t>(block_y) * 4 * width + static_cast<size_t>(block_x) * 4) * 4;
+    for (size_t row = 0; row < 4; ++row)
+    {
+        memcpy(block.data() + row * 16, src + row * width * 4, 16);
+    }
+}
+
+void block_bounds(const PixelBlock& block, uint8_t (&lo)[4], uint8_t (&hi)[4])
+{
+    const __m128i row0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.data()));
+    const __m128i row1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.data() + 16));
+    const __m128i row2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.data() + 32));
+    const __m128i row3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block.data() + 48));
+
+    __m128i min = _mm_min_epu8(_mm_min_epu8(row0, row1), _mm_min_epu8(row2, row3));
+    __m128i max = _mm_max_epu8(_mm_max_epu8(row0, row1), _mm_max_epu8(row2, row3));
+    min = _mm_min_epu8(min, _mm_shuffle_epi32(min, _MM_SHUFFLE(2, 3, 0, 1)));
+    max = _mm_max_epu8(max, _mm_shuffle_epi32(max, _MM_SHUFFLE(2, 3, 0, 1)));
+    min = _mm_min_epu8(min, _mm_shuffle_epi32(min, _MM_SHUFFLE(1, 0, 3, 2)));
+    max = _mm_max_epu8(max, _mm_shuffle_epi32(max, _MM_SHUFFLE(1, 0, 3, 2)));
+
+    const uint32_t packed_min = static_cast<uint32_t>(_mm_cvtsi128_si32(min));
+    const uint32_t packed_max = static_cast<uint32_t>(_mm_cvtsi128_si32(max));
+    memcpy(lo, &packed_min, 4);
+    memcpy(hi, &packed_max, 4);
+}
+
+// Picks the bounding box diagonal that follows the gradient of the block, by flipping channels that are anti-correlated with the channel of largest extent,
+// then insets both endpoints by 1/16th of the range to reduce the error of the interpolated colors
+void select_endpoints(const PixelBlock& block, size_t channels, const uint8_t (&lo)[4], const uint8_t (&hi)[4], int (&e0)[4], int (&e1)[4])
+{
+    size_t dominant = 0;
+    for (size_t c = 1; c < channels; ++c)
+    {
+        if (hi[c] - lo[c] > hi[dominant] - lo[dominant])
+            dominant = c;
+    }
+
+    int center[4];
+    for (size_t c = 0; c < 4; ++c)
+    {
+        center[c] = (lo[c] + hi[c] + 1) / 2;
+        e0[c] = lo[c];
+        e1[c] = hi[c];
+    }
+
+    for (size_t c = 0; c < channels; ++c)
+    {
+        if (c == dominant)
+            continue;
+
+        int covariance = 0;
+        for (size_t i = 0; i < 16; ++i)
+        {
+            covariance += (block[i * 4 + dominant] - center[dominant]) * (block[i * 4 + c] - center[c]);
+        }
+        if (covariance < 0)
+            std::swap(e0[c], e1[c]);
+    }
+
+    for (size_t c = 0; c < channels; ++c)
+    {
+        const int inset = (e1[c] - e0[c]) / 16;
+        e0[c] += inset;
+        e1[c] -= inset;
+    }
+}
+
+uint16_t to_rgb565(const int (&color)[4])
+{
+    return static_cast<uint16_t>(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3));
+}
+void from_rgb565(uint16_t color, int (&out)[4])
+{
+    const int r = (color >> 11) & 0x1f;
+    const int g = (color >> 5) & 0x3f;
+    const int b = color & 0x1f;
+    out[0] = (r << 3) | (r >> 2);
+    out[1] = (g << 2) | (g >> 4);
+    out[2] = (b << 3) | (b >> 2);
+    out[3] = 255;
+}
+
+void encode_color_block(const PixelBlock& block, const uint8_t (&lo)[4], const uint8_t (&hi)[4], bool allow_transparent, uint8_t* out)
+{
+    const bool has_transparent = allow_transparent && lo[3] < 128;
+
+    int e0[4];
+    int e1[4];
+    select_endpoints(block, 3, lo, hi, e0, e1);
+
+    uint16_t c0 = to_rgb565(e1);
+    uint16_t c1 = to_rgb565(e0);
+    // Four color mode is selected by c0 > c1, three color mode with a transparent index by c0 <= c1
+    if ((c0 < c1) != has_transparent)
+        std::swap(c0, c1);
+
+    int palette[4][4];
+    from_rgb565(c0, palette[0]);
+    from_rgb565(c1, palette[1]);
+    for (size_t c = 0; c < 3; ++c)
+    {
+        if (has_transparent)
+        {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+        else
+        {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+    }
+    const uint32_t num_colors = has_transparent ? 3 : 4;
+
+    uint32_t indices = 0;
+    for (uint32_t i = 0; i < 16; ++i)
+    {
+        const uint8_t* pixel = block.data() + i * 4;
+        uint32_t best_index = 3;
+        if (!has_transparent || pixel[3] >= 128)
+        {
+            int best_error = INT_MAX;
+            for (uint32_t j = 0; j < num_colors; ++j)
+            {
+                const int dr = pixel[0] - palette[j][0];
+                const int dg = pixel[1] - palette[j][1];
+                const int db = pixel[2] - palette[j][2];
+                const int error = dr * dr + dg * dg + db * db;
+                if (error < best_error)
+                {
+                    best_error = error;
+                    best_index = j;
+                }
+            }
+        }
+        indices |= best_index << (i * 2);
+    }
+
+    memcpy(out, &c0, 2);
+    memcpy(out + 2, &c1, 2);
+    memcpy(out + 4, &indices, 4);
+}
+
+void encode_alpha_block(const PixelBlock& block, uint8_t min_alpha, uint8_t max_alpha, uint8_t* out)
+{
+    out[0] = max_alpha;
+    out[1] = min_alpha;
+
+    uint64_t indices = 0;
+    if (max_alpha != min_alpha)
+    {
+        // With a0 > a1 the palette is a0, a1 and six interpolated values from a0 towards a1
+        int palette[8]{max_alpha, min_alpha};
+        for (int j = 1; j < 7; ++j)
+        {
+            palette[j + 1] = ((7 - j) * max_alpha + j * min_alpha) / 7;
+        }
+
+        for (uint32_t i = 0; i < 16; ++i)
+        {
+            const int alpha = block[i * 4 + 3];
+            uint64_t best_index = 0;
+            int best_error = INT_MAX;
+            for (uint64_t j = 0; j < 8; ++j)
+            {
+                const int error = std::abs(alpha - palette[j]);
+                if (error < best_error)
+                {
+                    best_error = error;
+                    best_index = j;
+                }
+            }
+            indices |= best_index << (i * 3);
+        }
+    }
+
+    memcpy(out + 2, &indices, 6);
+}
+
+struct Bc7Writer
+{
+    uint64_t bits[2]{};
+    uint32_t offset{0};
+
+    void write(uint32_t value, uint32_t count)
+    {
+        for (uint32_t i = 0; i < count; ++i, ++offset)
+        {
+            bits[offset / 64] |= static_cast<uint64_t>((value >> i) & 1) << (offset % 64);
+        }
+    }
+};
+
+void encode_bc7_block(const PixelBlock& block, const uint8_t (&lo)[4], const uint8_t (&hi)[4], uint8_t* out)
+{
+    // Mode 6 only: a single subset with 7.7.7.7 endpoints, one p-bit per endpoint and 4-bit indices
+    static constexpr int c_Weights[16]{0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+    int endpoints[2][4];
+    select_endpoints(block, 4, lo, hi, endpoints[0], endpoints[1]);
+
+    int quantized[2][4];
+    int p_bits[2];
+    for (size_t e = 0; e < 2; ++e)
+    {
+        int best_error = INT_MAX;
+        for (int p = 0; p < 2; ++p)
+        {
+            int error = 0;
+            int candidate[4];
+            for (size_t c = 0; c < 4; ++c)
+            {
+                candidate[c] = std::clamp((endpoints[e][c] - p + 1) >> 1, 0, 127);
+                const int diff = endpoints[e][c] - ((candidate[c] << 1) | p);
+                // Weigh alpha higher so fully opaque blocks stay fully opaque
+                error += diff * diff * (c == 3 ? 4 : 1);
+            }
+            if (error < best_error)
+            {
+                best_error = error;
+                p_bits[e] = p;
+                memcpy(quantized[e], candidate, sizeof(candidate));
+            }
+        }
+        for (size_t c = 0; c < 4; ++c)
+        {
+            endpoints[e][c] = (quantized[e][c] << 1) | p_bits[e];
+        }
+    }
+
+    int axis[4];
+    int axis_length = 0;
+    for (size_t c = 0; c < 4; ++c)
+    {
+        axis[c] = endpoints[1][c] - endpoints[0][c];
+        axis_length += axis[c] * axis[c];
+    }
+
+    uint32_t indices[16]{};
+    if (axis_length > 0)
+    {
+        for (size_t i = 0; i < 16; ++i)
+        {
+            int projection = 0;
+            for (size_t c = 0; c < 4; ++c)
+            {
+                projection += (block[i * 4 + c] - endpoints[0][c]) * axis[c];
+            }
+            const int target = std::clamp(projection * 64 / axis_length, 0, 64);
+
+            int best_error = INT_MAX;
+            for (uint32_t j = 0; j < 16; ++j)
+            {
+                const int error = std::abs(c_Weights[j] - target);
+                if (error < best_error)
+                {
+                    best_error = error;
+                    indices[i] = j;
+                }
+            }
+        }
+    }
+
+    // The most significant bit of the first index is implicitly zero
+    if (indices[0] & 0x8)
+    {
+        std::swap(quantized[0], quantized[1]);
+        std::swap(p_bits[0], p_bits[1]);
+        for (uint32_t& index : indices)
+        {
+            index = 15 - index;
+        }
+    }
+
+    Bc7Writer writer;
+    writer.write(1 << 6, 7);
+    for (size_t c = 0; c < 4; ++c)
+    {
+        writer.write(quantized[0][c], 7);
+        writer.write(quantized[1][c], 7);
+    }
+    writer.write(p_bits[0], 1);
+    writer.write(p_bits[1], 1);
+    writer.write(indices[0], 3);
+    for (size_t i = 1; i < 16; ++i)
+    {
+        writer.write(indices[i], 4);
+    }
+
+    memcpy(out, writer.bits, 16);
+}
+} // namespace
+
+void set_default_texture_compression(TEXTURE_COMPRESSION compression)
+{
+    std::lock_guard lock{g_texture_compression_lock};
+    g_default_texture_compression = compression == TEXTURE_COMPRESSION::DEFAULT ? TEXTURE_COMPRESSION::NONE : compression;
+}
+TEXTURE_COMPRESSION get_default_texture_compression()
+{
+    std::lock_guard lock{g_texture_compression_lock};
+    return g_default_texture_compression;
+}
+
+void set_texture_compression(std::string_view texture_path, TEXTURE_COMPRESSION compression, const void* owner)
+{
+    std::lock_guard lock{g_texture_compression_lock};
+    if (compression == TEXTURE_COMPRESSION::DEFAULT)
+    {
+        g_texture_compressions.erase(std::string{texture_path});
+    }
+    else
+    {
+        g_texture_compressions[std::string{texture_path}] = RequestedCompression{compression, owner};
+    }
+}
+void clear_texture_compressions(const void* owner)
+{
+    std::lock_guard lock{g_texture_compression_lock};
+    std::erase_if(g_texture_compressions, [=](const auto& entry)
+                  { return entry.second.owner == owner; });
+}
+TEXTURE_COMPRESSION get_texture_compression(std::string_view texture_path)
+{
+    std::lock_guard lock{g_texture_compression_lock};
+    if (auto it = g_texture_compressions.find(std::string{texture_path}); it != g_texture_compressions.end())
+    {
+        return it->second.compression;
+    }
+    return g_default_texture_compression;
+}
+
+bool can_compress_texture(uint32_t width, uint32_t height)
+{
+    return width > 0 && height > 0 && width % 4 == 0 && height % 4 == 0;
+}
+size_t compressed_texture_size(TEXTURE_COMPRESSION compression, uint32_t width, uint32_t height)
+{
+    const size_t num_blocks = static_cast<size_t>(width / 4) * (height / 4);
+    switch (compression)
+    {
+    case TEXTURE_COMPRESSION::BC1:
+        return num_blocks * 8;
+    case TEXTURE_COMPRESSION::BC3:
+    case TEXTURE_COMPRESSION::BC7:
+        return num_blocks * 16;
+    default:
+        return static_cast<size_t>(width) * height * 4;
+    }
+}
+
+void compress_texture(TEXTURE_COMPRESSION compression, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* out)
+{
+    PixelBlock block;
+    uint8_t lo[4];
+    uint8_t hi[4];
+    for (uint32_t block_y = 0; block_y < height / 4; ++block_y)
+    {
+        for (uint32_t block_x = 0; block_x < width / 4; ++block_x)
+        {
+            load_block(rgba, width, block_x, block_y, block);
+            block_bounds(block, lo, hi);
+
+            switch (compression)
+            {
+            case TEXTURE_COMPRESSION::BC1:
+                encode_color_block(block, lo, hi, true, out);
+                out += 8;
+                break;
+            case TEXTURE_COMPRESSION::BC3:
+                encode_alpha_block(block, lo[3], hi[3], out);
+                encode_color_block(block, lo, hi, false, out + 8);
+                out += 16;
+                break;
+            case TEXTURE_COMPRESSION::BC7:
+                encode_bc7_block(block, lo, hi, out);
+                out += 16;
+                break;
+            default:
+                return;
+            }
+        }
+    }
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>     // for size_t
+#include <cstdint>     // for uint8_t, uint32_t
+#include <string_view> // for string_view
+
+#include "texture.hpp" // for TEXTURE_COMPRESSION
+
+void set_default_texture_compression(TEXTURE_COMPRESSION compression);
+TEXTURE_COMPRESSION get_default_texture_compression();
+
+/// Remembers the compression requested for the image at `texture_path`, `TEXTURE_COMPRESSION::DEFAULT` clears it again
+/// `owner` identifies who asked for it, so `clear_texture_compressions` can forget its choices once it goes away
+void set_texture_compression(std::string_view texture_path, TEXTURE_COMPRESSION compression, const void* owner = nullptr);
+/// Forgets every compression that was requested with `owner`
+void clear_texture_compressions(const void* owner);
+/// Returns the compression requested for the image at `texture_path`, resolving `TEXTURE_COMPRESSION::DEFAULT` to the global default
+TEXTURE_COMPRESSION get_texture_compression(std::string_view texture_path);
+
+/// Block compression requires both dimensions to be a multiple of four
+bool can_compress_texture(uint32_t width, uint32_t height);
+size_t compressed_texture_size(TEXTURE_COMPRESSION compression, uint32_t width, uint32_t height);
+
+/// Encodes tightly packed RGBA8 pixels into `out`, which must hold `compressed_texture_size(...)` bytes
+void compress_texture(TEXTURE_COMPRESSION compression, const uint8_t* rgba, uint32_t width, uint32_t height, uint8_t* out);
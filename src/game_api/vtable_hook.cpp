@@ -1,95 +1,143 @@
 #include "vtable_hook.hpp"
 
-#include <Windows.h> // for GetLastError, VirtualProtect, DWORD, LPVOID
-#include <cstdint>   // for uintptr_t
-#include <vector>    // for vector, _Vector_iterator, allocator, _Vector_c...
+#include <Windows.h>     // for GetLastError, VirtualProtect, DWORD, LPVOID
+#include <cstdint>       // for uintptr_t
+#include <map>           // for map
+#include <unordered_map> // for unordered_map
 
 #include "logger.h"   // for DEBUG, PANIC
 #include "memory.hpp" // for vtable_find
 
-struct VFunctionHook
+struct VTableSlot
 {
+    void** vtable;
     std::size_t vtable_index;
-    void* original_function;
+
+    bool operator==(const VTableSlot&) const = default;
 };
-struct VTableHook
+struct VTableSlotHash
 {
-    void** vtable;
-    std::vector<VFunctionHook> functions;
+    std::size_t operator()(const VTableSlot& slot) const
+    {
+        return std::hash<void**>{}(slot.vtable) ^ (slot.vtable_index * 0x9e3779b97f4a7c15ull);
+    }
 };
-std::vector<VTableHook> g_TableHooks;
+// Original function of every hooked vtable slot
+std::unordered_map<VTableSlot, void*, VTableSlotHash> g_TableHooks;
+VTableHookStats g_VTableHookStats;
 
-VTableHook* get_vtable_hook(void** vtable)
+struct VTableHookBatchState
 {
-    auto it = std::find_if(g_TableHooks.begin(), g_TableHooks.end(), [vtable](const VTableHook& hook)
-                           { return hook.vtable == vtable; });
-    if (it != g_TableHooks.end())
+    uint32_t depth{0};
+    std::chrono::steady_clock::time_point start;
+    size_t slots{0};
+    // Original protection of every vtable page written to during the current batch
+    std::map<uintptr_t, DWORD> pages;
+};
+thread_local VTableHookBatchState g_vtable_hook_batch;
+
+DWORD make_vtable_page_writable(uintptr_t page)
+{
+    DWORD old_protect;
+    if (!VirtualProtect(reinterpret_cast<LPVOID>(page), 0x1000, PAGE_READWRITE, &old_protect))
     {
-        return &*it;
+        PANIC("VirtualProtect error: {:#x}\n", GetLastError());
     }
-    return nullptr;
+    g_VTableHookStats.page_protections++;
+    return old_protect;
 }
-VFunctionHook* get_vfunction_hook(VTableHook& vtable_hook, size_t index)
+
+// Vtables live in read-only memory, so their page is only writable while a slot is written, or until the end of the current batch
+void write_vtable_slot(void** vtable_ptr, void* function)
 {
-    auto it = std::find_if(vtable_hook.functions.begin(), vtable_hook.functions.end(), [index](const VFunctionHook& hook)
-                           { return hook.vtable_index == index; });
-    if (it != vtable_hook.functions.end())
+    const uintptr_t page = reinterpret_cast<uintptr_t>(vtable_ptr) & ~0xFFF;
+    if (g_vtable_hook_batch.depth != 0)
     {
-        return &*it;
+        if (!g_vtable_hook_batch.pages.contains(page))
+        {
+            g_vtable_hook_batch.pages[page] = make_vtable_page_writable(page);
+        }
+        *vtable_ptr = function;
+        g_vtable_hook_batch.slots++;
+        return;
     }
-    return nullptr;
+
+    DWORD old_protect = make_vtable_page_writable(page);
+    *vtable_ptr = function;
+    VirtualProtect(reinterpret_cast<LPVOID>(page), 0x1000, old_protect, &old_protect);
 }
 
-void* register_hook_function(void*** vtable, size_t index, void* hook_function)
+VTableHookBatch::VTableHookBatch()
+{
+    if (g_vtable_hook_batch.depth++ == 0)
+    {
+        g_vtable_hook_batch.start = std::chrono::steady_clock::now();
+        g_vtable_hook_batch.slots = 0;
+    }
+}
+VTableHookBatch::~VTableHookBatch()
 {
-    VTableHook* vtable_hook = get_vtable_hook(*vtable);
-    if (vtable_hook == nullptr)
+    if (--g_vtable_hook_batch.depth != 0)
     {
-        g_TableHooks.push_back({*vtable});
-        vtable_hook = &g_TableHooks.back();
+        return;
     }
-    if (auto* existing_hook = get_vfunction_hook(*vtable_hook, index))
+
+    for (const auto& [page, protect] : g_vtable_hook_batch.pages)
+    {
+        DWORD old_protect;
+        VirtualProtect(reinterpret_cast<LPVOID>(page), 0x1000, protect, &old_protect);
+    }
+    g_vtable_hook_batch.pages.clear();
+
+    if (g_vtable_hook_batch.slots != 0)
+    {
+        g_VTableHookStats.last_batch_size = g_vtable_hook_batch.slots;
+        g_VTableHookStats.last_batch_time = std::chrono::steady_clock::now() - g_vtable_hook_batch.start;
+    }
+}
+
+void* register_hook_function(void*** vtable, size_t index, void* hook_function)
+{
+    if (auto it = g_TableHooks.find(VTableSlot{*vtable, index}); it != g_TableHooks.end())
     {
         DEBUG("Multiple hooks to the same function are not allowed...");
-        return existing_hook->original_function;
+        return it->second;
     }
     else if (void** vtable_ptr = vtable_find<void*>(vtable, index))
     {
-        DWORD oldProtect;
-        if (!VirtualProtect(reinterpret_cast<LPVOID>(reinterpret_cast<uintptr_t>(vtable_ptr) & ~0xFFF), 0x1000, PAGE_READWRITE, &oldProtect))
-        {
-            PANIC("VirtualProtect error: {:#x}\n", GetLastError());
-        }
-
         void* original_function = *vtable_ptr;
-        *vtable_ptr = hook_function;
-        vtable_hook->functions.push_back({index, original_function});
+        write_vtable_slot(vtable_ptr, hook_function);
+        g_TableHooks.emplace(VTableSlot{*vtable, index}, original_function);
+        g_VTableHookStats.registered++;
         return original_function;
     }
     return nullptr;
 }
 void unregister_hook_function(void*** vtable, size_t index)
 {
-    if (VTableHook* vtable_hook = get_vtable_hook(*vtable))
+    if (auto it = g_TableHooks.find(VTableSlot{*vtable, index}); it != g_TableHooks.end())
     {
-        if (VFunctionHook* vfunction_hook = get_vfunction_hook(*vtable_hook, index))
+        if (void** vtable_ptr = vtable_find<void*>(vtable, index))
         {
-            if (void** vtable_ptr = vtable_find<void*>(vtable, index))
-            {
-                *vtable_ptr = vfunction_hook->original_function;
-                vtable_hook->functions.erase(vtable_hook->functions.begin() + (vfunction_hook - &vtable_hook->functions.front()));
-            }
+            write_vtable_slot(vtable_ptr, it->second);
+            g_TableHooks.erase(it);
+            g_VTableHookStats.unregistered++;
         }
     }
 }
+
 void* get_hook_function(void*** vtable, size_t index)
 {
-    if (VTableHook* vtable_hook = get_vtable_hook(*vtable))
+    if (auto it = g_TableHooks.find(VTableSlot{*vtable, index}); it != g_TableHooks.end())
     {
-        if (VFunctionHook* vfunction_hook = get_vfunction_hook(*vtable_hook, index))
-        {
-            return vfunction_hook->original_function;
-        }
+        return it->second;
     }
     return nullptr;
 }
+
+VTableHookStats get_vtable_hook_stats()
+{
+    VTableHookStats stats = g_VTableHookStats;
+    stats.hooked_functions = g_TableHooks.size();
+    return stats;
+}
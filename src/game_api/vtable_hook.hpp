@@ -1,19 +1,46 @@
 #pragma once
 
-#include <cstddef>       // for size_t
-#include <functional>    // for equal_to, function, _Func_class
-#include <new>           // for operator new
-#include <type_traits>   // for forward
-#include <unordered_map> // for unordered_map, _Umap_traits<>::allocator_type
-#include <utility>       // for min, max
-#include <vector>        // for vector, _Vector_iterator, allocator, _Vecto...
+#include <chrono>      // for nanoseconds
+#include <cstddef>     // for size_t
+#include <cstdint>     // for uint64_t
+#include <functional>  // for equal_to, function, _Func_class
+#include <memory>      // for unique_ptr, make_unique
+#include <new>         // for operator new
+#include <type_traits> // for forward
+#include <utility>     // for min, max, move
+#include <vector>      // for vector, _Vector_iterator, allocator, _Vecto...
 
-#include "util.hpp" // for function_signature
+#include "containers/flat_pointer_map.hpp" // for FlatPointerMap
+#include "util.hpp"                        // for function_signature
 
 void* register_hook_function(void*** vtable, size_t index, void* hook_function);
 void unregister_hook_function(void*** vtable, size_t index);
 void* get_hook_function(void*** vtable, size_t index);
 
+/// Groups all vtable slots hooked or unhooked while it is alive, so every touched vtable page is made writable once per batch instead of once per slot.
+/// Batches nest, pages get their original protection back when the outermost batch ends. Use one when hooking many entity types at once.
+class VTableHookBatch
+{
+  public:
+    VTableHookBatch();
+    ~VTableHookBatch();
+
+    VTableHookBatch(const VTableHookBatch&) = delete;
+    VTableHookBatch& operator=(const VTableHookBatch&) = delete;
+};
+
+struct VTableHookStats
+{
+    size_t hooked_functions{0};
+    uint64_t registered{0};
+    uint64_t unregistered{0};
+    uint64_t page_protections{0};
+    size_t last_batch_size{0};
+    std::chrono::nanoseconds last_batch_time{0};
+};
+VTableHookStats get_vtable_hook_stats();
+
+// The detours below run for every object sharing a hooked vtable, hooked or not, so objects without hooks must only cost one probe into a flat table
 struct VDestructorDetour
 {
     using VFunT = void(void*, bool);
@@ -21,19 +48,27 @@ struct VDestructorDetour
 
     static void detour(void* self, bool destroy)
     {
-        if (s_Tasks.contains(self))
+        if (s_Observer != nullptr)
+        {
+            s_Observer(self);
+        }
+        if (std::vector<DtorTaskT>* tasks = s_Tasks.find(self))
         {
-            for (auto& task : s_Tasks[self])
+            // Tasks may hook other objects, which can move the table, so take them out first
+            std::vector<DtorTaskT> self_tasks = std::move(*tasks);
+            s_Tasks.erase(self);
+            for (auto& task : self_tasks)
             {
                 task(self);
             }
-            s_Tasks.erase(self);
         }
-        s_OriginalDtors[*(void***)self](self, destroy);
+        (*s_OriginalDtors.find(*(void***)self))(self, destroy);
     }
 
-    inline static std::unordered_map<void**, VFunT*> s_OriginalDtors{};
-    inline static std::unordered_map<void*, std::vector<DtorTaskT>> s_Tasks{};
+    inline static FlatPointerMap<void*, VFunT*> s_OriginalDtors{};
+    inline static FlatPointerMap<void, std::vector<DtorTaskT>> s_Tasks{};
+    // Runs first for every object destroyed through a hooked destructor, see `observe_dtor`
+    inline static void (*s_Observer)(void*){nullptr};
 };
 
 template <function_signature VFunT, size_t Index>
@@ -47,32 +82,24 @@ struct VTableDetour<RetT(ClassT*, ArgsT...), Index>
 
     static RetT detour(ClassT* self, ArgsT... args)
     {
-        void** vtable = *(void***)self;
-        if constexpr (std::is_void_v<RetT>)
+        VFunT* original = *s_Originals.find(*(void***)self);
+        if (!s_Functions.empty())
         {
-            if (s_Functions.contains(self))
+            // Hooks live on the heap so they stay put while they run, even if they hook other objects
+            if (std::unique_ptr<DetourFunT>* function = s_Functions.find(self))
             {
-                s_Functions[self](self, args..., s_Originals[vtable]);
-                return;
+                return (**function)(self, args..., original);
             }
-            s_Originals[vtable](self, std::move(args)...);
-        }
-        else
-        {
-            if (s_Functions.contains(self))
-            {
-                return s_Functions[self](self, args..., s_Originals[vtable]);
-            }
-            return s_Originals[vtable](self, std::move(args)...);
         }
+        return original(self, std::move(args)...);
     }
 
-    inline static std::unordered_map<void**, VFunT*> s_Originals{};
-    inline static std::unordered_map<ClassT*, DetourFunT> s_Functions{};
+    inline static FlatPointerMap<void*, VFunT*> s_Originals{};
+    inline static FlatPointerMap<ClassT, std::unique_ptr<DetourFunT>> s_Functions{};
 };
 
-template <class HookFunT>
-void hook_dtor(void* obj, HookFunT&& hook_fun, std::size_t dtor_index = 0)
+// Hooks the destructor of every object sharing the vtable of `obj` without adding a task, so `VDestructorDetour::s_Observer` sees them being destroyed
+inline void observe_dtor(void* obj, std::size_t dtor_index = 0)
 {
     using DestructorDetourT = VDestructorDetour;
     using DtorT = DestructorDetourT::VFunT;
@@ -81,7 +108,13 @@ void hook_dtor(void* obj, HookFunT&& hook_fun, std::size_t dtor_index = 0)
     {
         DestructorDetourT::s_OriginalDtors[*vtable] = (DtorT*)register_hook_function(vtable, dtor_index, (void*)&DestructorDetourT::detour);
     }
-    DestructorDetourT::s_Tasks[obj].push_back(std::forward<HookFunT>(hook_fun));
+}
+
+template <class HookFunT>
+void hook_dtor(void* obj, HookFunT&& hook_fun, std::size_t dtor_index = 0)
+{
+    observe_dtor(obj, dtor_index);
+    VDestructorDetour::s_Tasks[obj].push_back(std::forward<HookFunT>(hook_fun));
 }
 
 template <class VTableFunT, std::size_t VTableIndex, class T, class HookFunT>
@@ -93,7 +126,7 @@ void hook_vtable_no_dtor(T* obj, HookFunT&& hook_fun)
     {
         DetourT::s_Originals[*vtable] = (VTableFunT*)register_hook_function(vtable, VTableIndex, (void*)&DetourT::detour);
     }
-    DetourT::s_Functions[obj] = std::forward<HookFunT>(hook_fun);
+    DetourT::s_Functions[obj] = std::make_unique<typename DetourT::DetourFunT>(std::forward<HookFunT>(hook_fun));
 }
 
 template <class VTableFunT, std::size_t VTableIndex, class T, class HookFunT>
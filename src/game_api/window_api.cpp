@@ -10,6 +10,7 @@
 #include <atomic>
 #include <chrono>
 
+#include "hook_registry.hpp"
 #include "logger.h"
 #include "memory.hpp"
 
@@ -401,17 +402,7 @@ bool init_hooks(void* swap_chain_ptr)
 
     {
         g_destroy_game_manager_trampoline = (DestroyGameManager*)get_address("destroy_game_manager"sv);
-
-        DetourTransactionBegin();
-        DetourUpdateThread(GetCurrentThread());
-
-        DetourAttach((void**)&g_destroy_game_manager_trampoline, destroy_game_manager);
-
-        const LONG error = DetourTransactionCommit();
-        if (error != NO_ERROR)
-        {
-            DEBUG("Failed hooking DestroyGameManager: {}\n", error);
-        }
+        attach_hook("destroy_game_manager", (void**)&g_destroy_game_manager_trampoline, destroy_game_manager);
     }
 
     return true;
@@ -0,0 +1,99 @@
+#include "worker_pool.hpp"
+
+#include <algorithm> // for min, max
+
+WorkerPool::WorkerPool(size_t worker_count)
+{
+    m_Workers.reserve(worker_count);
+    for (size_t i = 0; i < worker_count; ++i)
+    {
+        m_Workers.emplace_back(&WorkerPool::work, this);
+    }
+}
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard lock{m_Lock};
+        m_Stop = true;
+    }
+    m_JobReady.notify_all();
+    for (std::thread& worker : m_Workers)
+    {
+        worker.join();
+    }
+}
+
+WorkerPool& WorkerPool::get()
+{
+    static WorkerPool* pool = new WorkerPool{std::min<size_t>(3, std::max(1u, std::thread::hardware_concurrency()) - 1)};
+    return *pool;
+}
+
+void WorkerPool::run(size_t task_count, const std::function<void(size_t)>& task)
+{
+    if (m_Workers.empty() || task_count <= 1)
+    {
+        for (size_t i = 0; i < task_count; ++i)
+        {
+            task(i);
+        }
+        return;
+    }
+
+    std::lock_guard run_lock{m_RunLock};
+    {
+        std::lock_guard lock{m_Lock};
+        m_Task = &task;
+        m_TaskCount = task_count;
+        m_NextTask = 0;
+        m_BusyThreads = m_Workers.size();
+        m_Generation++;
+    }
+    m_JobReady.notify_all();
+
+    do_tasks();
+
+    // Workers may still be finishing their last task, and must be done with `task` before it goes out of scope
+    std::unique_lock lock{m_Lock};
+    m_JobDone.wait(lock, [this]
+                   { return m_BusyThreads == 0; });
+    m_Task = nullptr;
+}
+
+void WorkerPool::work()
+{
+    uint64_t seen_generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock lock{m_Lock};
+            m_JobReady.wait(lock, [&]
+                            { return m_Stop || m_Generation != seen_generation; });
+            if (m_Stop)
+            {
+                return;
+            }
+            seen_generation = m_Generation;
+        }
+
+        do_tasks();
+
+        bool last = false;
+        {
+            std::lock_guard lock{m_Lock};
+            last = --m_BusyThreads == 0;
+        }
+        if (last)
+        {
+            m_JobDone.notify_one();
+        }
+    }
+}
+
+void WorkerPool::do_tasks()
+{
+    for (size_t i = m_NextTask++; i < m_TaskCount; i = m_NextTask++)
+    {
+        (*m_Task)(i);
+    }
+}
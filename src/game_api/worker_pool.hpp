@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>             // for atomic
+#include <condition_variable> // for condition_variable
+#include <cstddef>            // for size_t
+#include <cstdint>            // for uint64_t
+#include <functional>         // for function
+#include <mutex>              // for mutex
+#include <thread>             // for thread
+#include <vector>             // for vector
+
+// Persistent threads for splitting up read-only work, the calling thread works on the job as well and `run` only returns once every task is done.
+// Tasks must not touch anything the game thread could be changing, which holds while a script callback runs since the game waits for it.
+class WorkerPool
+{
+  public:
+    explicit WorkerPool(size_t worker_count);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Shared pool with up to 3 workers, created on first use and never destroyed so no thread has to be joined while the dll unloads
+    static WorkerPool& get();
+
+    // Number of threads working on a job, including the caller
+    size_t thread_count() const
+    {
+        return m_Workers.size() + 1;
+    }
+
+    // Calls `task(i)` for every `i` below `task_count`, in no particular order and spread across all threads
+    void run(size_t task_count, const std::function<void(size_t)>& task);
+
+  private:
+    void work();
+    void do_tasks();
+
+    std::vector<std::thread> m_Workers;
+    std::mutex m_Lock;
+    std::condition_variable m_JobReady;
+    std::condition_variable m_JobDone;
+    // Incremented for every job, workers wait for it to change
+    uint64_t m_Generation{0};
+    bool m_Stop{false};
+    // Serializes callers, the pool only runs one job at a time
+    std::mutex m_RunLock;
+
+    const std::function<void(size_t)>* m_Task{nullptr};
+    size_t m_TaskCount{0};
+    std::atomic<size_t> m_NextTask{0};
+    size_t m_BusyThreads{0};
+};
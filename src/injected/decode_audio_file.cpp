@@ -1,8 +1,12 @@
 #include "decode_audio_file.hpp"
 
+#include <algorithm>   // for transform
+#include <cctype>      // for tolower
 #include <cstddef>     // for byte
 #include <cstring>     // for memcpy
 #include <memory>      // for make_unique, unique_ptr
+#include <string>      // for string
+#include <string_view> // for string_view
 #include <type_traits> // for move
 #include <vector>      // for vector
 
@@ -15,8 +19,7 @@
 #pragma warning(push, 0)
 #endif
 
-#include <cstdint>               // for uint8_t
-#include <libnyquist/Decoders.h> // for AudioData, ConvertFromFloat32, GetF...
+#include <libnyquist/Decoders.h> // for AudioData, NyquistIO
 
 #if defined(__clang__)
 #pragma clang diagnostic pop
@@ -24,22 +27,47 @@
 #pragma warning(pop)
 #endif
 
+#include "wav_file_stream.hpp" // for WavFileStream
+
 DecodedAudioBuffer LoadAudioFile(const char* file_path)
 {
+    // Wav data can be handed to Fmod as is, read it straight into the padded buffer instead of round-tripping through float samples
+    if (auto wav_stream = WavFileStream::open(file_path))
+    {
+        const auto data_size = wav_stream->data_size();
+        auto data = std::make_unique<std::byte[]>(data_size + 32); // 16 bytes padding front and back
+        if (wav_stream->read(data.get() + 16, data_size) == data_size)
+        {
+            return DecodedAudioBuffer{
+                wav_stream->num_channels(), wav_stream->frequency(), wav_stream->format(), std::move(data), data_size};
+        }
+    }
+
     nqr::AudioData decoded_data;
     nqr::NyquistIO loader;
     loader.Load(&decoded_data, file_path);
 
-    const auto data_size = decoded_data.samples.size() * (GetFormatBitsPerSample(decoded_data.sourceFormat) / 8);
+    // Every other format is decoded to float samples, Fmod plays those as is so converting them back to the source bit depth would only cost another pass
+    const auto data_size = decoded_data.samples.size() * sizeof(float);
     auto data = std::make_unique<std::byte[]>(data_size + 32); // 16 bytes padding front and back
-    if (decoded_data.sourceFormat == nqr::PCM_FLT)
-    {
-        memcpy(data.get() + 16, decoded_data.samples.data(), data_size);
-    }
-    else
+    memcpy(data.get() + 16, decoded_data.samples.data(), data_size);
+    return DecodedAudioBuffer{
+        decoded_data.channelCount, decoded_data.sampleRate, SoundFormat::PCM_FLOAT, std::move(data), data_size};
+}
+
+std::unique_ptr<AudioStream> OpenAudioFileStream(const char* file_path)
+{
+    const std::string_view path{file_path};
+    const auto extension_pos = path.find_last_of('.');
+    if (extension_pos != std::string_view::npos)
     {
-        nqr::ConvertFromFloat32((std::uint8_t*)data.get() + 16, decoded_data.samples.data(), decoded_data.samples.size(), decoded_data.sourceFormat);
+        std::string extension{path.substr(extension_pos)};
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c)
+                       { return static_cast<char>(std::tolower(c)); });
+        if (extension == ".wav")
+        {
+            return WavFileStream::open(file_path);
+        }
     }
-    return DecodedAudioBuffer{
-        decoded_data.channelCount, decoded_data.sampleRate, static_cast<SoundFormat>(decoded_data.sourceFormat - 1), std::move(data), data_size};
+    return nullptr;
 }
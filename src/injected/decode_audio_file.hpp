@@ -3,3 +3,6 @@
 #include "audio_buffer.hpp"
 
 DecodedAudioBuffer LoadAudioFile(const char* file_path);
+
+/// Opens a chunked decoder for the file, returns `nullptr` for formats that can only be decoded in one go
+std::unique_ptr<AudioStream> OpenAudioFileStream(const char* file_path);
@@ -29,17 +29,25 @@
 
 #include "olfont.h"
 
+#include "code_cave.hpp"
 #include "console.hpp"
 #include "custom_types.hpp"
+#include "dds_cache.hpp"
 #include "entities_chars.hpp"
 #include "entities_floors.hpp"
 #include "entities_items.hpp"
 #include "entities_logical.hpp"
 #include "entities_mounts.hpp"
+#include "entity_change_feed.hpp"
+#include "entity_query.hpp"
 #include "file_api.hpp"
 #include "flags.hpp"
 #include "game_manager.hpp"
+#include "hook_registry.hpp"
 #include "items.hpp"
+#include "level_file_stats.hpp"
+#include "level_gen_replay.hpp"
+#include "level_gen_trace.hpp"
 #include "logger.h"
 #include "math.hpp"
 #include "savedata.hpp"
@@ -48,7 +56,10 @@
 #include "settings_api.hpp"
 #include "sound_manager.hpp" // TODO: remove from here?
 #include "state.hpp"
+#include "telemetry.hpp"
+#include "texture_compression.hpp"
 #include "version.hpp"
+#include "vtable_hook.hpp"
 #include "window_api.hpp"
 
 #include "decode_audio_file.hpp"
@@ -267,6 +278,11 @@ const std::string cfgfile = "overlunky.ini";
 std::string scriptpath = "Overlunky/Scripts";
 
 std::string fontfile = "";
+std::string texture_cache_dir = "Overlunky/TextureCache";
+int texture_cache_size_mb = 512;
+const char* level_gen_trace_file = "Overlunky/level_gen_trace.olgt";
+std::optional<LevelGenReplayStats> level_gen_replay_stats;
+int texture_compression = 0;
 std::vector<float> fontsize = {14.0f, 32.0f, 72.0f};
 
 [[maybe_unused]] const char s8_zero = 0, s8_one = 1, s8_min = -128, s8_max = 127;
@@ -321,7 +337,9 @@ std::map<std::string, bool> options = {
     {"menu_ui", true},
     {"hd_cursor", true},
     {"inverted", false},
-    {"borders", false}};
+    {"borders", false},
+    {"texture_cache", false},
+    {"telemetry", false}};
 
 bool g_speedhack_hooked = false;
 float g_speedhack_multiplier = 1.0;
@@ -852,6 +870,12 @@ void save_config(std::string file)
               << "# A relative path is relative to the game directory. Use forward / slashes." << std::endl;
     writeData << "script_dir = \"" << scriptpath << "\"" << std::endl;
 
+    writeData << "# Directory and size limit of the decoded custom texture cache, used when texture_cache = 1" << std::endl;
+    writeData << "texture_cache_dir = \"" << texture_cache_dir << "\"" << std::endl;
+    writeData << "texture_cache_size_mb = " << std::dec << texture_cache_size_mb << " # int" << std::endl;
+    writeData << "# Block compression for custom png textures that don't pick one themselves, 0 = none, 1 = BC1, 2 = BC3, 3 = BC7" << std::endl;
+    writeData << "texture_compression = " << std::dec << texture_compression << " # int" << std::endl;
+
     std::vector<std::string> ini_tabs_open;
     std::vector<std::string> ini_tabs_detached;
     for (auto [name, window] : windows)
@@ -955,6 +979,9 @@ void load_config(std::string file)
     saved_entities.clear();
     g_script_autorun = toml::find_or<std::vector<std::string>>(opts, "autorun_scripts", {});
     scriptpath = toml::find_or<std::string>(opts, "script_dir", "Overlunky/Scripts");
+    texture_cache_dir = toml::find_or<std::string>(opts, "texture_cache_dir", "Overlunky/TextureCache");
+    texture_cache_size_mb = toml::find_or<int>(opts, "texture_cache_size_mb", 512);
+    texture_compression = std::clamp(toml::find_or<int>(opts, "texture_compression", 0), 0, 3);
     fontfile = toml::find_or<std::string>(opts, "font_file", "");
     auto ini_fontsize = toml::find_or<std::vector<float>>(opts, "font_size", {14.0f, 32.0f, 72.0f});
     if (ini_fontsize.size() >= 3)
@@ -973,6 +1000,8 @@ void load_config(std::string file)
     UI::set_time_ghost_enabled(!options["disable_ghost_timer"]);
     UI::set_time_jelly_enabled(!options["disable_ghost_timer"]);
     UI::set_cursepot_ghost_enabled(!options["disable_ghost_timer"]);
+    set_dds_cache_directory(options["texture_cache"] ? texture_cache_dir : "", static_cast<size_t>(std::max(texture_cache_size_mb, 0)) * 1024 * 1024);
+    set_default_texture_compression(static_cast<TEXTURE_COMPRESSION>(texture_compression + 1));
     if (options["multi_viewports"] && !detect_wine())
     {
         ImGui::GetIO().ConfigFlags |= ImGuiConfigFlags_ViewportsEnable;
@@ -5166,6 +5195,88 @@ void render_debug()
         "%08X",
         ImGuiInputTextFlags_EnterReturnsTrue | ImGuiInputTextFlags_AlwaysInsertMode | ImGuiInputTextFlags_CharsHexadecimal);
     ImGui::PopItemWidth();
+    if (ImGui::Checkbox("Cache decoded custom textures##TextureCache", &options["texture_cache"]))
+    {
+        set_dds_cache_directory(options["texture_cache"] ? texture_cache_dir : "", static_cast<size_t>(std::max(texture_cache_size_mb, 0)) * 1024 * 1024);
+    }
+    tooltip("Store custom png textures as decoded dds files in texture_cache_dir,\nso they don't have to be decoded again on the next load.");
+    if (ImGui::Combo("Texture compression##TextureCompression", &texture_compression, "None\0BC1\0BC3\0BC7\0"))
+    {
+        set_default_texture_compression(static_cast<TEXTURE_COMPRESSION>(texture_compression + 1));
+    }
+    tooltip("Compress custom png textures that don't pick a compression themselves.\nApplies to textures loaded after changing this.");
+    if (ImGui::Checkbox("Publish game state for external trackers##Telemetry", &options["telemetry"]) && !options["telemetry"])
+    {
+        close_telemetry();
+    }
+    tooltip("Copy the current level, players, prng and entity counts to shared memory every frame,\nso trackers and overlays can read them without reading game memory.");
+    const auto telemetry_stats = get_telemetry_stats();
+    ImGui::Text("Telemetry: %s, %llu frames published", telemetry_stats.open ? "open" : "closed", telemetry_stats.published_frames);
+    const auto cache_stats = get_dds_cache_stats();
+    ImGui::Text("Texture cache: %llu hits, %llu misses, %llu stores, %llu evictions", cache_stats.hits, cache_stats.misses, cache_stats.stores, cache_stats.evictions);
+    ImGui::Text("Texture cache size: %.1f / %.1f MiB", cache_stats.total_size / (1024.0f * 1024.0f), cache_stats.max_size / (1024.0f * 1024.0f));
+    if (!is_level_gen_trace_recording())
+    {
+        if (ImGui::Button("Record level gen trace##RecordLevelGenTrace"))
+            start_level_gen_trace();
+    }
+    else if (ImGui::Button("Stop and save level gen trace##RecordLevelGenTrace"))
+    {
+        save_level_gen_trace(stop_level_gen_trace(), level_gen_trace_file);
+    }
+    tooltip("Record all tile codes and chance rolls of the following level generations\nto Overlunky/level_gen_trace.olgt.");
+    ImGui::SameLine();
+    if (ImGui::Button("Replay level gen trace##ReplayLevelGenTrace"))
+    {
+        if (auto trace = load_level_gen_trace(level_gen_trace_file))
+        {
+            const LevelGenReplayRules rules = get_level_gen_replay_rules();
+            LevelGenReplaySpawner stub_spawner;
+            level_gen_replay_stats = LevelGenReplayer{rules, stub_spawner}.replay(trace.value());
+        }
+    }
+    tooltip("Replay the recorded tile codes with the aliases and community tile codes of this session against a stub spawner.\nNothing is spawned and no callbacks run, this does not time level generation.");
+    if (level_gen_replay_stats)
+    {
+        const auto& stats = level_gen_replay_stats.value();
+        ImGui::Text("Trace of %llu levels, %llu tile codes (%llu aliased, %llu community, %llu unknown)", stats.levels, stats.tile_codes, stats.aliased_tile_codes, stats.community_tile_codes, stats.unknown_tile_codes);
+        ImGui::Text("Chance rolls: %llu, %llu successful, replaying took %.3f ms", stats.chance_rolls, stats.successful_chance_rolls, stats.replay_time.count() / 1000000.0);
+    }
+    if (submenu("Level file load times"))
+    {
+        for (const auto& file_stats : get_level_file_load_stats())
+        {
+            ImGui::Text("%s: %u loads, last %.3f ms, average %.3f ms", file_stats.file.c_str(), file_stats.loads, file_stats.last_time.count() / 1000000.0, file_stats.total_time.count() / 1000000.0 / file_stats.loads);
+        }
+        endmenu();
+    }
+    const auto code_cave_stats = get_code_cave_stats();
+    ImGui::Text("Code cave: %.1f / %.1f KiB committed, %.1f KiB data, %.1f KiB code", code_cave_stats.committed_size / 1024.0f, code_cave_stats.reserved_size / 1024.0f, code_cave_stats.used_data_size / 1024.0f, code_cave_stats.used_code_size / 1024.0f);
+    ImGui::Text("Code cave: %zu live, %llu allocations, %llu frees, %llu fallbacks, %llu protection changes (%llu writable and executable)", code_cave_stats.live_allocations, code_cave_stats.allocations, code_cave_stats.frees, code_cave_stats.fallback_allocations, code_cave_stats.protection_changes, code_cave_stats.writable_executable_pages);
+    const auto uid_lookup_stats = get_uid_lookup_stats();
+    const auto uid_lookups = uid_lookup_stats.memo_hits + uid_lookup_stats.memo_misses;
+    ImGui::Text("Uid lookups: %llu, %.1f%% memo hits", uid_lookups, uid_lookups == 0 ? 0.0 : 100.0 * uid_lookup_stats.memo_hits / uid_lookups);
+    const auto change_feed_stats = get_entity_change_feed_stats();
+    ImGui::Text("Entity change feed: %zu subscriptions, %zu / %zu buffered, %llu changes, %llu overflows", change_feed_stats.subscriptions, change_feed_stats.buffered_changes, change_feed_stats.capacity, change_feed_stats.total_changes, change_feed_stats.overflows);
+    const auto vtable_hook_stats = get_vtable_hook_stats();
+    ImGui::Text("VTable hooks: %zu hooked, %llu pages unprotected, last batch of %zu took %.3f ms", vtable_hook_stats.hooked_functions, vtable_hook_stats.page_protections, vtable_hook_stats.last_batch_size, vtable_hook_stats.last_batch_time.count() / 1000000.0);
+    bool parallel_entity_queries = g_parallel_entity_queries;
+    if (ImGui::Checkbox("Split big entity queries across threads##ParallelEntityQueries", &parallel_entity_queries))
+        g_parallel_entity_queries = parallel_entity_queries;
+    tooltip("Only queries over more than 8192 entities are split.\nOff by default until it is measured to be faster, see tests/entity_query_bench.");
+    if (submenu("Hook install times"))
+    {
+        for (const auto& hook_stats : get_hook_install_stats())
+        {
+            if (hook_stats.installed)
+                ImGui::Text("%s: attach %.3f ms, commit %.3f ms", hook_stats.name.c_str(), hook_stats.attach_time.count() / 1000000.0, hook_stats.commit_time.count() / 1000000.0);
+            else if (hook_stats.error != 0)
+                ImGui::Text("%s: failed with error %ld", hook_stats.name.c_str(), hook_stats.error);
+            else
+                ImGui::Text("%s: waiting for %s", hook_stats.name.c_str(), hook_stats.lazy_group.c_str());
+        }
+        endmenu();
+    }
 }
 
 std::string gen_random(const int len)
@@ -7566,6 +7677,8 @@ void post_draw()
     force_cheats();
     force_lights();
     frame_advance();
+    if (options["telemetry"])
+        publish_telemetry();
 }
 
 void create_box(std::vector<EntityItem> items)
@@ -7603,7 +7716,7 @@ std::string make_save_path(std::string_view script_path, std::string_view script
 
 void init_ui()
 {
-    g_SoundManager = std::make_unique<SoundManager>(&LoadAudioFile);
+    g_SoundManager = std::make_unique<SoundManager>(&LoadAudioFile, &OpenAudioFileStream);
 
     g_state = State::get().ptr_main();
     g_save = UI::savedata();
@@ -0,0 +1,161 @@
+#include "wav_file_stream.hpp"
+
+#include <algorithm> // for min
+#include <cstring>   // for memcmp
+
+std::unique_ptr<WavFileStream> WavFileStream::open(const char* file_path)
+{
+    auto stream = std::unique_ptr<WavFileStream>{new WavFileStream{}};
+    if (!stream->parse_header(file_path))
+    {
+        return nullptr;
+    }
+    return stream;
+}
+
+std::size_t WavFileStream::read(std::byte* out, std::size_t size)
+{
+    size = std::min(size, m_DataSize - m_ReadOffset);
+    m_File.read(reinterpret_cast<char*>(out), size);
+    const std::size_t size_read = static_cast<std::size_t>(m_File.gcount());
+    if (m_Format == SoundFormat::PCM_8)
+    {
+        // Wav stores 8-bit samples unsigned, Fmod expects them signed
+        for (std::size_t i = 0; i < size_read; ++i)
+        {
+            out[i] ^= std::byte{0x80};
+        }
+    }
+    m_ReadOffset += size_read;
+    return size_read;
+}
+bool WavFileStream::seek(std::size_t frame)
+{
+    const std::size_t frame_size = this->frame_size();
+    if (frame_size == 0 || frame > m_DataSize / frame_size)
+    {
+        return false;
+    }
+
+    m_ReadOffset = frame * frame_size;
+    m_File.clear();
+    m_File.seekg(m_DataOffset + static_cast<std::streamoff>(m_ReadOffset));
+    return m_File.good();
+}
+
+bool WavFileStream::parse_header(const char* file_path)
+{
+    m_File.open(file_path, std::ios::binary);
+    if (!m_File)
+    {
+        return false;
+    }
+
+    char riff_header[12];
+    if (!m_File.read(riff_header, sizeof(riff_header)) || memcmp(riff_header, "RIFF", 4) != 0 || memcmp(riff_header + 8, "WAVE", 4) != 0)
+    {
+        return false;
+    }
+
+    bool has_format{false};
+    while (true)
+    {
+        char chunk_id[4];
+        std::uint32_t chunk_size;
+        if (!m_File.read(chunk_id, sizeof(chunk_id)) || !m_File.read(reinterpret_cast<char*>(&chunk_size), sizeof(chunk_size)))
+        {
+            return false;
+        }
+        const std::streampos chunk_start = m_File.tellg();
+
+        if (memcmp(chunk_id, "fmt ", 4) == 0)
+        {
+            std::uint16_t format_tag;
+            std::uint16_t num_channels;
+            std::uint32_t frequency;
+            std::uint32_t byte_rate;
+            std::uint16_t block_align;
+            std::uint16_t bits_per_sample;
+            m_File.read(reinterpret_cast<char*>(&format_tag), sizeof(format_tag));
+            m_File.read(reinterpret_cast<char*>(&num_channels), sizeof(num_channels));
+            m_File.read(reinterpret_cast<char*>(&frequency), sizeof(frequency));
+            m_File.read(reinterpret_cast<char*>(&byte_rate), sizeof(byte_rate));
+            m_File.read(reinterpret_cast<char*>(&block_align), sizeof(block_align));
+            m_File.read(reinterpret_cast<char*>(&bits_per_sample), sizeof(bits_per_sample));
+
+            static constexpr std::uint16_t c_FormatPcm{0x1};
+            static constexpr std::uint16_t c_FormatFloat{0x3};
+            static constexpr std::uint16_t c_FormatExtensible{0xFFFE};
+            if (format_tag == c_FormatExtensible && chunk_size >= 26)
+            {
+                // The sub format guid starts with the actual format tag
+                std::uint16_t extension_size;
+                std::uint16_t valid_bits;
+                std::uint32_t channel_mask;
+                m_File.read(reinterpret_cast<char*>(&extension_size), sizeof(extension_size));
+                m_File.read(reinterpret_cast<char*>(&valid_bits), sizeof(valid_bits));
+                m_File.read(reinterpret_cast<char*>(&channel_mask), sizeof(channel_mask));
+                m_File.read(reinterpret_cast<char*>(&format_tag), sizeof(format_tag));
+            }
+
+            if (format_tag == c_FormatPcm)
+            {
+                switch (bits_per_sample)
+                {
+                case 8:
+                    m_Format = SoundFormat::PCM_8;
+                    break;
+                case 16:
+                    m_Format = SoundFormat::PCM_16;
+                    break;
+                case 24:
+                    m_Format = SoundFormat::PCM_24;
+                    break;
+                case 32:
+                    m_Format = SoundFormat::PCM_32;
+                    break;
+                default:
+                    return false;
+                }
+            }
+            else if (format_tag == c_FormatFloat && bits_per_sample == 32)
+            {
+                m_Format = SoundFormat::PCM_FLOAT;
+            }
+            else
+            {
+                return false;
+            }
+
+            m_NumChannels = num_channels;
+            m_Frequency = static_cast<std::int32_t>(frequency);
+            has_format = num_channels > 0;
+        }
+        else if (memcmp(chunk_id, "data", 4) == 0)
+        {
+            if (!has_format)
+            {
+                return false;
+            }
+            m_DataOffset = m_File.tellg();
+
+            // Truncated files or ones written by a streaming encoder can claim more data than there is
+            m_File.seekg(0, std::ios::end);
+            const std::streamoff remaining = m_File.tellg() - m_DataOffset;
+            m_File.seekg(m_DataOffset);
+            if (!m_File || remaining < 0)
+            {
+                return false;
+            }
+            m_DataSize = std::min<std::size_t>(chunk_size, static_cast<std::size_t>(remaining));
+            return true;
+        }
+
+        // Chunks are padded to an even size
+        m_File.seekg(chunk_start + static_cast<std::streamoff>(chunk_size + (chunk_size & 1)));
+        if (!m_File)
+        {
+            return false;
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef> // for size_t
+#include <cstdint> // for int32_t
+#include <fstream> // for ifstream
+#include <memory>  // for unique_ptr
+
+#include "audio_buffer.hpp" // for AudioStream, SoundFormat
+
+// Reads PCM straight from the data chunk of a wav file, so memory use doesn't depend on the length of the file
+class WavFileStream : public AudioStream
+{
+  public:
+    /// Returns `nullptr` if the file is not a wav file with a PCM format Fmod can play
+    static std::unique_ptr<WavFileStream> open(const char* file_path);
+
+    std::int32_t num_channels() const override
+    {
+        return m_NumChannels;
+    }
+    std::int32_t frequency() const override
+    {
+        return m_Frequency;
+    }
+    SoundFormat format() const override
+    {
+        return m_Format;
+    }
+    std::size_t data_size() const override
+    {
+        return m_DataSize;
+    }
+
+    std::size_t read(std::byte* out, std::size_t size) override;
+    bool seek(std::size_t frame) override;
+
+  private:
+    WavFileStream() = default;
+
+    bool parse_header(const char* file_path);
+
+    std::ifstream m_File;
+    std::streampos m_DataOffset{};
+    std::size_t m_DataSize{0};
+    std::size_t m_ReadOffset{0};
+    std::int32_t m_NumChannels{0};
+    std::int32_t m_Frequency{0};
+    SoundFormat m_Format{SoundFormat::PCM_16};
+};
@@ -5,6 +5,7 @@
 #include "entity.hpp"
 #include "file_api.hpp"
 #include "memory.hpp"
+#include "prng_batch.hpp"
 #include "render_api.hpp"
 #include "screen.hpp"
 #include "script.hpp"
@@ -149,6 +150,17 @@ void Spelunky_DisableSteamAchievements()
     disable_steam_achievements();
 }
 
+bool Spelunky_PrngBatchDraw(const int64_t* seeds, size_t seed_count, uint32_t prng_class, size_t draw_count, uint64_t* out_pairs)
+{
+    static_assert(sizeof(PRNG::prng_pair) == sizeof(uint64_t) * 2);
+    if (prng_class > 9)
+    {
+        return false;
+    }
+    PrngBatch::draw({seeds, seed_count}, static_cast<PRNG::PRNG_CLASS>(prng_class), draw_count, reinterpret_cast<PRNG::prng_pair*>(out_pairs));
+    return true;
+}
+
 ID3D11Device* SpelunkyGetD3D11Device()
 {
     return get_device();
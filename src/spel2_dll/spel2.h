@@ -87,6 +87,11 @@ void Spelunky_RegisterGetImagePathFunc(Spelunky_GetImageFilePathFunc get_image_f
 
 void Spelunky_DisableSteamAchievements();
 
+// Writes the first `draw_count` prng pairs of `prng_class` for each seed, as they would be right after seeding, to `out_pairs`
+// `out_pairs` must hold `seed_count * draw_count * 2` values, does not touch the game prng
+// Returns false without writing anything if `prng_class` is not in the range 0..9
+bool Spelunky_PrngBatchDraw(const int64_t* seeds, size_t seed_count, uint32_t prng_class, size_t draw_count, uint64_t* out_pairs);
+
 struct ID3D11Device* SpelunkyGetD3D11Device();
 
 SpelunkyScript* Spelunky_CreateScript(const char* file_path, bool enabled);
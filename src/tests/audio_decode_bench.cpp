@@ -0,0 +1,137 @@
+#include <algorithm>  // for min, max, sort
+#include <atomic>     // for atomic
+#include <chrono>     // for steady_clock, duration
+#include <cstddef>    // for size_t
+#include <cstdio>     // for printf, fprintf
+#include <cstdlib>    // for malloc, free, atoi
+#include <exception>  // for exception
+#include <filesystem> // for directory_iterator, path
+#include <new>        // for bad_alloc
+#include <string>     // for string
+#include <vector>     // for vector
+
+#include "decode_audio_file.hpp" // for LoadAudioFile
+
+// Decodes every file in a corpus directory with LoadAudioFile and reports decode time and peak heap use per file.
+// Usage: audio_decode_bench <directory with wav, ogg, mp3, flac files> [iterations]
+
+namespace
+{
+// Only counts allocations that go through operator new, which covers the output buffer and libnyquists sample vectors
+std::atomic<size_t> g_heap_in_use{0};
+std::atomic<size_t> g_heap_peak{0};
+
+void* tracked_alloc(size_t size)
+{
+    // The size is stored in front of the block so the matching delete knows how much to give back
+    void* block = std::malloc(size + sizeof(std::max_align_t));
+    if (block == nullptr)
+    {
+        throw std::bad_alloc{};
+    }
+    *static_cast<size_t*>(block) = size;
+
+    const size_t in_use = g_heap_in_use += size;
+    size_t peak = g_heap_peak.load();
+    while (in_use > peak && !g_heap_peak.compare_exchange_weak(peak, in_use))
+    {
+    }
+    return static_cast<std::byte*>(block) + sizeof(std::max_align_t);
+}
+void tracked_free(void* ptr)
+{
+    if (ptr != nullptr)
+    {
+        void* block = static_cast<std::byte*>(ptr) - sizeof(std::max_align_t);
+        g_heap_in_use -= *static_cast<size_t*>(block);
+        std::free(block);
+    }
+}
+} // namespace
+
+void* operator new(size_t size)
+{
+    return tracked_alloc(size);
+}
+void* operator new[](size_t size)
+{
+    return tracked_alloc(size);
+}
+void operator delete(void* ptr) noexcept
+{
+    tracked_free(ptr);
+}
+void operator delete[](void* ptr) noexcept
+{
+    tracked_free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept
+{
+    tracked_free(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept
+{
+    tracked_free(ptr);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        std::fprintf(stderr, "usage: %s <corpus directory> [iterations]\n", argv[0]);
+        return 1;
+    }
+    const int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 5;
+
+    std::vector<std::filesystem::path> files;
+    for (const auto& entry : std::filesystem::directory_iterator{argv[1]})
+    {
+        if (entry.is_regular_file())
+        {
+            files.push_back(entry.path());
+        }
+    }
+    std::sort(files.begin(), files.end());
+
+    std::printf("%-40s %12s %10s %10s %12s\n", "file", "file MiB", "PCM MiB", "best ms", "peak MiB");
+    double total_ms = 0.0;
+    for (const std::filesystem::path& file : files)
+    {
+        const std::string path = file.string();
+        double best_ms = 1e30;
+        size_t pcm_size = 0;
+        size_t peak = 0;
+        try
+        {
+            for (int i = 0; i < iterations; ++i)
+            {
+                g_heap_peak = g_heap_in_use.load();
+                const size_t baseline = g_heap_in_use;
+
+                const auto start = std::chrono::steady_clock::now();
+                const DecodedAudioBuffer buffer = LoadAudioFile(path.c_str());
+                const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+                best_ms = std::min(best_ms, elapsed.count());
+                pcm_size = buffer.data_size;
+                peak = g_heap_peak - baseline;
+            }
+        }
+        catch (const std::exception& except)
+        {
+            std::printf("%-40s failed: %s\n", file.filename().string().c_str(), except.what());
+            continue;
+        }
+
+        total_ms += best_ms;
+        constexpr double c_MiB{1024.0 * 1024.0};
+        std::printf("%-40s %12.2f %10.2f %10.2f %12.2f\n",
+                    file.filename().string().c_str(),
+                    static_cast<double>(std::filesystem::file_size(file)) / c_MiB,
+                    static_cast<double>(pcm_size) / c_MiB,
+                    best_ms,
+                    static_cast<double>(peak) / c_MiB);
+    }
+    std::printf("total best decode time: %.2f ms over %zu files\n", total_ms, files.size());
+    return 0;
+}
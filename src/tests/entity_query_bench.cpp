@@ -0,0 +1,158 @@
+#include <algorithm> // for max
+#include <bit>       // for countr_zero, has_single_bit
+#include <chrono>    // for steady_clock, duration
+#include <cmath>     // for pow, sqrt
+#include <cstdint>   // for uint32_t
+#include <cstdio>    // for printf
+#include <cstdlib>   // for atoi
+#include <memory>    // for make_unique, unique_ptr
+#include <random>    // for mt19937, uniform_real_distribution
+#include <span>      // for span
+#include <thread>    // for hardware_concurrency
+#include <vector>    // for vector
+
+#include "entity_query.hpp" // for collect_entity_uids, entities_by_mask, g_parallel_entity_queries, ...
+#include "test_util.hpp"    // for CHECK
+#include "worker_pool.hpp"  // for WorkerPool
+
+// Runs the entity queries of entity_query.hpp over a synthetic level with pools of every thread count and reports the time per query.
+// Results have to be identical to the sequential walk for every thread count, the bench stops otherwise.
+// Usage: entity_query_bench [entities] [max_threads]
+
+// The real one lives in layer.cpp next to a lot of game code, the bench only needs the lists without the cache
+const MaskEntityLists& Layer::get_mask_lists() const
+{
+    thread_local MaskEntityLists lists;
+    lists.fill(nullptr);
+    for (const auto& [mask, entities] : entities_by_mask)
+    {
+        if (std::has_single_bit(mask) && mask < 0x8000)
+        {
+            lists[std::countr_zero(mask)] = &entities;
+        }
+    }
+    return lists;
+}
+
+namespace
+{
+struct SyntheticLayer
+{
+    std::vector<EntityDB> types;
+    std::vector<Entity> entities;
+    std::vector<Entity*> entity_lists[16];
+    std::vector<uint32_t> uid_lists[16];
+    std::unique_ptr<Layer> layer;
+
+    explicit SyntheticLayer(uint32_t entity_count)
+    {
+        // A few types share several mask bits, so some entities are in more than one list like in the game
+        for (uint32_t i = 0; i < 64; ++i)
+        {
+            types.push_back(EntityDB{i + 1, (1u << (i % 6)) | (i % 7 == 0 ? 2u : 0u)});
+        }
+
+        std::mt19937 rng{1};
+        std::uniform_real_distribution<float> x{0.0f, 86.0f};
+        std::uniform_real_distribution<float> y{0.0f, 126.0f};
+        entities.resize(entity_count);
+        for (uint32_t i = 0; i < entity_count; ++i)
+        {
+            entities[i] = Entity{&types[rng() % types.size()], i, x(rng), y(rng), 0.5f, 0.5f};
+        }
+
+        layer = std::make_unique<Layer>();
+        for (Entity& entity : entities)
+        {
+            entity_lists[15].push_back(&entity);
+            uid_lists[15].push_back(entity.uid);
+            for (uint32_t bit = 0; bit < 15; ++bit)
+            {
+                if (entity.type->search_flags & (1u << bit))
+                {
+                    entity_lists[bit].push_back(&entity);
+                    uid_lists[bit].push_back(entity.uid);
+                }
+            }
+        }
+        layer->all_entities = to_list(15);
+        for (uint32_t bit = 0; bit < 15; ++bit)
+        {
+            if (!entity_lists[bit].empty())
+            {
+                layer->entities_by_mask[1u << bit] = to_list(bit);
+            }
+        }
+    }
+
+    EntityList to_list(uint32_t index)
+    {
+        const uint32_t size = static_cast<uint32_t>(entity_lists[index].size());
+        return EntityList{entity_lists[index].data(), uid_lists[index].data(), size, size};
+    }
+};
+
+template <class PredT>
+std::vector<uint32_t> sequential_uids(std::span<const MaskedEntityView> views, PredT&& matches)
+{
+    std::vector<uint32_t> uids;
+    for (const MaskedEntityView& view : views)
+    {
+        for (Entity* entity : view)
+        {
+            if (matches(entity))
+            {
+                uids.push_back(entity->uid);
+            }
+        }
+    }
+    return uids;
+}
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const uint32_t entity_count = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : 60000;
+    const size_t max_threads = argc > 2 ? static_cast<size_t>(std::atoi(argv[2])) : std::max<size_t>(8, std::thread::hardware_concurrency());
+
+    SyntheticLayer synthetic{entity_count};
+    EntityTypeSet types{{1, 5, 9, 17, 33}};
+    // Same shapes as get_entities_by and get_entities_overlapping_hitbox, a LAYER::BOTH query walks two views
+    const auto near = [&types](Entity* entity)
+    {
+        const auto [x, y] = entity->position();
+        return std::sqrt(std::pow(40.0f - x, 2.0f) + std::pow(60.0f - y, 2.0f)) < 30.0f && types.contains(entity->type->id);
+    };
+    const auto overlapping = [](Entity* entity)
+    {
+        return entity->overlaps_with(AABB{10.0f, 100.0f, 70.0f, 20.0f});
+    };
+    const MaskedEntityView views[]{entities_by_mask(synthetic.layer.get(), 0), entities_by_mask(synthetic.layer.get(), 0x7)};
+    const std::vector<uint32_t> expected_near = sequential_uids(views, near);
+    const std::vector<uint32_t> expected_overlapping = sequential_uids(views, overlapping);
+
+    g_parallel_entity_queries = true;
+    std::printf("%u hardware threads, %zu list entries walked per query\n", std::thread::hardware_concurrency(), views[0].size_upper_bound() + views[1].size_upper_bound());
+    double sequential_time = 0.0;
+    for (size_t threads = 1; threads <= max_threads; ++threads)
+    {
+        WorkerPool pool{threads - 1};
+        CHECK(collect_entity_uids(views, near, pool) == expected_near);
+        CHECK(collect_entity_uids(views, overlapping, pool) == expected_overlapping);
+
+        constexpr int c_queries = 300;
+        size_t found = 0;
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < c_queries; ++i)
+        {
+            found += collect_entity_uids(views, near, pool).size() + collect_entity_uids(views, overlapping, pool).size();
+        }
+        const double time = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / (2 * c_queries);
+        if (threads == 1)
+        {
+            sequential_time = time;
+        }
+        std::printf("%zu threads: %.1f us per query, %.2fx (%zu found)\n", threads, time, sequential_time / time, found);
+    }
+    return 0;
+}
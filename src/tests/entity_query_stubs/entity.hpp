@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint> // for uint32_t
+#include <utility> // for pair
+
+#include "entity_db.hpp" // for EntityDB
+#include "math.hpp"      // for AABB
+
+// Host stand-in for the game's Entity, only what entity_query.hpp and the bench predicates use, with the same overlap test
+class Entity
+{
+  public:
+    EntityDB* type;
+    uint32_t uid;
+    float x;
+    float y;
+    float hitboxx;
+    float hitboxy;
+
+    std::pair<float, float> position()
+    {
+        return {x, y};
+    }
+    bool overlaps_with(AABB hitbox)
+    {
+        return x - hitboxx < hitbox.right && hitbox.left < x + hitboxx && y - hitboxy < hitbox.top && hitbox.bottom < y + hitboxy;
+    }
+};
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint> // for uint32_t
+
+#include "aliases.hpp" // for ENT_TYPE
+
+// Host stand-in for the game's EntityDB, only the fields entity_query.hpp reads
+struct EntityDB
+{
+    ENT_TYPE id;
+    uint32_t search_flags;
+};
@@ -0,0 +1,92 @@
+#include <algorithm> // for min
+#include <chrono>    // for nanoseconds
+#include <cstdint>   // for uint32_t
+#include <cstdio>    // for printf
+#include <cstdlib>   // for atoi
+#include <random>    // for mt19937, uniform_int_distribution
+#include <string>    // for string, to_string
+#include <vector>    // for vector
+
+#include "level_gen_replay.hpp" // for LevelGenReplayer, LevelGenReplayRules, LevelGenReplaySpawner
+#include "level_gen_trace.hpp"  // for LevelGenTrace
+
+// Replays a synthetic trace shaped like a level gen session against a stub spawner and reports the time per tile code.
+// Usage: level_gen_replay_bench [levels]
+
+namespace
+{
+// Every fourth community tile code waits for the tile above it, the bench places tiles bottom to top so those get resolved
+struct StubSpawner : LevelGenReplaySpawner
+{
+    uint32_t next_id{0};
+
+    void spawn_community_tile_code(LevelGenReplayer& replayer, std::string_view, std::string_view, float x, float y, uint8_t) override
+    {
+        if (next_id++ % 4 == 0)
+        {
+            replayer.add_pending_entity(next_id, {{x, y + 1.0f}});
+        }
+    }
+};
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const int levels = argc > 1 ? std::atoi(argv[1]) : 500;
+
+    // Roughly the amount of tile codes of a vanilla session, with a few hundred aliases and community tile codes on top
+    LevelGenReplayRules rules;
+    std::vector<std::string> tile_codes;
+    for (int i = 0; i < 600; ++i)
+    {
+        tile_codes.push_back("tile_code_" + std::to_string(i));
+        rules.tile_codes.insert(tile_codes.back());
+    }
+    for (int i = 0; i < 100; ++i)
+    {
+        rules.aliases.emplace(tile_codes[i], tile_codes[i + 300]);
+        rules.community_tile_codes.emplace(tile_codes[i + 500], "ENT_TYPE_" + std::to_string(i));
+    }
+
+    LevelGenTrace trace;
+    trace.names = tile_codes;
+    trace.names.push_back("room_template");
+    const auto room_template = static_cast<uint16_t>(trace.names.size() - 1);
+
+    // Mostly the same few tile codes over and over like floor and empty, with the rest spread thin
+    std::mt19937 rng{1234};
+    std::uniform_int_distribution<int> common{0, 9};
+    std::uniform_int_distribution<int> any{0, 599};
+    for (int level = 0; level < levels; ++level)
+    {
+        trace.records.push_back({.event = LevelGenTraceEvent::LevelBegin});
+        for (int y = 0; y < 40; ++y)
+        {
+            for (int x = 0; x < 80; ++x)
+            {
+                const int tile_code = common(rng) < 8 ? 300 + common(rng) : any(rng);
+                trace.records.push_back({.event = LevelGenTraceEvent::TileCode, .name_index = static_cast<uint16_t>(tile_code), .room_template_index = room_template, .x = static_cast<float>(x), .y = static_cast<float>(y)});
+            }
+        }
+    }
+
+    StubSpawner spawner;
+    LevelGenReplayer replayer{rules, spawner};
+    LevelGenReplayStats stats;
+    std::chrono::nanoseconds best_time{std::chrono::nanoseconds::max()};
+    for (int i = 0; i < 5; ++i)
+    {
+        stats = replayer.replay(trace);
+        best_time = std::min(best_time, stats.replay_time);
+    }
+
+    std::printf("%zu levels, %zu tile codes (%zu aliased, %zu community), %zu of %zu pending entities resolved\n",
+                stats.levels,
+                stats.tile_codes,
+                stats.aliased_tile_codes,
+                stats.community_tile_codes,
+                stats.resolved_pending_entities,
+                stats.pending_entities);
+    std::printf("best replay: %.3f ms, %.1f ns per tile code\n", best_time.count() / 1e6, static_cast<double>(best_time.count()) / stats.tile_codes);
+    return 0;
+}
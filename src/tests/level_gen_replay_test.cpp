@@ -0,0 +1,178 @@
+#include <cstdint>     // for uint8_t, uint16_t, uint32_t
+#include <cstdio>      // for printf
+#include <string>      // for string, to_string
+#include <string_view> // for string_view
+#include <vector>      // for vector
+
+#include "level_gen_replay.hpp" // for LevelGenReplayer, LevelGenReplayRules, LevelGenReplaySpawner
+#include "level_gen_trace.hpp"  // for LevelGenTrace
+#include "test_util.hpp"        // for CHECK
+
+namespace
+{
+struct TraceBuilder
+{
+    LevelGenTrace trace;
+
+    uint16_t name(std::string_view name)
+    {
+        for (uint16_t i = 0; i < trace.names.size(); ++i)
+        {
+            if (trace.names[i] == name)
+            {
+                return i;
+            }
+        }
+        trace.names.emplace_back(name);
+        return static_cast<uint16_t>(trace.names.size() - 1);
+    }
+    void level()
+    {
+        trace.records.push_back({.event = LevelGenTraceEvent::LevelBegin});
+    }
+    void tile_code(std::string_view tile_code, float x, float y)
+    {
+        trace.records.push_back({.event = LevelGenTraceEvent::TileCode, .name_index = name(tile_code), .room_template_index = name("side"), .x = x, .y = y});
+    }
+    void chance(std::string_view chance, bool result)
+    {
+        trace.records.push_back({.event = LevelGenTraceEvent::Chance, .name_index = name(chance), .result = result});
+    }
+};
+
+// Makes traps wait for the tile below them like the community totem trap does, and only lets them attach to floor
+struct StubSpawner : LevelGenReplaySpawner
+{
+    std::vector<std::string> spawned;
+    std::vector<std::string> floors;
+    std::vector<uint32_t> resolved;
+    uint32_t next_id{0};
+
+    static std::string key(std::string_view name, float x, float y)
+    {
+        return std::string{name} + "@" + std::to_string(static_cast<int>(x)) + "," + std::to_string(static_cast<int>(y));
+    }
+
+    void spawn_tile_code(LevelGenReplayer&, std::string_view tile_code, std::string_view room_template, float x, float y, uint8_t) override
+    {
+        CHECK(room_template == "side");
+        spawned.push_back(key(tile_code, x, y));
+        if (tile_code == "floor")
+        {
+            floors.push_back(key("", x, y));
+        }
+    }
+    void spawn_community_tile_code(LevelGenReplayer& replayer, std::string_view tile_code, std::string_view entity_type, float x, float y, uint8_t) override
+    {
+        spawned.push_back(key(entity_type, x, y));
+        if (tile_code == "totem_trap")
+        {
+            replayer.add_pending_entity(next_id++, {{x, y - 1.0f}});
+        }
+        else if (tile_code == "eggsac_left")
+        {
+            replayer.add_pending_entity(next_id++, {{x - 1.0f, y}, {x, y - 1.0f}});
+        }
+    }
+    bool resolve_pending_entity(uint32_t id, float x, float y, uint8_t) override
+    {
+        for (const std::string& floor : floors)
+        {
+            if (floor == key("", x, y))
+            {
+                resolved.push_back(id);
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+LevelGenReplayRules make_rules()
+{
+    LevelGenReplayRules rules;
+    rules.tile_codes = {"floor", "empty", "bone_key", "skeleton_key", "totem_trap", "trap_alias", "eggsac_left"};
+    rules.aliases = {{"skeleton_key", "bone_key"}, {"trap_alias", "totem_trap"}};
+    rules.community_tile_codes = {{"totem_trap", "ENT_TYPE_FLOOR_TOTEM_TRAP"}, {"eggsac_left", "ENT_TYPE_ITEM_EGGSAC"}};
+    return rules;
+}
+
+void test_resolution()
+{
+    TraceBuilder builder;
+    builder.level();
+    builder.tile_code("skeleton_key", 3, 3);
+    builder.tile_code("trap_alias", 7, 7);
+    builder.tile_code("mystery", 1, 1);
+    builder.chance("arrowtrap_chance", true);
+    builder.chance("arrowtrap_chance", false);
+
+    const LevelGenReplayRules rules = make_rules();
+    StubSpawner spawner;
+    const LevelGenReplayStats stats = LevelGenReplayer{rules, spawner}.replay(builder.trace);
+
+    CHECK(stats.levels == 1);
+    CHECK(stats.tile_codes == 3);
+    CHECK(stats.aliased_tile_codes == 2);
+    CHECK(stats.community_tile_codes == 1);
+    CHECK(stats.unknown_tile_codes == 1);
+    CHECK(stats.chance_rolls == 2);
+    CHECK(stats.successful_chance_rolls == 1);
+    CHECK((spawner.spawned == std::vector<std::string>{"bone_key@3,3", "ENT_TYPE_FLOOR_TOTEM_TRAP@7,7"}));
+}
+
+void test_pending_entities()
+{
+    TraceBuilder builder;
+    builder.level();
+    // Waits for the floor below, which comes later
+    builder.tile_code("totem_trap", 5, 5);
+    builder.tile_code("floor", 4, 4);
+    builder.tile_code("floor", 5, 4);
+    // The first neighbour is empty, so it stays pending until the tile below it is floor
+    builder.tile_code("eggsac_left", 10, 10);
+    builder.tile_code("empty", 9, 10);
+    builder.tile_code("floor", 10, 9);
+    // Never gets its floor in this level, and must not pick up the one in the next level
+    builder.tile_code("totem_trap", 20, 20);
+    builder.level();
+    builder.tile_code("floor", 20, 19);
+
+    const LevelGenReplayRules rules = make_rules();
+    StubSpawner spawner;
+    const LevelGenReplayStats stats = LevelGenReplayer{rules, spawner}.replay(builder.trace);
+
+    CHECK(stats.levels == 2);
+    CHECK(stats.pending_entities == 3);
+    CHECK(stats.resolved_pending_entities == 2);
+    CHECK((spawner.resolved == std::vector<uint32_t>{0, 1}));
+}
+
+void test_replays_are_independent()
+{
+    TraceBuilder builder;
+    builder.tile_code("totem_trap", 5, 5);
+
+    const LevelGenReplayRules rules = make_rules();
+    StubSpawner spawner;
+    LevelGenReplayer replayer{rules, spawner};
+    replayer.replay(builder.trace);
+
+    TraceBuilder floor_only;
+    floor_only.tile_code("floor", 5, 4);
+    const LevelGenReplayStats stats = replayer.replay(floor_only.trace);
+    CHECK(stats.tile_codes == 1);
+    CHECK(stats.pending_entities == 0);
+    CHECK(stats.resolved_pending_entities == 0);
+    CHECK(spawner.resolved.empty());
+}
+} // namespace
+
+int main()
+{
+    test_resolution();
+    test_pending_entities();
+    test_replays_are_independent();
+    std::printf("level_gen_replay_test passed\n");
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include <cstddef>    // for offsetof, size_t
+#include <cstdint>    // for uint32_t, int32_t, uint8_t, int64_t
+#include <cstdio>     // for printf
+#include <cstring>    // for memcmp
+#include <new>        // for operator new
+#include <sys/mman.h> // for mmap, munmap, MAP_SHARED, MAP_ANONYMOUS
+#include <sys/wait.h> // for waitpid, WIFEXITED, WEXITSTATUS
+#include <unistd.h>   // for fork, _exit
+
+#include "telemetry.hpp" // for TelemetrySegment, TelemetryData, telemetry_write, telemetry_try_read
+#include "test_util.hpp" // for CHECK
+
+namespace
+{
+constexpr uint32_t c_stress_frames{200000};
+
+// Every field is derived from the frame, so a torn read shows up as fields that don't agree with each other
+TelemetryData make_data(uint32_t frame)
+{
+    TelemetryData data{};
+    data.frame = frame;
+    data.screen = frame * 3;
+    data.world = static_cast<uint8_t>(frame);
+    data.level = static_cast<uint8_t>(frame >> 8);
+    data.time_level = frame * 5;
+    data.time_total = frame * 7;
+    data.time_last_level = ~frame;
+    data.seed = frame ^ 0x9e3779b9;
+    data.player_count = static_cast<uint8_t>(frame % 5);
+    for (uint32_t i = 0; i < 4; ++i)
+    {
+        data.players[i].uid = static_cast<int32_t>(frame + i);
+        data.players[i].x = static_cast<float>(frame % 0x10000);
+        data.players[i].y = static_cast<float>(i);
+        data.players[i].holding_uid = -static_cast<int32_t>(frame);
+    }
+    for (uint32_t i = 0; i < 20; ++i)
+    {
+        data.prng[i] = static_cast<int64_t>(frame) * (i + 1);
+    }
+    data.entity_count[0] = frame;
+    data.entity_count[1] = ~frame;
+    return data;
+}
+
+TelemetrySegment* map_segment()
+{
+    void* memory = mmap(nullptr, sizeof(TelemetrySegment), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    CHECK(memory != MAP_FAILED);
+    TelemetrySegment* segment = new (memory) TelemetrySegment{};
+    segment->magic = g_telemetry_magic;
+    segment->version = g_telemetry_version;
+    segment->data_size = sizeof(TelemetryData);
+    return segment;
+}
+
+void test_rejects_incompatible_segments()
+{
+    TelemetrySegment* segment = map_segment();
+    telemetry_write(*segment, make_data(1));
+    TelemetryData data;
+
+    segment->magic = 0;
+    CHECK(telemetry_try_read(*segment, data) == TelemetryReadResult::Incompatible);
+    segment->magic = g_telemetry_magic;
+    segment->version = g_telemetry_version + 1;
+    CHECK(telemetry_try_read(*segment, data) == TelemetryReadResult::Incompatible);
+    segment->version = g_telemetry_version;
+
+    segment->sequence.fetch_add(1);
+    CHECK(telemetry_try_read(*segment, data) == TelemetryReadResult::Busy);
+    segment->sequence.fetch_add(1);
+    CHECK(telemetry_try_read(*segment, data) == TelemetryReadResult::Ok);
+    CHECK(std::memcmp(&data, &segment->data, sizeof(TelemetryData)) == 0);
+
+    munmap(segment, sizeof(TelemetrySegment));
+}
+
+void test_older_writer()
+{
+    // A writer from before entity_count was added, its segment ends right where that field would start
+    TelemetrySegment* segment = map_segment();
+    segment->data_size = offsetof(TelemetryData, entity_count);
+    telemetry_write(*segment, make_data(42));
+
+    TelemetryData data = make_data(7);
+    CHECK(telemetry_try_read(*segment, data) == TelemetryReadResult::Ok);
+    CHECK(data.frame == 42);
+    CHECK(data.prng[19] == 42 * 20);
+    CHECK(data.entity_count[0] == 0 && data.entity_count[1] == 0);
+
+    munmap(segment, sizeof(TelemetrySegment));
+}
+
+// The writer runs in a child process that shares the segment through an anonymous mapping, like an overlay reading from the game
+void test_concurrent_reader()
+{
+    TelemetrySegment* segment = map_segment();
+    // Otherwise the reader may see the empty segment before the writer got going
+    telemetry_write(*segment, make_data(0));
+
+    const pid_t writer = fork();
+    CHECK(writer >= 0);
+    if (writer == 0)
+    {
+        for (uint32_t frame = 1; frame <= c_stress_frames; ++frame)
+        {
+            telemetry_write(*segment, make_data(frame));
+        }
+        _exit(0);
+    }
+
+    uint32_t last_frame = 0;
+    uint64_t reads = 0;
+    uint64_t busy = 0;
+    while (last_frame != c_stress_frames)
+    {
+        TelemetryData data;
+        const TelemetryReadResult result = telemetry_try_read(*segment, data);
+        CHECK(result != TelemetryReadResult::Incompatible);
+        if (result == TelemetryReadResult::Busy)
+        {
+            busy++;
+            continue;
+        }
+
+        const TelemetryData expected = make_data(data.frame);
+        CHECK(std::memcmp(&data, &expected, sizeof(TelemetryData)) == 0);
+        CHECK(data.frame >= last_frame);
+        last_frame = data.frame;
+        reads++;
+    }
+
+    int status = 0;
+    CHECK(waitpid(writer, &status, 0) == writer);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    std::printf("%llu consistent reads, %llu retries\n", static_cast<unsigned long long>(reads), static_cast<unsigned long long>(busy));
+
+    munmap(segment, sizeof(TelemetrySegment));
+}
+} // namespace
+
+int main()
+{
+    test_rejects_incompatible_segments();
+    test_older_writer();
+    test_concurrent_reader();
+    std::printf("telemetry_test passed\n");
+    return 0;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdio>  // for fprintf, stderr
+#include <cstdlib> // for exit
+
+// Stops the test with a message pointing at the failed check, works the same in release builds unlike assert
+#define CHECK(condition)                                                                       \
+    do                                                                                         \
+    {                                                                                          \
+        if (!(condition))                                                                      \
+        {                                                                                      \
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            std::exit(1);                                                                      \
+        }                                                                                      \
+    } while (false)
@@ -0,0 +1,171 @@
+#include <cstddef>    // for byte, size_t
+#include <cstdint>    // for uint8_t, uint16_t, uint32_t, int16_t
+#include <cstdio>     // for remove, printf
+#include <cstring>    // for memcpy, memcmp
+#include <filesystem> // for temp_directory_path
+#include <fstream>    // for ofstream
+#include <string>     // for string
+#include <vector>     // for vector
+
+#include "test_util.hpp"       // for CHECK
+#include "wav_file_stream.hpp" // for WavFileStream
+
+namespace
+{
+template <class T>
+void append(std::vector<char>& out, T value)
+{
+    const size_t offset = out.size();
+    out.resize(offset + sizeof(T));
+    std::memcpy(out.data() + offset, &value, sizeof(T));
+}
+void append_id(std::vector<char>& out, const char (&id)[5])
+{
+    out.insert(out.end(), id, id + 4);
+}
+
+// `declared_data_size` lets a test claim a longer data chunk than the file actually has
+std::string write_wav(const char* name, uint16_t bits_per_sample, uint16_t num_channels, const std::vector<uint8_t>& pcm, uint32_t declared_data_size)
+{
+    std::vector<char> file;
+    append_id(file, "RIFF");
+    append<uint32_t>(file, 0);
+    append_id(file, "WAVE");
+
+    // An unknown chunk with an odd size in front, which has to be skipped including its pad byte
+    append_id(file, "junk");
+    append<uint32_t>(file, 3);
+    file.insert(file.end(), {'a', 'b', 'c', '\0'});
+
+    append_id(file, "fmt ");
+    append<uint32_t>(file, 16);
+    append<uint16_t>(file, 1);
+    append<uint16_t>(file, num_channels);
+    append<uint32_t>(file, 44100);
+    append<uint32_t>(file, 44100u * num_channels * bits_per_sample / 8);
+    append<uint16_t>(file, static_cast<uint16_t>(num_channels * bits_per_sample / 8));
+    append<uint16_t>(file, bits_per_sample);
+
+    append_id(file, "data");
+    append<uint32_t>(file, declared_data_size);
+    file.insert(file.end(), pcm.begin(), pcm.end());
+
+    const uint32_t riff_size = static_cast<uint32_t>(file.size() - 8);
+    std::memcpy(file.data() + 4, &riff_size, 4);
+
+    const std::string path = (std::filesystem::temp_directory_path() / name).string();
+    std::ofstream{path, std::ios::binary}.write(file.data(), static_cast<std::streamsize>(file.size()));
+    return path;
+}
+
+std::vector<uint8_t> make_pcm(size_t size)
+{
+    std::vector<uint8_t> pcm(size);
+    for (size_t i = 0; i < size; ++i)
+    {
+        pcm[i] = static_cast<uint8_t>(i * 7 + i / 251);
+    }
+    return pcm;
+}
+
+std::vector<uint8_t> read_all(WavFileStream& stream, size_t chunk_size)
+{
+    std::vector<uint8_t> out;
+    std::vector<std::byte> chunk(chunk_size);
+    while (const size_t read = stream.read(chunk.data(), chunk_size))
+    {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(chunk.data());
+        out.insert(out.end(), bytes, bytes + read);
+    }
+    return out;
+}
+
+void test_chunked_reads()
+{
+    const std::vector<uint8_t> pcm = make_pcm(44100 * 4 + 12);
+    const std::string path = write_wav("ol_wav_chunks.wav", 16, 2, pcm, static_cast<uint32_t>(pcm.size()));
+
+    for (size_t chunk_size : {1u, 3u, 4096u, 65536u, 1u << 20})
+    {
+        auto stream = WavFileStream::open(path.c_str());
+        CHECK(stream != nullptr);
+        CHECK(stream->num_channels() == 2);
+        CHECK(stream->frequency() == 44100);
+        CHECK(stream->format() == SoundFormat::PCM_16);
+        CHECK(stream->frame_size() == 4);
+        CHECK(stream->data_size() == pcm.size());
+        CHECK(read_all(*stream, chunk_size) == pcm);
+    }
+    std::remove(path.c_str());
+}
+
+void test_seek()
+{
+    const std::vector<uint8_t> pcm = make_pcm(4 * 1000);
+    const std::string path = write_wav("ol_wav_seek.wav", 16, 2, pcm, static_cast<uint32_t>(pcm.size()));
+    auto stream = WavFileStream::open(path.c_str());
+    CHECK(stream != nullptr);
+
+    std::byte sample[4];
+    CHECK(stream->seek(500));
+    CHECK(stream->read(sample, 4) == 4);
+    CHECK(std::memcmp(sample, pcm.data() + 2000, 4) == 0);
+
+    // Seeking backwards after reading to the end, like Fmod does when a stream loops
+    read_all(*stream, 333);
+    CHECK(stream->seek(0));
+    CHECK(read_all(*stream, 333) == pcm);
+
+    // The end itself is a valid position that reads nothing, anything past it is not
+    CHECK(stream->seek(1000));
+    CHECK(stream->read(sample, 4) == 0);
+    CHECK(!stream->seek(1001));
+
+    std::remove(path.c_str());
+}
+
+void test_truncated_data_chunk()
+{
+    const std::vector<uint8_t> pcm = make_pcm(4 * 100);
+    const std::string path = write_wav("ol_wav_truncated.wav", 16, 2, pcm, 0xFFFFFFFF);
+    auto stream = WavFileStream::open(path.c_str());
+    CHECK(stream != nullptr);
+    CHECK(stream->data_size() == pcm.size());
+    CHECK(read_all(*stream, 64) == pcm);
+    CHECK(stream->seek(100));
+    CHECK(!stream->seek(101));
+    std::remove(path.c_str());
+}
+
+void test_pcm8_is_signed()
+{
+    const std::vector<uint8_t> pcm{0x00, 0x80, 0xff, 0x7f};
+    const std::string path = write_wav("ol_wav_pcm8.wav", 8, 1, pcm, static_cast<uint32_t>(pcm.size()));
+    auto stream = WavFileStream::open(path.c_str());
+    CHECK(stream != nullptr);
+    CHECK(stream->format() == SoundFormat::PCM_8);
+    CHECK((read_all(*stream, 4) == std::vector<uint8_t>{0x80, 0x00, 0x7f, 0xff}));
+    std::remove(path.c_str());
+}
+
+void test_rejects_other_files()
+{
+    const std::string path = (std::filesystem::temp_directory_path() / "ol_wav_garbage.wav").string();
+    std::ofstream{path, std::ios::binary} << "RIFX this is not a wav file";
+    CHECK(WavFileStream::open(path.c_str()) == nullptr);
+    std::remove(path.c_str());
+
+    CHECK(WavFileStream::open("this file does not exist.wav") == nullptr);
+}
+} // namespace
+
+int main()
+{
+    test_chunked_reads();
+    test_seek();
+    test_truncated_data_chunk();
+    test_pcm8_is_signed();
+    test_rejects_other_files();
+    std::printf("wav_file_stream_test passed\n");
+    return 0;
+}